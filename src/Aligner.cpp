@@ -4,7 +4,10 @@
 #include <functional>
 #include <algorithm>
 #include <thread>
-#include <concurrentqueue.h> //https://github.com/cameron314/concurrentqueue
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <stdexcept>
 #include <google/protobuf/util/json_util.h>
 #include "Aligner.h"
 #include "CommonUtils.h"
@@ -17,7 +20,138 @@
 #include "MummerSeeder.h"
 #include "ReadCorrection.h"
 #include "MinimizerSeeder.h"
+#include "KmerHashKernel.h"
+#include "BlockingQueue.h"
+#include "OutputScheduler.h"
 #include "AlignmentSelection.h"
+#include "AlignerCounters.h"
+
+//reads are handed from the reader to the workers in batches, and the batches are recycled
+//the reads point into the shared input buffers so a batch holds no strings of its own
+//a batch is also sent once it has ReadBatchBases of sequence so long reads are spread over the threads
+const size_t ReadBatchSize = 64;
+const size_t ReadBatchBases = 100000;
+//read batches per worker thread the scheduler looks ahead when picking the next batch.
+//this also bounds how far ahead of the input order the workers get, which has to stay below the reorder window of the ordered output
+const size_t ReadLookaheadPerThread = 4;
+//bgzf decompression threads shared by the input files
+const size_t MaxDecompressionThreads = 4;
+
+//batches are numbered in the order they are sent, with --ordered-output the output is written in that order
+struct ReadBatch
+{
+	std::vector<FastQView> reads;
+	size_t bases;
+	size_t sequence;
+};
+
+//hands read batches to the workers, the batch with the most sequence in the lookahead window first.
+//alignment time grows with read length, so long reads are started early instead of being picked up last and keeping one thread busy after the others are done
+//a batch is sent anyway once lookahead newer batches have come in so short reads don't wait indefinitely
+//after the input ends, a batch is split in half whenever other workers are idle
+class ReadBatchScheduler
+{
+public:
+	ReadBatchScheduler(size_t lookahead, bool splitAtEnd) :
+	batches(),
+	lookahead(lookahead),
+	splitAtEnd(splitAtEnd),
+	newestSequence(0),
+	closed(false),
+	waitingConsumers(0)
+	{
+		assert(lookahead > 0);
+	}
+	ReadBatchScheduler(const ReadBatchScheduler& other) = delete;
+	ReadBatchScheduler& operator=(const ReadBatchScheduler& other) = delete;
+	bool push(std::unique_ptr<ReadBatch>& batch)
+	{
+		std::unique_lock<std::mutex> lock { mutex };
+		notFull.wait(lock, [this]() { return closed || batches.size() < lookahead; });
+		if (closed) return false;
+		newestSequence = std::max(newestSequence, batch->sequence);
+		batches.push_back(std::move(batch));
+		lock.unlock();
+		notEmpty.notify_one();
+		return true;
+	}
+	bool pop(std::unique_ptr<ReadBatch>& result)
+	{
+		std::unique_lock<std::mutex> lock { mutex };
+		if (!closed && batches.size() == 0)
+		{
+			waitingConsumers += 1;
+			notEmpty.wait(lock, [this]() { return closed || batches.size() > 0; });
+			waitingConsumers -= 1;
+		}
+		if (batches.size() == 0) return false;
+		size_t index = pickNext();
+		result = std::move(batches[index]);
+		batches.erase(batches.begin() + index);
+		bool split = false;
+		if (splitAtEnd && closed && waitingConsumers > 0 && result->reads.size() >= 2)
+		{
+			batches.push_back(splitHalf(*result));
+			split = true;
+		}
+		lock.unlock();
+		notFull.notify_one();
+		if (split) notEmpty.notify_one();
+		return true;
+	}
+	void close()
+	{
+		{
+			std::lock_guard<std::mutex> lock { mutex };
+			closed = true;
+		}
+		notEmpty.notify_all();
+		notFull.notify_all();
+	}
+	bool hasWaitingConsumers() const
+	{
+		return waitingConsumers > 0;
+	}
+private:
+	size_t pickNext() const
+	{
+		assert(batches.size() > 0);
+		size_t oldest = 0;
+		size_t largest = 0;
+		for (size_t i = 1; i < batches.size(); i++)
+		{
+			if (batches[i]->sequence < batches[oldest]->sequence) oldest = i;
+			if (batches[i]->bases > batches[largest]->bases) largest = i;
+		}
+		if (newestSequence >= batches[oldest]->sequence + lookahead) return oldest;
+		return largest;
+	}
+	std::unique_ptr<ReadBatch> splitHalf(ReadBatch& batch) const
+	{
+		assert(batch.reads.size() >= 2);
+		auto result = std::make_unique<ReadBatch>();
+		result->sequence = batch.sequence;
+		result->bases = 0;
+		size_t target = batch.bases / 2;
+		while (batch.reads.size() > 1 && (result->reads.size() == 0 || result->bases + batch.reads.back().sequence.size() <= target))
+		{
+			result->bases += batch.reads.back().sequence.size();
+			batch.bases -= batch.reads.back().sequence.size();
+			result->reads.push_back(std::move(batch.reads.back()));
+			batch.reads.pop_back();
+		}
+		return result;
+	}
+	std::vector<std::unique_ptr<ReadBatch>> batches;
+	size_t lookahead;
+	bool splitAtEnd;
+	size_t newestSequence;
+	bool closed;
+	std::atomic<size_t> waitingConsumers;
+	std::mutex mutex;
+	std::condition_variable notEmpty;
+	std::condition_variable notFull;
+};
 
 struct Seeder
 {
@@ -31,6 +165,7 @@ struct Seeder
 	size_t mxmLength;
 	size_t minimizerLength;
 	size_t minimizerWindowSize;
+	size_t minimizerSyncmerLength;
 	double minimizerSeedDensity;
 	const MummerSeeder* mummerSeeder;
 	const MinimizerSeeder* minimizerSeeder;
@@ -41,6 +176,7 @@ struct Seeder
 		mxmLength(params.mxmLength),
 		minimizerLength(params.minimizerLength),
 		minimizerWindowSize(params.minimizerWindowSize),
+		minimizerSyncmerLength(params.minimizerSyncmerLength),
 		minimizerSeedDensity(params.minimizerSeedDensity),
 		mummerSeeder(mummerSeeder),
 		minimizerSeeder(minimizerSeeder),
@@ -82,20 +218,20 @@ struct Seeder
 			}
 		}
 	}
-	std::vector<SeedHit> getSeeds(const std::string& seqName, const std::string& seq) const
+	std::vector<SeedHit> getSeeds(const std::string_view& seqName, const std::string_view& seq) const
 	{
 		switch(mode)
 		{
 			case Mode::File:
 				assert(fileSeeds != nullptr);
-				if (fileSeeds->count(seqName) == 0) return std::vector<SeedHit>{};
-				return fileSeeds->at(seqName);
+				if (fileSeeds->count(std::string { seqName }) == 0) return std::vector<SeedHit>{};
+				return fileSeeds->at(std::string { seqName });
 			case Mode::Mum:
 				assert(mummerSeeder != nullptr);
-				return mummerSeeder->getMumSeeds(seq, mumCount, mxmLength);
+				return mummerSeeder->getMumSeeds(std::string { seq }, mumCount, mxmLength);
 			case Mode::Mem:
 				assert(mummerSeeder != nullptr);
-				return mummerSeeder->getMemSeeds(seq, memCount, mxmLength);
+				return mummerSeeder->getMemSeeds(std::string { seq }, memCount, mxmLength);
 			case Mode::Minimizer:
 				assert(minimizerSeeder != nullptr);
 				return minimizerSeeder->getSeeds(seq, minimizerSeedDensity);
@@ -122,7 +258,9 @@ struct AlignmentStats
 	bpInAlignments(0),
 	bpInFullAlignments(0),
 	allAlignmentsCount(0),
-	assertionBroke(false)
+	assertionBroke(false),
+	countersMutex(),
+	counters()
 	{
 	}
 	std::atomic<size_t> reads;
@@ -139,6 +277,9 @@ struct AlignmentStats
 	std::atomic<size_t> bpInFullAlignments;
 	std::atomic<size_t> allAlignmentsCount;
 	std::atomic<bool> assertionBroke;
+	//the threads add their counters once they finish
+	std::mutex countersMutex;
+	AlignerCounters counters;
 };
 
 bool is_file_exist(std::string fileName)
@@ -162,160 +303,122 @@ void replaceDigraphNodeIdsWithOriginalNodeIds(vg::Alignment& alignment, const Al
 	}
 }
 
-void readFastqs(const std::vector<std::string>& filenames, moodycamel::ConcurrentQueue<std::shared_ptr<FastQ>>& writequeue, std::atomic<bool>& readStreamingFinished)
+void readFastqFile(const std::string& filename, size_t decompressionThreads, ReadBatchScheduler& writequeue, BlockingQueue<std::unique_ptr<ReadBatch>>& batchPool, std::atomic<size_t>& nextSequence)
 {
 	assertSetNoRead("Read streamer");
-	for (auto filename : filenames)
+	std::unique_ptr<ReadBatch> batch;
+	FastQView::streamFromFile(filename, false, [&writequeue, &batchPool, &batch, &nextSequence](FastQView& read)
 	{
-		FastQ::streamFastqFromFile(filename, false, [&writequeue](FastQ& read)
+		if (batch == nullptr)
 		{
-			std::shared_ptr<FastQ> ptr = std::make_shared<FastQ>();
-			std::swap(*ptr, read);
-			size_t slept = 0;
-			while (writequeue.size_approx() > 200)
-			{
-				std::this_thread::sleep_for(std::chrono::milliseconds(10));
-				slept++;
-				if (slept > 100) break;
-			}
-			writequeue.enqueue(ptr);
-		});
+			if (!batchPool.tryPop(batch)) batch = std::make_unique<ReadBatch>();
+			assert(batch->reads.size() == 0);
+			batch->bases = 0;
+		}
+		batch->reads.push_back(std::move(read));
+		batch->bases += batch->reads.back().sequence.size();
+		//send partial batches when workers are idle so small inputs don't wait for a full batch
+		if (batch->reads.size() == ReadBatchSize || batch->bases >= ReadBatchBases || writequeue.hasWaitingConsumers())
+		{
+			batch->sequence = nextSequence++;
+			writequeue.push(batch);
+			batch = nullptr;
+		}
+	}, decompressionThreads);
+	if (batch != nullptr && batch->reads.size() > 0)
+	{
+		batch->sequence = nextSequence++;
+		writequeue.push(batch);
 	}
-	readStreamingFinished = true;
 }
 
-void consumeBytesAndWrite(const std::string& filename, moodycamel::ConcurrentQueue<std::string*>& writequeue, moodycamel::ConcurrentQueue<std::string*>& deallocqueue, std::atomic<bool>& allThreadsDone, std::atomic<bool>& allWriteDone, bool verboseMode, bool textMode)
+//input files are read concurrently, each with its own parser thread
+//for ordered output the files are read one after another so the batch numbers follow the input order
+void readFastqs(const std::vector<std::string>& filenames, size_t decompressionThreads, bool ordered, ReadBatchScheduler& writequeue, BlockingQueue<std::unique_ptr<ReadBatch>>& batchPool)
 {
-	assertSetNoRead("Writer");
-	auto openmode = std::ios::out;
-	if (!textMode) openmode |= std::ios::binary;
-	std::ofstream outfile { filename, openmode };
-
-	bool wroteAny = false;
-
-	std::string* alns[100] {};
-
-	BufferedWriter coutoutput;
-	if (verboseMode)
+	std::atomic<size_t> nextSequence { 0 };
+	if (ordered)
 	{
-		coutoutput = {std::cout};
-	}
-
-	while (true)
-	{
-		size_t gotAlns = writequeue.try_dequeue_bulk(alns, 100);
-		if (gotAlns == 0)
+		for (const auto& filename : filenames)
 		{
-			if (!writequeue.try_dequeue(alns[0]))
-			{
-				if (allThreadsDone) break;
-				std::this_thread::sleep_for(std::chrono::milliseconds(10));
-				continue;
-			}
-			gotAlns = 1;
-		}
-		coutoutput << "write " << gotAlns << ", " << writequeue.size_approx() << " left" << BufferedWriter::Flush;
-		for (size_t i = 0; i < gotAlns; i++)
-		{
-			outfile.write(alns[i]->data(), alns[i]->size());
+			readFastqFile(filename, decompressionThreads, writequeue, batchPool, nextSequence);
 		}
-		deallocqueue.enqueue_bulk(alns, gotAlns);
-		wroteAny = true;
+		writequeue.close();
+		return;
 	}
-
-	if (!textMode && !wroteAny)
+	size_t threadsPerFile = std::max((size_t)1, decompressionThreads / std::max((size_t)1, filenames.size()));
+	std::vector<std::thread> readerThreads;
+	for (const auto& filename : filenames)
 	{
-		::google::protobuf::io::ZeroCopyOutputStream *raw_out =
-		      new ::google::protobuf::io::OstreamOutputStream(&outfile);
-		::google::protobuf::io::GzipOutputStream *gzip_out =
-		      new ::google::protobuf::io::GzipOutputStream(raw_out);
-		::google::protobuf::io::CodedOutputStream *coded_out =
-		      new ::google::protobuf::io::CodedOutputStream(gzip_out);
-		coded_out->WriteVarint64(0);
-		delete coded_out;
-		delete gzip_out;
-		delete raw_out;
+		readerThreads.emplace_back([&filename, threadsPerFile, &writequeue, &batchPool, &nextSequence]() { readFastqFile(filename, threadsPerFile, writequeue, batchPool, nextSequence); });
 	}
-
-	allWriteDone = true;
+	for (auto& thread : readerThreads)
+	{
+		thread.join();
+	}
+	writequeue.close();
 }
 
-void QueueInsertSlowly(moodycamel::ProducerToken& token, moodycamel::ConcurrentQueue<std::string*>& queue, std::string&& str)
+//a GAM file with no alignments still has one empty group
+std::string emptyGAM()
 {
-	std::string* write = new std::string { std::move(str) };
-	size_t waited = 0;
-	while (!queue.try_enqueue(token, write) && !queue.try_enqueue(token, write))
+	std::string result;
 	{
-		if (queue.size_approx() < 100 && queue.enqueue(token, write)) break;
-		std::this_thread::sleep_for(std::chrono::milliseconds(10));
-		waited++;
-		if (waited >= 10)
-		{
-			if (queue.enqueue(token, write)) break;
-		}
+		::google::protobuf::io::StringOutputStream raw_out { &result };
+		::google::protobuf::io::GzipOutputStream gzip_out { &raw_out };
+		::google::protobuf::io::CodedOutputStream coded_out { &gzip_out };
+		coded_out.WriteVarint64(0);
 	}
+	return result;
 }
 
-void writeGAMToQueue(moodycamel::ProducerToken& token, const AlignerParams& params, moodycamel::ConcurrentQueue<std::string*>& alignmentsOut, const AlignmentResult& alignments)
+void writeGAMToBuffer(std::string& out, const AlignmentResult& alignments)
 {
-	std::stringstream strstr;
-	::google::protobuf::io::ZeroCopyOutputStream *raw_out = new ::google::protobuf::io::OstreamOutputStream(&strstr);
-	::google::protobuf::io::GzipOutputStream *gzip_out = new ::google::protobuf::io::GzipOutputStream(raw_out);
-	::google::protobuf::io::CodedOutputStream *coded_out = new ::google::protobuf::io::CodedOutputStream(gzip_out);
-	coded_out->WriteVarint64(alignments.alignments.size());
+	uint8_t varint[10];
+	size_t varintSize = ::google::protobuf::io::CodedOutputStream::WriteVarint64ToArray(alignments.alignments.size(), varint) - varint;
+	out.append((const char*)varint, varintSize);
 	for (size_t i = 0; i < alignments.alignments.size(); i++)
 	{
 		assert(!alignments.alignments[i].alignmentFailed());
 		assert(alignments.alignments[i].alignment != nullptr);
-		std::string s;
-		alignments.alignments[i].alignment->SerializeToString(&s);
-		coded_out->WriteVarint32(s.size());
-		coded_out->WriteRaw(s.data(), s.size());
-	}
-	delete coded_out;
-	delete gzip_out;
-	delete raw_out;
-	QueueInsertSlowly(token, alignmentsOut, strstr.str());
+		size_t messageSize = alignments.alignments[i].alignment->ByteSizeLong();
+		varintSize = ::google::protobuf::io::CodedOutputStream::WriteVarint32ToArray(messageSize, varint) - varint;
+		out.append((const char*)varint, varintSize);
+		size_t messageStart = out.size();
+		out.resize(messageStart + messageSize);
+		alignments.alignments[i].alignment->SerializeWithCachedSizesToArray((uint8_t*)&out[messageStart]);
+	}
 }
 
-void writeJSONToQueue(moodycamel::ProducerToken& token, const AlignerParams& params, moodycamel::ConcurrentQueue<std::string*>& alignmentsOut, const AlignmentResult& alignments)
+void writeJSONToBuffer(std::string& out, std::string& json, const AlignmentResult& alignments)
 {
-	std::stringstream strstr;
 	google::protobuf::util::JsonPrintOptions options;
 	options.preserve_proto_field_names = true;
 	for (size_t i = 0; i < alignments.alignments.size(); i++)
 	{
 		assert(!alignments.alignments[i].alignmentFailed());
 		assert(alignments.alignments[i].alignment != nullptr);
-		std::string s;
-		google::protobuf::util::MessageToJsonString(*alignments.alignments[i].alignment, &s, options);
-		strstr << s;
-		strstr << '\n';
+		json.clear();
+		google::protobuf::util::MessageToJsonString(*alignments.alignments[i].alignment, &json, options);
+		out += json;
+		out += '\n';
 	}
-	QueueInsertSlowly(token, alignmentsOut, strstr.str());
 }
 
-void writeGAFToQueue(moodycamel::ProducerToken& token, const AlignerParams& params, moodycamel::ConcurrentQueue<std::string*>& alignmentsOut, const AlignmentResult& alignments)
+void writeGAFToBuffer(std::string& out, const AlignmentGraph& alignmentGraph, const AlignerParams& params, const std::string_view& seq_id, const std::string_view& sequence, const AlignmentResult& alignments)
 {
-	std::stringstream strstr;
 	for (size_t i = 0; i < alignments.alignments.size(); i++)
 	{
 		assert(!alignments.alignments[i].alignmentFailed());
-		assert(alignments.alignments[i].GAFline.size() > 0);
-		strstr << alignments.alignments[i].GAFline;
-		strstr << '\n';
+		size_t lineStart = out.size();
+		AddGAFLine(alignmentGraph, seq_id, sequence, alignments.alignments[i], params.cigarMatchMismatchMerge, out);
+		assert(out.size() > lineStart);
+		out += '\n';
 	}
-	QueueInsertSlowly(token, alignmentsOut, strstr.str());
 }
 
-void writeCorrectedToQueue(moodycamel::ProducerToken& token, const AlignerParams& params, const std::string& readName, const std::string& original, size_t maxOverlap, moodycamel::ConcurrentQueue<std::string*>& correctedOut, const AlignmentResult& alignments)
+void writeCorrectedToBuffer(std::string& out, const std::string_view& readName, const std::string_view& original, size_t maxOverlap, const AlignmentResult& alignments)
 {
-	std::stringstream strstr;
-	zstr::ostream *compressed;
-	if (params.compressCorrected)
-	{
-		compressed = new zstr::ostream(strstr);
-	}
 	std::vector<Correction> corrections;
 	for (size_t i = 0; i < alignments.alignments.size(); i++)
 	{
@@ -327,59 +430,65 @@ void writeCorrectedToQueue(moodycamel::ProducerToken& token, const AlignerParams
 		corrections.back().corrected = alignments.alignments[i].corrected;
 	}
 	std::string corrected = getCorrected(original, corrections, maxOverlap);
-	if (params.compressCorrected)
-	{
-		(*compressed) << ">" << readName << std::endl;
-		(*compressed) << corrected << std::endl;
-		delete compressed;
-	}
-	else
-	{
-		strstr << ">" << readName << std::endl;
-		strstr << corrected << std::endl;
-	}
-	QueueInsertSlowly(token, correctedOut, strstr.str());
+	out += '>';
+	out += readName;
+	out += '\n';
+	out += corrected;
+	out += '\n';
 }
 
-void writeCorrectedClippedToQueue(moodycamel::ProducerToken& token, const AlignerParams& params, moodycamel::ConcurrentQueue<std::string*>& correctedClippedOut, const AlignmentResult& alignments)
+void writeCorrectedClippedToBuffer(std::string& out, const AlignmentResult& alignments)
 {
-	std::stringstream strstr;
-	zstr::ostream *compressed;
-	if (params.compressClipped)
-	{
-		compressed = new zstr::ostream(strstr);
-	}
 	for (size_t i = 0; i < alignments.alignments.size(); i++)
 	{
 		assert(!alignments.alignments[i].alignmentFailed());
 		assert(alignments.alignments[i].corrected.size() > 0);
-		if (params.compressClipped)
-		{
-			(*compressed) << ">" << alignments.readName << "_" << i << "_" << alignments.alignments[i].alignmentStart << "_" << alignments.alignments[i].alignmentEnd << std::endl;
-			(*compressed) << alignments.alignments[i].corrected << std::endl;
-		}
-		else
-		{
-			strstr << ">" << alignments.readName << "_" << i << "_" << alignments.alignments[i].alignmentStart << "_" << alignments.alignments[i].alignmentEnd << std::endl;
-			strstr << alignments.alignments[i].corrected << std::endl;
-		}
-	}
-	if (params.compressClipped)
-	{
-		delete compressed;
+		out += '>';
+		out += alignments.readName;
+		out += '_';
+		out += std::to_string(i);
+		out += '_';
+		out += std::to_string(alignments.alignments[i].alignmentStart);
+		out += '_';
+		out += std::to_string(alignments.alignments[i].alignmentEnd);
+		out += '\n';
+		out += alignments.alignments[i].corrected;
+		out += '\n';
 	}
-	QueueInsertSlowly(token, correctedClippedOut, strstr.str());
 }
 
-void runComponentMappings(const AlignmentGraph& alignmentGraph, moodycamel::ConcurrentQueue<std::shared_ptr<FastQ>>& readFastqsQueue, std::atomic<bool>& readStreamingFinished, int threadnum, const Seeder& seeder, AlignerParams params, moodycamel::ConcurrentQueue<std::string*>& GAMOut, moodycamel::ConcurrentQueue<std::string*>& JSONOut, moodycamel::ConcurrentQueue<std::string*>& GAFOut, moodycamel::ConcurrentQueue<std::string*>& correctedOut, moodycamel::ConcurrentQueue<std::string*>& correctedClippedOut, moodycamel::ConcurrentQueue<std::string*>& deallocqueue, AlignmentStats& stats)
+void writeReadStatsToBuffer(std::string& out, const std::string_view& readName, size_t readLength, const AlignerCounters& counters)
 {
-	moodycamel::ProducerToken GAMToken { GAMOut };
-	moodycamel::ProducerToken JSONToken { JSONOut };
-	moodycamel::ProducerToken GAFToken { GAFOut };
-	moodycamel::ProducerToken correctedToken { correctedOut };
-	moodycamel::ProducerToken clippedToken { correctedClippedOut };
+	out += "{\"read\":";
+	appendJSONString(out, readName);
+	out += ",\"length\":" + std::to_string(readLength) + ",";
+	counters.writeJSONFields(out);
+	out += "}\n";
+}
+
+//the stream ids of the output files in the scheduler, NoStream for outputs that weren't asked for
+struct OutputStreams
+{
+	size_t GAM;
+	size_t JSON;
+	size_t GAF;
+	size_t corrected;
+	size_t correctedClipped;
+	size_t readStats;
+};
+
+template <typename Word>
+void runComponentMappings(const AlignmentGraph& alignmentGraph, ReadBatchScheduler& readFastqsQueue, BlockingQueue<std::unique_ptr<ReadBatch>>& readBatchPool, int threadnum, const Seeder& seeder, AlignerParams params, OutputScheduler& output, const OutputStreams& streams, typename GraphAlignerCommon<size_t, int32_t, Word>::ExtensionPool& extensionPool, AlignmentStats& stats)
+{
+	OutputBlockWriter GAMWriter { output, (size_t)threadnum, streams.GAM, true };
+	OutputBlockWriter JSONWriter { output, (size_t)threadnum, streams.JSON, false };
+	OutputBlockWriter GAFWriter { output, (size_t)threadnum, streams.GAF, false };
+	OutputBlockWriter correctedWriter { output, (size_t)threadnum, streams.corrected, params.compressCorrected };
+	OutputBlockWriter clippedWriter { output, (size_t)threadnum, streams.correctedClipped, params.compressClipped };
+	OutputBlockWriter readStatsWriter { output, (size_t)threadnum, streams.readStats, false };
+	std::string jsonBuffer;
 	assertSetNoRead("Before any read");
-	GraphAlignerCommon<size_t, int32_t, uint64_t>::AlignerGraphsizedState reusableState { alignmentGraph, std::max(params.initialBandwidth, params.rampBandwidth), !params.highMemory };
+	typename GraphAlignerCommon<size_t, int32_t, Word>::AlignerGraphsizedState reusableState { alignmentGraph, std::max(params.initialBandwidth, params.rampBandwidth), !params.highMemory };
 	AlignmentSelection::SelectionOptions selectionOptions;
 	selectionOptions.method = params.alignmentSelectionMethod;
 	selectionOptions.graphSize = alignmentGraph.SizeInBP();
@@ -400,21 +509,55 @@ void runComponentMappings(const AlignmentGraph& alignmentGraph, moodycamel::Conc
 		cerroutput = {std::cerr};
 		coutoutput = {std::cout};
 	}
+	std::unique_ptr<ReadBatch> batch;
+	size_t batchIndex = 0;
+	//the counters of a read are taken at the start of the next iteration, which every path out of the previous one goes through
+	const FastQView* countedRead = nullptr;
+	AlignerCounters threadCounters;
 	while (true)
 	{
-		std::string* dealloc;
-		while (deallocqueue.try_dequeue(dealloc))
+		if (countedRead != nullptr)
+		{
+			if (params.outputReadStatsFile != "") writeReadStatsToBuffer(readStatsWriter.buffer(), countedRead->seq_id, countedRead->sequence.size(), reusableState.counters);
+			threadCounters.add(reusableState.counters);
+			reusableState.counters.reset();
+			countedRead = nullptr;
+		}
+		//between reads so a block never has part of a read's output
+		if (!params.orderedOutput)
 		{
-			delete dealloc;
+			GAMWriter.flushIfFull();
+			JSONWriter.flushIfFull();
+			GAFWriter.flushIfFull();
+			correctedWriter.flushIfFull();
+			clippedWriter.flushIfFull();
+			readStatsWriter.flushIfFull();
 		}
-		std::shared_ptr<FastQ> fastq = nullptr;
-		while (fastq == nullptr && !readFastqsQueue.try_dequeue(fastq))
+		if (batch == nullptr || batchIndex == batch->reads.size())
 		{
-			bool tryBreaking = readStreamingFinished;
-			if (!readFastqsQueue.try_dequeue(fastq) && tryBreaking) break;
-			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			if (batch != nullptr)
+			{
+				//ordered output goes out in one block per file per batch
+				if (params.orderedOutput)
+				{
+					GAMWriter.flushOrdered(batch->sequence);
+					JSONWriter.flushOrdered(batch->sequence);
+					GAFWriter.flushOrdered(batch->sequence);
+					correctedWriter.flushOrdered(batch->sequence);
+					clippedWriter.flushOrdered(batch->sequence);
+					readStatsWriter.flushOrdered(batch->sequence);
+				}
+				//release the input buffers before the batch goes back to the pool
+				batch->reads.clear();
+				readBatchPool.tryPush(batch);
+			}
+			batch = nullptr;
+			if (!readFastqsQueue.pop(batch)) break;
+			batchIndex = 0;
 		}
-		if (fastq == nullptr) break;
+		const FastQView* fastq = &batch->reads[batchIndex];
+		batchIndex += 1;
+		countedRead = fastq;
 		assertSetNoRead(fastq->seq_id);
 		coutoutput << "Read " << fastq->seq_id << " size " << fastq->sequence.size() << "bp" << BufferedWriter::Flush;
 		selectionOptions.readSize = fastq->sequence.size();
@@ -434,6 +577,8 @@ void runComponentMappings(const AlignmentGraph& alignmentGraph, moodycamel::Conc
 				auto timeEnd = std::chrono::system_clock::now();
 				size_t time = std::chrono::duration_cast<std::chrono::milliseconds>(timeEnd - timeStart).count();
 				coutoutput << "Read " << fastq->seq_id << " seeding took " << time << "ms" << BufferedWriter::Flush;
+				reusableState.counters.seedingNs += std::chrono::duration_cast<std::chrono::nanoseconds>(timeEnd - timeStart).count();
+				reusableState.counters.seeds += seeds.size();
 				stats.seeds += seeds.size();
 				if (seeds.size() == 0)
 				{
@@ -441,7 +586,7 @@ void runComponentMappings(const AlignmentGraph& alignmentGraph, moodycamel::Conc
 					cerroutput << "Read " << fastq->seq_id << " has no seed hits" << BufferedWriter::Flush;
 					coutoutput << "Read " << fastq->seq_id << " alignment failed" << BufferedWriter::Flush;
 					cerroutput << "Read " << fastq->seq_id << " alignment failed" << BufferedWriter::Flush;
-					if (params.outputCorrectedFile != "") writeCorrectedToQueue(correctedToken, params, fastq->seq_id, fastq->sequence, alignmentGraph.getDBGoverlap(), correctedOut, alignments);
+					if (params.outputCorrectedFile != "") writeCorrectedToBuffer(correctedWriter.buffer(), fastq->seq_id, fastq->sequence, alignmentGraph.getDBGoverlap(), alignments);
 					continue;
 				}
 				stats.seedsFound += seeds.size();
@@ -452,24 +597,32 @@ void runComponentMappings(const AlignmentGraph& alignmentGraph, moodycamel::Conc
 				auto clusterTimeEnd = std::chrono::system_clock::now();
 				size_t clusterTime = std::chrono::duration_cast<std::chrono::milliseconds>(clusterTimeEnd - clusterTimeStart).count();
 				coutoutput << "Read " << fastq->seq_id << " clustering took " << clusterTime << "ms" << BufferedWriter::Flush;
+				reusableState.counters.clusteringNs += std::chrono::duration_cast<std::chrono::nanoseconds>(clusterTimeEnd - clusterTimeStart).count();
 				auto alntimeStart = std::chrono::system_clock::now();
-				alignments = AlignOneWay(alignmentGraph, fastq->seq_id, fastq->sequence, params.initialBandwidth, params.rampBandwidth, params.maxCellsPerSlice, !params.verboseMode, !params.tryAllSeeds, seeds, reusableState, !params.highMemory, params.forceGlobal, params.preciseClipping, params.seedClusterMinSize, params.seedExtendDensity, params.nondeterministicOptimizations, params.preciseClippingIdentityCutoff, params.Xdropcutoff);
+				alignments = AlignOneWay(alignmentGraph, fastq->seq_id, fastq->sequence, params.initialBandwidth, params.rampBandwidth, params.maxCellsPerSlice, !params.verboseMode, !params.tryAllSeeds, seeds, reusableState, !params.highMemory, params.forceGlobal, params.preciseClipping, params.seedClusterMinSize, params.seedExtendDensity, params.nondeterministicOptimizations, params.preciseClippingIdentityCutoff, params.Xdropcutoff, params.maxTraceMemory, &extensionPool);
 				auto alntimeEnd = std::chrono::system_clock::now();
 				alntimems = std::chrono::duration_cast<std::chrono::milliseconds>(alntimeEnd - alntimeStart).count();
+				reusableState.counters.extensionNs += std::chrono::duration_cast<std::chrono::nanoseconds>(alntimeEnd - alntimeStart).count();
 			}
 			else if (params.optimalDijkstra)
 			{
-				auto alntimeStart = std::chrono::system_clock::now();
-				alignments = AlignOneWayDijkstra(alignmentGraph, fastq->seq_id, fastq->sequence, !params.verboseMode, reusableState, params.forceGlobal, params.preciseClipping);
-				auto alntimeEnd = std::chrono::system_clock::now();
-				alntimems = std::chrono::duration_cast<std::chrono::milliseconds>(alntimeEnd - alntimeStart).count();
+				//only with 64-bit words, checked when parsing the parameters
+				if constexpr (std::is_same<Word, uint64_t>::value)
+				{
+					auto alntimeStart = std::chrono::system_clock::now();
+					alignments = AlignOneWayDijkstra(alignmentGraph, fastq->seq_id, fastq->sequence, !params.verboseMode, reusableState, params.forceGlobal, params.preciseClipping);
+					auto alntimeEnd = std::chrono::system_clock::now();
+					alntimems = std::chrono::duration_cast<std::chrono::milliseconds>(alntimeEnd - alntimeStart).count();
+					reusableState.counters.extensionNs += std::chrono::duration_cast<std::chrono::nanoseconds>(alntimeEnd - alntimeStart).count();
+				}
 			}
 			else
 			{
 				auto alntimeStart = std::chrono::system_clock::now();
-				alignments = AlignOneWay(alignmentGraph, fastq->seq_id, fastq->sequence, params.initialBandwidth, params.rampBandwidth, !params.verboseMode, reusableState, !params.highMemory, params.forceGlobal, params.preciseClipping, params.nondeterministicOptimizations, params.preciseClippingIdentityCutoff, params.Xdropcutoff, params.DPRestartStride);
+				alignments = AlignOneWay(alignmentGraph, fastq->seq_id, fastq->sequence, params.initialBandwidth, params.rampBandwidth, !params.verboseMode, reusableState, !params.highMemory, params.forceGlobal, params.preciseClipping, params.nondeterministicOptimizations, params.preciseClippingIdentityCutoff, params.Xdropcutoff, params.maxTraceMemory, params.DPRestartStride);
 				auto alntimeEnd = std::chrono::system_clock::now();
 				alntimems = std::chrono::duration_cast<std::chrono::milliseconds>(alntimeEnd - alntimeStart).count();
+				reusableState.counters.extensionNs += std::chrono::duration_cast<std::chrono::nanoseconds>(alntimeEnd - alntimeStart).count();
 			}
 		}
 		catch (const ThreadReadAssertion::AssertionFailure& a)
@@ -482,8 +635,10 @@ void runComponentMappings(const AlignmentGraph& alignmentGraph, moodycamel::Conc
 		}
 
 		stats.allAlignmentsCount += alignments.alignments.size();
+		reusableState.counters.seedsExtended += alignments.seedsExtended;
 
 		coutoutput << "Read " << fastq->seq_id << " alignment took " << alntimems << "ms" << BufferedWriter::Flush;
+		coutoutput << "Read " << fastq->seq_id << " DP tables allocated " << reusableState.arena.takeAllocatedBytes() << " bytes" << BufferedWriter::Flush;
 		if (alignments.alignments.size() > 0) alignments.alignments = AlignmentSelection::SelectAlignments(alignments.alignments, selectionOptions);
 
 		//failed alignment, don't output
@@ -491,12 +646,14 @@ void runComponentMappings(const AlignmentGraph& alignmentGraph, moodycamel::Conc
 		{
 			coutoutput << "Read " << fastq->seq_id << " alignment failed" << BufferedWriter::Flush;
 			cerroutput << "Read " << fastq->seq_id << " alignment failed" << BufferedWriter::Flush;
+			size_t correctedStart = correctedWriter.buffer().size();
 			try
 			{
-				if (params.outputCorrectedFile != "") writeCorrectedToQueue(correctedToken, params, fastq->seq_id, fastq->sequence, alignmentGraph.getDBGoverlap(), correctedOut, alignments);
+				if (params.outputCorrectedFile != "") writeCorrectedToBuffer(correctedWriter.buffer(), fastq->seq_id, fastq->sequence, alignmentGraph.getDBGoverlap(), alignments);
 			}
 			catch (const ThreadReadAssertion::AssertionFailure& a)
 			{
+				correctedWriter.rollback(correctedStart);
 				reusableState.clear();
 				stats.assertionBroke = true;
 				continue;
@@ -524,14 +681,6 @@ void runComponentMappings(const AlignmentGraph& alignmentGraph, moodycamel::Conc
 			}
 		}
 
-		if (params.outputGAFFile != "")
-		{
-			for (size_t i = 0; i < alignments.alignments.size(); i++)
-			{
-				AddGAFLine(alignmentGraph, fastq->seq_id, fastq->sequence, alignments.alignments[i], params.cigarMatchMismatchMerge);
-			}
-		}
-		
 		std::sort(alignments.alignments.begin(), alignments.alignments.end(), [](const AlignmentResult::AlignmentItem& left, const AlignmentResult::AlignmentItem& right) { return left.alignmentStart < right.alignmentStart; });
 
 		std::string alignmentpositions;
@@ -554,26 +703,67 @@ void runComponentMappings(const AlignmentGraph& alignmentGraph, moodycamel::Conc
 		alignmentpositions.pop_back();
 		coutoutput << "Read " << fastq->seq_id << " aligned by thread " << threadnum << " with positions: " << alignmentpositions << " (read " << fastq->sequence.size() << "bp)" << BufferedWriter::Flush;
 
+		size_t GAMStart = GAMWriter.buffer().size();
+		size_t JSONStart = JSONWriter.buffer().size();
+		size_t GAFStart = GAFWriter.buffer().size();
+		size_t correctedStart = correctedWriter.buffer().size();
+		size_t clippedStart = clippedWriter.buffer().size();
 		try
 		{
-			if (params.outputGAMFile != "") writeGAMToQueue(GAMToken, params, GAMOut, alignments);
-			if (params.outputJSONFile != "") writeJSONToQueue(JSONToken, params, JSONOut, alignments);
-			if (params.outputGAFFile != "") writeGAFToQueue(GAFToken, params, GAFOut, alignments);
-			if (params.outputCorrectedFile != "") writeCorrectedToQueue(correctedToken, params, fastq->seq_id, fastq->sequence, alignmentGraph.getDBGoverlap(), correctedOut, alignments);
-			if (params.outputCorrectedClippedFile != "") writeCorrectedClippedToQueue(clippedToken, params, correctedClippedOut, alignments);
+			if (params.outputGAMFile != "") writeGAMToBuffer(GAMWriter.buffer(), alignments);
+			if (params.outputJSONFile != "") writeJSONToBuffer(JSONWriter.buffer(), jsonBuffer, alignments);
+			if (params.outputGAFFile != "") writeGAFToBuffer(GAFWriter.buffer(), alignmentGraph, params, fastq->seq_id, fastq->sequence, alignments);
+			if (params.outputCorrectedFile != "") writeCorrectedToBuffer(correctedWriter.buffer(), fastq->seq_id, fastq->sequence, alignmentGraph.getDBGoverlap(), alignments);
+			if (params.outputCorrectedClippedFile != "") writeCorrectedClippedToBuffer(clippedWriter.buffer(), alignments);
 		}
 		catch (const ThreadReadAssertion::AssertionFailure& a)
 		{
+			GAMWriter.rollback(GAMStart);
+			JSONWriter.rollback(JSONStart);
+			GAFWriter.rollback(GAFStart);
+			correctedWriter.rollback(correctedStart);
+			clippedWriter.rollback(clippedStart);
 			reusableState.clear();
 			stats.assertionBroke = true;
 			continue;
 		}
-
+	}
+	GAMWriter.flush();
+	JSONWriter.flush();
+	GAFWriter.flush();
+	correctedWriter.flush();
+	clippedWriter.flush();
+	readStatsWriter.flush();
+	//no reads left, help the other threads with their last reads until they run out too
+	extensionPool.help(reusableState);
+	//the extensions done for other threads only count in the run totals
+	threadCounters.add(reusableState.counters);
+	{
+		std::lock_guard<std::mutex> lock { stats.countersMutex };
+		stats.counters.add(threadCounters);
 	}
 	assertSetNoRead("After all reads");
 	coutoutput << "Thread " << threadnum << " finished" << BufferedWriter::Flush;
 }
 
+template <typename Word>
+void runMappingThreads(const AlignmentGraph& alignmentGraph, ReadBatchScheduler& readFastqsQueue, BlockingQueue<std::unique_ptr<ReadBatch>>& readBatchPool, const Seeder& seeder, const AlignerParams& params, OutputScheduler& output, const OutputStreams& streams, AlignmentStats& stats)
+{
+	typename GraphAlignerCommon<size_t, int32_t, Word>::ExtensionPool extensionPool { params.numThreads };
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < params.numThreads; i++)
+	{
+		threads.emplace_back([&alignmentGraph, &readFastqsQueue, &readBatchPool, i, seeder, params, &output, &streams, &extensionPool, &stats]()
+		{
+			runComponentMappings<Word>(alignmentGraph, readFastqsQueue, readBatchPool, i, seeder, params, output, streams, extensionPool, stats);
+		});
+	}
+	for (size_t i = 0; i < params.numThreads; i++)
+	{
+		threads[i].join();
+	}
+}
+
 AlignmentGraph getGraph(std::string graphFile, MummerSeeder** mxmSeeder, const AlignerParams& params)
 {
 	bool loadMxmSeeder = params.mumCount > 0 || params.memCount > 0;
@@ -586,7 +776,16 @@ AlignmentGraph getGraph(std::string graphFile, MummerSeeder** mxmSeeder, const A
 	}
 	try
 	{
-		if (graphFile.substr(graphFile.size()-3) == ".vg")
+		if (graphFile.size() >= 6 && graphFile.substr(graphFile.size()-6) == ".gabin")
+		{
+			if (loadMxmSeeder)
+			{
+				std::cerr << "MUM/MEM seeding needs the original graph, it cannot be used with a graph snapshot" << std::endl;
+				std::exit(1);
+			}
+			return AlignmentGraph::LoadSnapshot(graphFile);
+		}
+		else if (graphFile.substr(graphFile.size()-3) == ".vg")
 		{
 			if (loadMxmSeeder)
 			{
@@ -639,15 +838,40 @@ void alignReads(AlignerParams params)
 	std::unordered_map<std::string, std::vector<SeedHit>> seedHits;
 	MummerSeeder* mummerseeder = nullptr;
 	auto alignmentGraph = getGraph(params.graphFile, &mummerseeder, params);
+	if (params.graphSnapshotFile.size() > 0)
+	{
+		std::cout << "Write graph snapshot to " << params.graphSnapshotFile << std::endl;
+		try
+		{
+			alignmentGraph.SaveSnapshot(params.graphSnapshotFile);
+		}
+		catch (const CommonUtils::InvalidGraphException& e)
+		{
+			std::cerr << e.what() << std::endl;
+			std::exit(1);
+		}
+		if (params.fastqFiles.size() == 0)
+		{
+			if (mummerseeder != nullptr) delete mummerseeder;
+			return;
+		}
+	}
 	bool loadMinimizerSeeder = params.minimizerSeedDensity != 0;
 	MinimizerSeeder* minimizerseeder = nullptr;
 	if (loadMinimizerSeeder)
 	{
-		std::cout << "Build minimizer seeder from the graph" << std::endl;
-		minimizerseeder = new MinimizerSeeder(alignmentGraph, params.minimizerLength, params.minimizerWindowSize, params.numThreads, 1.0 - params.minimizerDiscardMostNumerousFraction);
+		if (params.minimizerIndexFile.size() > 0 && is_file_exist(params.minimizerIndexFile))
+		{
+			std::cout << "Load minimizer seeder from " << params.minimizerIndexFile << std::endl;
+		}
+		else
+		{
+			std::cout << "Build minimizer seeder from the graph" << std::endl;
+		}
+		minimizerseeder = new MinimizerSeeder(alignmentGraph, params.minimizerLength, params.minimizerWindowSize, params.minimizerSyncmerLength, params.numThreads, params.minimizerBucketCount, 1.0 - params.minimizerDiscardMostNumerousFraction, params.minimizerIndexFile);
 		if (!minimizerseeder->canSeed())
 		{
-			std::cout << "Warning: Minimizer seeder has no seed hits. Reads cannot be aligned. Try unchopping the graph with vg or a different seeding mode" << std::endl;
+			std::cout << "Warning: Minimizer seeder has no seed hits. Reads cannot be aligned. Try a shorter minimizer length or a different seeding mode" << std::endl;
 		}
 	}
 
@@ -676,6 +900,8 @@ void alignReads(AlignerParams params)
 
 	Seeder seeder { params, seedHitsToThreads, mummerseeder, minimizerseeder };
 
+	if (params.verboseMode) std::cout << "K-mer hash kernel: " << KmerHashKernel::SelectedImplementation() << std::endl;
+
 	switch(seeder.mode)
 	{
 		case Seeder::Mode::File:
@@ -692,7 +918,14 @@ void alignReads(AlignerParams params)
 			std::cout << std::endl;
 			break;
 		case Seeder::Mode::Minimizer:
-			std::cout << "Minimizer seeds, length " << seeder.minimizerLength << ", window size " << seeder.minimizerWindowSize << ", density " << seeder.minimizerSeedDensity << std::endl;
+			if (seeder.minimizerSyncmerLength > 0)
+			{
+				std::cout << "Syncmer seeds, length " << seeder.minimizerLength << ", s-mer length " << seeder.minimizerSyncmerLength << ", density " << seeder.minimizerSeedDensity << std::endl;
+			}
+			else
+			{
+				std::cout << "Minimizer seeds, length " << seeder.minimizerLength << ", window size " << seeder.minimizerWindowSize << ", density " << seeder.minimizerSeedDensity << std::endl;
+			}
 			break;
 		case Seeder::Mode::None:
 			if (params.optimalDijkstra)
@@ -720,64 +953,76 @@ void alignReads(AlignerParams params)
 	if (params.outputGAFFile != "") std::cout << "write alignments to " << params.outputGAFFile << std::endl;
 	if (params.outputCorrectedFile != "") std::cout << "write corrected reads to " << params.outputCorrectedFile << std::endl;
 	if (params.outputCorrectedClippedFile != "") std::cout << "write corrected & clipped reads to " << params.outputCorrectedClippedFile << std::endl;
-
-	std::vector<std::thread> threads;
+	if (params.outputStatsFile != "") std::cout << "write run statistics to " << params.outputStatsFile << std::endl;
+	if (params.outputReadStatsFile != "") std::cout << "write read statistics to " << params.outputReadStatsFile << std::endl;
+	if (params.orderedOutput) std::cout << "write output in the input order" << std::endl;
 
 	assertSetNoRead("Running alignments");
 
-	moodycamel::ConcurrentQueue<std::string*> outputGAM { 50, params.numThreads, params.numThreads };
-	moodycamel::ConcurrentQueue<std::string*> outputGAF { 50, params.numThreads, params.numThreads };
-	moodycamel::ConcurrentQueue<std::string*> outputJSON { 50, params.numThreads, params.numThreads };
-	moodycamel::ConcurrentQueue<std::string*> deallocAlns;
-	moodycamel::ConcurrentQueue<std::string*> outputCorrected { 50, params.numThreads, params.numThreads };
-	moodycamel::ConcurrentQueue<std::string*> outputCorrectedClipped { 50, params.numThreads, params.numThreads };
-	moodycamel::ConcurrentQueue<std::shared_ptr<FastQ>> readFastqsQueue;
-	std::atomic<bool> readStreamingFinished { false };
-	std::atomic<bool> allThreadsDone { false };
-	std::atomic<bool> GAMWriteDone { false };
-	std::atomic<bool> GAFWriteDone { false };
-	std::atomic<bool> JSONWriteDone { false };
-	std::atomic<bool> correctedWriteDone { false };
-	std::atomic<bool> correctedClippedWriteDone { false };
+	OutputScheduler output { params.numThreads, params.orderedOutput };
+	OutputStreams streams { OutputScheduler::NoStream, OutputScheduler::NoStream, OutputScheduler::NoStream, OutputScheduler::NoStream, OutputScheduler::NoStream, OutputScheduler::NoStream };
+	try
+	{
+		if (params.outputGAMFile != "") streams.GAM = output.addStream(params.outputGAMFile, emptyGAM());
+		if (params.outputJSONFile != "") streams.JSON = output.addStream(params.outputJSONFile, "");
+		if (params.outputGAFFile != "") streams.GAF = output.addStream(params.outputGAFFile, "");
+		if (params.outputCorrectedFile != "") streams.corrected = output.addStream(params.outputCorrectedFile, "");
+		if (params.outputCorrectedClippedFile != "") streams.correctedClipped = output.addStream(params.outputCorrectedClippedFile, "");
+		if (params.outputReadStatsFile != "") streams.readStats = output.addStream(params.outputReadStatsFile, "");
+	}
+	catch (const std::runtime_error& e)
+	{
+		std::cerr << e.what() << std::endl;
+		std::exit(1);
+	}
+	//opened before aligning so a bad path doesn't throw away the run
+	std::ofstream statsFile;
+	if (params.outputStatsFile != "")
+	{
+		statsFile.open(params.outputStatsFile);
+		if (!statsFile.good())
+		{
+			std::cerr << "Could not open output file " << params.outputStatsFile << std::endl;
+			std::exit(1);
+		}
+	}
+	//split batches would share a sequence number, which the ordered output can't have
+	ReadBatchScheduler readFastqsQueue { params.numThreads * ReadLookaheadPerThread, !params.orderedOutput };
+	BlockingQueue<std::unique_ptr<ReadBatch>> readBatchPool { params.numThreads * (ReadLookaheadPerThread + 2) };
 
 	std::cout << "Align" << std::endl;
 	AlignmentStats stats;
-	std::thread fastqThread { [files=params.fastqFiles, &readFastqsQueue, &readStreamingFinished]() { readFastqs(files, readFastqsQueue, readStreamingFinished); } };
-	std::thread GAMwriterThread { [file=params.outputGAMFile, &outputGAM, &deallocAlns, &allThreadsDone, &GAMWriteDone, verboseMode=params.verboseMode]() { if (file != "") consumeBytesAndWrite(file, outputGAM, deallocAlns, allThreadsDone, GAMWriteDone, verboseMode, false); else GAMWriteDone = true; } };
-	std::thread GAFwriterThread { [file=params.outputGAFFile, &outputGAF, &deallocAlns, &allThreadsDone, &GAFWriteDone, verboseMode=params.verboseMode]() { if (file != "") consumeBytesAndWrite(file, outputGAF, deallocAlns, allThreadsDone, GAFWriteDone, verboseMode, false); else GAFWriteDone = true; } };
-	std::thread JSONwriterThread { [file=params.outputJSONFile, &outputJSON, &deallocAlns, &allThreadsDone, &JSONWriteDone, verboseMode=params.verboseMode]() { if (file != "") consumeBytesAndWrite(file, outputJSON, deallocAlns, allThreadsDone, JSONWriteDone, verboseMode, true); else JSONWriteDone = true; } };
-	std::thread correctedWriterThread { [file=params.outputCorrectedFile, &outputCorrected, &deallocAlns, &allThreadsDone, &correctedWriteDone, verboseMode=params.verboseMode, uncompressed=!params.compressCorrected]() { if (file != "") consumeBytesAndWrite(file, outputCorrected, deallocAlns, allThreadsDone, correctedWriteDone, verboseMode, uncompressed); else correctedWriteDone = true; } };
-	std::thread correctedClippedWriterThread { [file=params.outputCorrectedClippedFile, &outputCorrectedClipped, &deallocAlns, &allThreadsDone, &correctedClippedWriteDone, verboseMode=params.verboseMode, uncompressed=!params.compressClipped]() { if (file != "") consumeBytesAndWrite(file, outputCorrectedClipped, deallocAlns, allThreadsDone, correctedClippedWriteDone, verboseMode, uncompressed); else correctedClippedWriteDone = true; } };
+	std::thread fastqThread { [files=params.fastqFiles, decompressionThreads=std::min(params.numThreads, MaxDecompressionThreads), ordered=params.orderedOutput, &readFastqsQueue, &readBatchPool]() { readFastqs(files, decompressionThreads, ordered, readFastqsQueue, readBatchPool); } };
+	output.start();
 
-	for (size_t i = 0; i < params.numThreads; i++)
+	switch(params.DPWordSize)
 	{
-		threads.emplace_back([&alignmentGraph, &readFastqsQueue, &readStreamingFinished, i, seeder, params, &outputGAM, &outputJSON, &outputGAF, &outputCorrected, &outputCorrectedClipped, &deallocAlns, &stats]() { runComponentMappings(alignmentGraph, readFastqsQueue, readStreamingFinished, i, seeder, params, outputGAM, outputJSON, outputGAF, outputCorrected, outputCorrectedClipped, deallocAlns, stats); });
+		case 128:
+			runMappingThreads<__uint128_t>(alignmentGraph, readFastqsQueue, readBatchPool, seeder, params, output, streams, stats);
+			break;
+		case 256:
+			runMappingThreads<Word256>(alignmentGraph, readFastqsQueue, readBatchPool, seeder, params, output, streams, stats);
+			break;
+		default:
+			runMappingThreads<uint64_t>(alignmentGraph, readFastqsQueue, readBatchPool, seeder, params, output, streams, stats);
+			break;
 	}
+	assertSetNoRead("Postprocessing");
 
-	for (size_t i = 0; i < params.numThreads; i++)
+	try
 	{
-		threads[i].join();
+		output.finish();
+	}
+	catch (const std::runtime_error& e)
+	{
+		std::cerr << e.what() << std::endl;
+		std::exit(1);
 	}
-	assertSetNoRead("Postprocessing");
-
-	allThreadsDone = true;
-
-	GAMwriterThread.join();
-	GAFwriterThread.join();
-	JSONwriterThread.join();
-	correctedWriterThread.join();
-	correctedClippedWriterThread.join();
 	fastqThread.join();
 
 	if (mummerseeder != nullptr) delete mummerseeder;
 	if (minimizerseeder != nullptr) delete minimizerseeder;
 
-	std::string* dealloc;
-	while (deallocAlns.try_dequeue(dealloc))
-	{
-		delete dealloc;
-	}
-
 	std::cout << "Alignment finished" << std::endl;
 	std::cout << "Input reads: " << stats.reads << " (" << stats.bpInReads << "bp)" << std::endl;
 	std::cout << "Seeds found: " << stats.seedsFound << std::endl;
@@ -792,4 +1037,11 @@ void alignReads(AlignerParams params)
 	{
 		std::cout << "Alignment broke with some reads. Look at stderr output." << std::endl;
 	}
+	if (params.outputStatsFile != "")
+	{
+		std::string json = "{\"reads\":" + std::to_string(stats.reads) + ",\"bp_in_reads\":" + std::to_string(stats.bpInReads) + ",\"reads_with_an_alignment\":" + std::to_string(stats.readsWithAnAlignment) + ",";
+		stats.counters.writeJSONFields(json);
+		json += "}\n";
+		statsFile << json;
+	}
 }
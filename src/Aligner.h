@@ -10,6 +10,7 @@
 struct AlignerParams
 {
 	std::string graphFile;
+	std::string graphSnapshotFile;
 	std::vector<std::string> fastqFiles;
 	size_t numThreads;
 	size_t initialBandwidth;
@@ -22,6 +23,8 @@ struct AlignerParams
 	std::string outputGAFFile;
 	std::string outputCorrectedFile;
 	std::string outputCorrectedClippedFile;
+	std::string outputStatsFile;
+	std::string outputReadStatsFile;
 	bool verboseMode;
 	bool tryAllSeeds;
 	bool highMemory;
@@ -37,9 +40,12 @@ struct AlignerParams
 	bool preciseClipping;
 	size_t minimizerLength;
 	size_t minimizerWindowSize;
+	size_t minimizerSyncmerLength;
 	double minimizerSeedDensity;
 	size_t seedClusterMinSize;
 	double minimizerDiscardMostNumerousFraction;
+	std::string minimizerIndexFile;
+	size_t minimizerBucketCount;
 	double seedExtendDensity;
 	bool nondeterministicOptimizations;
 	bool optimalDijkstra;
@@ -47,6 +53,9 @@ struct AlignerParams
 	int Xdropcutoff;
 	size_t DPRestartStride;
 	bool cigarMatchMismatchMerge;
+	size_t DPWordSize;
+	size_t maxTraceMemory;
+	bool orderedOutput;
 };
 
 void alignReads(AlignerParams params);
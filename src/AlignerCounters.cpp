@@ -0,0 +1,88 @@
+#include <cstdio>
+#include "AlignerCounters.h"
+
+AlignerCounters::AlignerCounters()
+{
+	reset();
+}
+
+void AlignerCounters::add(const AlignerCounters& other)
+{
+	seeds += other.seeds;
+	seedsExtended += other.seedsExtended;
+	slices += other.slices;
+	recalculatedSlices += other.recalculatedSlices;
+	rampRedos += other.rampRedos;
+	cellsProcessed += other.cellsProcessed;
+	nodesProcessed += other.nodesProcessed;
+	queuePushes += other.queuePushes;
+	queuePops += other.queuePops;
+	seedingNs += other.seedingNs;
+	clusteringNs += other.clusteringNs;
+	extensionNs += other.extensionNs;
+	backtraceNs += other.backtraceNs;
+}
+
+void AlignerCounters::reset()
+{
+	seeds = 0;
+	seedsExtended = 0;
+	slices = 0;
+	recalculatedSlices = 0;
+	rampRedos = 0;
+	cellsProcessed = 0;
+	nodesProcessed = 0;
+	queuePushes = 0;
+	queuePops = 0;
+	seedingNs = 0;
+	clusteringNs = 0;
+	extensionNs = 0;
+	backtraceNs = 0;
+}
+
+void AlignerCounters::writeJSONFields(std::string& out) const
+{
+	out += "\"seeds\":" + std::to_string(seeds);
+	out += ",\"seeds_extended\":" + std::to_string(seedsExtended);
+	out += ",\"slices\":" + std::to_string(slices);
+	out += ",\"recalculated_slices\":" + std::to_string(recalculatedSlices);
+	out += ",\"ramp_redos\":" + std::to_string(rampRedos);
+	out += ",\"cells_processed\":" + std::to_string(cellsProcessed);
+	out += ",\"nodes_processed\":" + std::to_string(nodesProcessed);
+	out += ",\"queue_pushes\":" + std::to_string(queuePushes);
+	out += ",\"queue_pops\":" + std::to_string(queuePops);
+	out += ",\"seeding_ns\":" + std::to_string(seedingNs);
+	out += ",\"clustering_ns\":" + std::to_string(clusteringNs);
+	out += ",\"extension_ns\":" + std::to_string(extensionNs);
+	out += ",\"backtrace_ns\":" + std::to_string(backtraceNs);
+}
+
+void appendJSONString(std::string& out, std::string_view str)
+{
+	out += '"';
+	for (char c : str)
+	{
+		switch(c)
+		{
+			case '"':
+				out += "\\\"";
+				break;
+			case '\\':
+				out += "\\\\";
+				break;
+			default:
+				if ((unsigned char)c < 0x20)
+				{
+					char escaped[7];
+					snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned int)(unsigned char)c);
+					out += escaped;
+				}
+				else
+				{
+					out += c;
+				}
+				break;
+		}
+	}
+	out += '"';
+}
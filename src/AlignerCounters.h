@@ -0,0 +1,35 @@
+#ifndef AlignerCounters_h
+#define AlignerCounters_h
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+//work done by one thread. every thread counts into its own counters so counting is a plain addition
+//and the counters are summed when the threads finish
+class AlignerCounters
+{
+public:
+	AlignerCounters();
+	void add(const AlignerCounters& other);
+	void reset();
+	//appends the counters as "name":value pairs, without the braces
+	void writeJSONFields(std::string& out) const;
+	size_t seeds;
+	size_t seedsExtended;
+	size_t slices;
+	size_t recalculatedSlices;
+	size_t rampRedos;
+	size_t cellsProcessed;
+	size_t nodesProcessed;
+	size_t queuePushes;
+	size_t queuePops;
+	size_t seedingNs;
+	size_t clusteringNs;
+	size_t extensionNs;
+	size_t backtraceNs;
+};
+
+void appendJSONString(std::string& out, std::string_view str);
+
+#endif
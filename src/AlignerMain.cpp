@@ -34,11 +34,13 @@ int main(int argc, char** argv)
 
 	boost::program_options::options_description mandatory("Mandatory parameters");
 	mandatory.add_options()
-		("graph,g", boost::program_options::value<std::string>(), "input graph (.gfa / .vg)")
+		("graph,g", boost::program_options::value<std::string>(), "input graph (.gfa / .vg / .gabin)")
 		("reads,f", boost::program_options::value<std::vector<std::string>>()->multitoken(), "input reads (fasta or fastq, uncompressed or gzipped)")
 		("alignments-out,a", boost::program_options::value<std::vector<std::string>>(), "output alignment file (.gaf/.gam/.json)")
 		("corrected-out", boost::program_options::value<std::string>(), "output corrected reads file (.fa/.fa.gz)")
 		("corrected-clipped-out", boost::program_options::value<std::string>(), "output corrected clipped reads file (.fa/.fa.gz)")
+		("stats-out", boost::program_options::value<std::string>(), "output the work counters and timings of the run as JSON")
+		("read-stats-out", boost::program_options::value<std::string>(), "output the work counters and timings of each read as JSON lines")
 	;
 	boost::program_options::options_description presets("Preset parameters");
 	presets.add_options()
@@ -53,9 +55,11 @@ int main(int argc, char** argv)
 		("version", "print version")
 		("threads,t", boost::program_options::value<size_t>(), "number of threads (int) (default 1)")
 		("verbose", "print progress messages")
+		("ordered-output", "write the output in the same order as the input reads")
 		("E-cutoff", boost::program_options::value<double>(), "discard alignments with E-value > arg")
 		("all-alignments", "return all alignments instead of the best non-overlapping alignments")
 		("extra-heuristic", "use heuristics to discard more seed hits")
+		("graph-snapshot-out", boost::program_options::value<std::string>(), "write the alignment graph to a binary snapshot which loads faster with -g. Reads and outputs are optional with this (.gabin)")
 		("try-all-seeds", "don't use heuristics to discard seed hits")
 		("global-alignment", "force the read to be aligned end-to-end even if the alignment score is poor")
 		("optimal-alignment", "calculate the optimal alignment (VERY SLOW)")
@@ -69,8 +73,11 @@ int main(int argc, char** argv)
 		("seeds-extend-density", boost::program_options::value<double>(), "extend up to approximately the best (arg * sequence length) seeds (double) (-1 for all)")
 		("seeds-minimizer-length", boost::program_options::value<size_t>(), "k-mer length for minimizer seeding (int)")
 		("seeds-minimizer-windowsize", boost::program_options::value<size_t>(), "window size for minimizer seeding (int)")
+		("seeds-syncmer-length", boost::program_options::value<size_t>(), "index closed syncmers with s-mer length arg instead of window minimizers (int) (0 for window minimizers)")
 		("seeds-minimizer-density", boost::program_options::value<double>(), "keep approximately (arg * sequence length) least common minimizers (double) (-1 for all)")
 		("seeds-minimizer-ignore-frequent", boost::program_options::value<double>(), "ignore arg most frequent fraction of minimizers (double)")
+		("seeds-minimizer-buckets", boost::program_options::value<size_t>(), "split the minimizer index into arg buckets, must be a power of two (int)")
+		("seeds-minimizer-index", boost::program_options::value<std::string>(), "store the minimizer seeding index to the disk for reuse, or reuse it if it exists (filename)")
 		("seeds-mum-count", boost::program_options::value<size_t>(), "arg longest maximal unique matches fully contained in a node (int) (-1 for all)")
 		("seeds-mem-count", boost::program_options::value<size_t>(), "arg longest maximal exact matches fully contained in a node (int) (-1 for all)")
 		("seeds-mxm-length", boost::program_options::value<size_t>(), "minimum length for maximal unique / exact matches (int)")
@@ -85,6 +92,8 @@ int main(int argc, char** argv)
 		("ramp-bandwidth,B", boost::program_options::value<size_t>(), "ramp bandwidth (int)")
 		("tangle-effort,C", boost::program_options::value<size_t>(), "tangle effort limit, higher results in slower but more accurate alignments (int) (-1 for unlimited)")
 		("high-memory", "use slightly less CPU but a lot more memory")
+		("word-size", boost::program_options::value<size_t>(), "number of read positions per bit-parallel DP slice, 64, 128 or 256. 128 runs at about the speed of 64 and 256 about 2.5x slower, so keep the default unless benchmarking (int) (default 64)")
+		("max-trace-memory", boost::program_options::value<size_t>(), "keep at most approximately arg megabytes of DP scores per thread for the backtrace and recalculate the rest when needed. Slower but bounds the memory use with ultra-long reads (int) (default 0 for unlimited)")
 	;
 	boost::program_options::options_description hidden("hidden");
 	hidden.add_options()
@@ -127,11 +136,14 @@ int main(int argc, char** argv)
 
 	AlignerParams params;
 	params.graphFile = "";
+	params.graphSnapshotFile = "";
 	params.outputGAMFile = "";
 	params.outputJSONFile = "";
 	params.outputGAFFile = "";
 	params.outputCorrectedFile = "";
 	params.outputCorrectedClippedFile = "";
+	params.outputStatsFile = "";
+	params.outputReadStatsFile = "";
 	params.numThreads = 1;
 	params.initialBandwidth = 0;
 	params.rampBandwidth = 0;
@@ -153,8 +165,11 @@ int main(int argc, char** argv)
 	params.minimizerSeedDensity = 0;
 	params.minimizerLength = 19;
 	params.minimizerWindowSize = 30;
+	params.minimizerSyncmerLength = 0;
 	params.seedClusterMinSize = 1;
 	params.minimizerDiscardMostNumerousFraction = 0.0002;
+	params.minimizerIndexFile = "";
+	params.minimizerBucketCount = 256;
 	params.seedExtendDensity = 0.002;
 	params.nondeterministicOptimizations = false;
 	params.optimalDijkstra = false;
@@ -162,6 +177,9 @@ int main(int argc, char** argv)
 	params.Xdropcutoff = 0;
 	params.DPRestartStride = 0;
 	params.cigarMatchMismatchMerge = false;
+	params.DPWordSize = 64;
+	params.maxTraceMemory = 0;
+	params.orderedOutput = false;
 
 	std::vector<std::string> outputAlns;
 	bool paramError = false;
@@ -198,10 +216,13 @@ int main(int argc, char** argv)
 	}
 
 	if (vm.count("graph")) params.graphFile = vm["graph"].as<std::string>();
+	if (vm.count("graph-snapshot-out")) params.graphSnapshotFile = vm["graph-snapshot-out"].as<std::string>();
 	if (vm.count("reads")) params.fastqFiles = vm["reads"].as<std::vector<std::string>>();
 	if (vm.count("alignments-out")) outputAlns = vm["alignments-out"].as<std::vector<std::string>>();
 	if (vm.count("corrected-out")) params.outputCorrectedFile = vm["corrected-out"].as<std::string>();
 	if (vm.count("corrected-clipped-out")) params.outputCorrectedClippedFile = vm["corrected-clipped-out"].as<std::string>();
+	if (vm.count("stats-out")) params.outputStatsFile = vm["stats-out"].as<std::string>();
+	if (vm.count("read-stats-out")) params.outputReadStatsFile = vm["read-stats-out"].as<std::string>();
 	if (vm.count("threads")) params.numThreads = vm["threads"].as<size_t>();
 	if (vm.count("bandwidth")) params.initialBandwidth = vm["bandwidth"].as<size_t>();
 
@@ -211,6 +232,9 @@ int main(int argc, char** argv)
 	if (vm.count("seeds-minimizer-density")) params.minimizerSeedDensity = vm["seeds-minimizer-density"].as<double>();
 	if (vm.count("seeds-minimizer-length")) params.minimizerLength = vm["seeds-minimizer-length"].as<size_t>();
 	if (vm.count("seeds-minimizer-windowsize")) params.minimizerWindowSize = vm["seeds-minimizer-windowsize"].as<size_t>();
+	if (vm.count("seeds-syncmer-length")) params.minimizerSyncmerLength = vm["seeds-syncmer-length"].as<size_t>();
+	if (vm.count("seeds-minimizer-buckets")) params.minimizerBucketCount = vm["seeds-minimizer-buckets"].as<size_t>();
+	if (vm.count("seeds-minimizer-index")) params.minimizerIndexFile = vm["seeds-minimizer-index"].as<std::string>();
 	if (vm.count("seeds-file")) params.seedFiles = vm["seeds-file"].as<std::vector<std::string>>();
 	if (vm.count("seeds-mxm-length")) params.mxmLength = vm["seeds-mxm-length"].as<size_t>();
 	if (vm.count("seeds-mem-count")) params.memCount = vm["seeds-mem-count"].as<size_t>();
@@ -225,7 +249,10 @@ int main(int argc, char** argv)
 	if (vm.count("verbose")) params.verboseMode = true;
 	if (vm.count("try-all-seeds")) params.tryAllSeeds = true;
 	if (vm.count("high-memory")) params.highMemory = true;
+	if (vm.count("word-size")) params.DPWordSize = vm["word-size"].as<size_t>();
+	if (vm.count("max-trace-memory")) params.maxTraceMemory = vm["max-trace-memory"].as<size_t>() * 1024 * 1024;
 	if (vm.count("cigar-match-mismatch")) params.cigarMatchMismatchMerge = true;
+	if (vm.count("ordered-output")) params.orderedOutput = true;
 
 	int resultSelectionMethods = 0;
 	if (vm.count("all-alignments"))
@@ -297,6 +324,23 @@ int main(int argc, char** argv)
 		std::cerr << "graph file must be given" << std::endl;
 		paramError = true;
 	}
+	if (params.graphSnapshotFile != "" && (params.graphSnapshotFile.size() < 6 || params.graphSnapshotFile.substr(params.graphSnapshotFile.size()-6) != ".gabin"))
+	{
+		std::cerr << "graph snapshot file must end with .gabin" << std::endl;
+		paramError = true;
+	}
+	bool onlySnapshot = params.graphSnapshotFile != "" && params.fastqFiles.size() == 0 && outputAlns.size() == 0 && params.outputCorrectedFile == "" && params.outputCorrectedClippedFile == "";
+	if (onlySnapshot)
+	{
+		//no alignment, skip checking the alignment parameters
+		if (paramError)
+		{
+			std::cerr << "run with option -h for help" << std::endl;
+			std::exit(1);
+		}
+		alignReads(params);
+		return 0;
+	}
 	if (params.fastqFiles.size() == 0)
 	{
 		std::cerr << "read file must be given" << std::endl;
@@ -362,11 +406,21 @@ int main(int argc, char** argv)
 		std::cerr << "Maximum minimizer length is " << (sizeof(size_t)*8/2)-1 << std::endl;
 		paramError = true;
 	}
+	if (params.minimizerSyncmerLength >= params.minimizerLength)
+	{
+		std::cerr << "Syncmer length must be shorter than the minimizer length" << std::endl;
+		paramError = true;
+	}
 	if (params.minimizerDiscardMostNumerousFraction < 0 || params.minimizerDiscardMostNumerousFraction >= 1)
 	{
 		std::cerr << "Minimizer discard fraction must be 0 <= x < 1" << std::endl;
 		paramError = true;
 	}
+	if (params.minimizerBucketCount == 0 || (params.minimizerBucketCount & (params.minimizerBucketCount - 1)) != 0)
+	{
+		std::cerr << "Minimizer bucket count must be a power of two" << std::endl;
+		paramError = true;
+	}
 	if (params.minimizerSeedDensity < 0 && params.minimizerSeedDensity != -1)
 	{
 		std::cerr << "Minimizer density can't be negative" << std::endl;
@@ -400,6 +454,16 @@ int main(int argc, char** argv)
 		std::cerr << "pick only one seeding method" << std::endl;
 		paramError = true;
 	}
+	if (params.DPWordSize != 64 && params.DPWordSize != 128 && params.DPWordSize != 256)
+	{
+		std::cerr << "Word size must be 64, 128 or 256" << std::endl;
+		paramError = true;
+	}
+	if (params.optimalDijkstra && params.DPWordSize != 64)
+	{
+		std::cerr << "--optimal-alignment cannot be combined with --word-size other than 64" << std::endl;
+		paramError = true;
+	}
 	if (pickedSeedingMethods == 0 && !params.optimalDijkstra)
 	{
 		std::cerr << "pick a seeding method" << std::endl;
@@ -104,9 +104,19 @@ double AlignmentCorrectnessEstimationState::FalseLogOdds() const
 
 AlignmentCorrectnessEstimationState AlignmentCorrectnessEstimationState::NextState(int mismatches, int rowSize) const
 {
-	assert(rowSize == 64);
-	// assert(rowSize == 64 || rowSize == 1);
+	assert(rowSize > 0 && rowSize % wordSize == 0);
 	assert(mismatches >= 0);
+	if (rowSize > wordSize)
+	{
+		//slices from wider DP words are treated as consecutive 64-row steps with the mismatches spread evenly
+		int steps = rowSize / wordSize;
+		AlignmentCorrectnessEstimationState result = *this;
+		for (int i = 0; i < steps; i++)
+		{
+			result = result.NextState(mismatches / steps + (i < mismatches % steps ? 1 : 0), wordSize);
+		}
+		return result;
+	}
 	AlignmentCorrectnessEstimationState result;
 	result.correctFromCorrectTrace = correctLogOdds + correctToCorrectTransitionLogProbability >= falseLogOdds + falseToCorrectTransitionLogProbability;
 	result.falseFromCorrectTrace = correctLogOdds + correctToFalseTransitionLogProbability >= falseLogOdds + falseToFalseTransitionLogProbability;
@@ -2,6 +2,13 @@
 #include <limits>
 #include <algorithm>
 #include <queue>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include "AlignmentGraph.h"
 #include "CommonUtils.h"
 #include "ThreadReadAssertion.h"
@@ -18,6 +25,9 @@ nodeLength(),
 nodeLookup(),
 nodeIDs(),
 inNeighbors(),
+outNeighbors(),
+buildInNeighbors(),
+buildOutNeighbors(),
 nodeSequences(),
 bpSize(0),
 ambiguousNodeSequences(),
@@ -39,8 +49,8 @@ void AlignmentGraph::ReserveNodes(size_t numNodes, size_t numSplitNodes)
 	nodeLookup.reserve(numNodes);
 	nodeIDs.reserve(numSplitNodes);
 	nodeLength.reserve(numSplitNodes);
-	inNeighbors.reserve(numSplitNodes);
-	outNeighbors.reserve(numSplitNodes);
+	buildInNeighbors.reserve(numSplitNodes);
+	buildOutNeighbors.reserve(numSplitNodes);
 	reverse.reserve(numSplitNodes);
 	nodeOffset.reserve(numSplitNodes);
 }
@@ -69,14 +79,14 @@ void AlignmentGraph::AddNode(int nodeId, const std::string& sequence, const std:
 			AddNode(nodeId, offset, sequence.substr(offset, size), reverseNode);
 			if (offset > 0)
 			{
-				assert(outNeighbors.size() >= 2);
-				assert(outNeighbors.size() == inNeighbors.size());
-				assert(nodeIDs.size() == outNeighbors.size());
-				assert(nodeOffset.size() == outNeighbors.size());
-				assert(nodeIDs[outNeighbors.size()-2] == nodeIDs[outNeighbors.size()-1]);
-				assert(nodeOffset[outNeighbors.size()-2] + nodeLength[outNeighbors.size()-2] == nodeOffset[outNeighbors.size()-1]);
-				outNeighbors[outNeighbors.size()-2].push_back(outNeighbors.size()-1);
-				inNeighbors[inNeighbors.size()-1].push_back(inNeighbors.size()-2);
+				assert(buildOutNeighbors.size() >= 2);
+				assert(buildOutNeighbors.size() == buildInNeighbors.size());
+				assert(nodeIDs.size() == buildOutNeighbors.size());
+				assert(nodeOffset.size() == buildOutNeighbors.size());
+				assert(nodeIDs[buildOutNeighbors.size()-2] == nodeIDs[buildOutNeighbors.size()-1]);
+				assert(nodeOffset[buildOutNeighbors.size()-2] + nodeLength[buildOutNeighbors.size()-2] == nodeOffset[buildOutNeighbors.size()-1]);
+				buildOutNeighbors[buildOutNeighbors.size()-2].push_back(buildOutNeighbors.size()-1);
+				buildInNeighbors[buildInNeighbors.size()-1].push_back(buildInNeighbors.size()-2);
 			}
 		}
 	}
@@ -92,8 +102,8 @@ void AlignmentGraph::AddNode(int nodeId, int offset, const std::string& sequence
 	nodeLookup[nodeId].push_back(nodeLength.size());
 	nodeLength.push_back(sequence.size());
 	nodeIDs.push_back(nodeId);
-	inNeighbors.emplace_back();
-	outNeighbors.emplace_back();
+	buildInNeighbors.emplace_back();
+	buildOutNeighbors.emplace_back();
 	reverse.push_back(reverseNode);
 	nodeOffset.push_back(offset);
 	NodeChunkSequence normalSeq;
@@ -223,8 +233,8 @@ void AlignmentGraph::AddNode(int nodeId, int offset, const std::string& sequence
 		nodeSequences.emplace_back(normalSeq);
 	}
 	assert(nodeIDs.size() == nodeLength.size());
-	assert(nodeLength.size() == inNeighbors.size());
-	assert(inNeighbors.size() == outNeighbors.size());
+	assert(nodeLength.size() == buildInNeighbors.size());
+	assert(buildInNeighbors.size() == buildOutNeighbors.size());
 }
 
 void AlignmentGraph::AddEdgeNodeId(int node_id_from, int node_id_to, size_t startOffset)
@@ -245,19 +255,28 @@ void AlignmentGraph::AddEdgeNodeId(int node_id_from, int node_id_to, size_t star
 	}
 	assert(to != std::numeric_limits<size_t>::max());
 	//don't add double edges
-	if (std::find(inNeighbors[to].begin(), inNeighbors[to].end(), from) == inNeighbors[to].end()) inNeighbors[to].push_back(from);
-	if (std::find(outNeighbors[from].begin(), outNeighbors[from].end(), to) == outNeighbors[from].end()) outNeighbors[from].push_back(to);
+	if (std::find(buildInNeighbors[to].begin(), buildInNeighbors[to].end(), from) == buildInNeighbors[to].end()) buildInNeighbors[to].push_back(from);
+	if (std::find(buildOutNeighbors[from].begin(), buildOutNeighbors[from].end(), to) == buildOutNeighbors[from].end()) buildOutNeighbors[from].push_back(to);
 }
 
 void AlignmentGraph::Finalize(int wordSize)
 {
 	assert(nodeSequences.size() + ambiguousNodeSequences.size() == nodeLength.size());
-	assert(inNeighbors.size() == nodeLength.size());
-	assert(outNeighbors.size() == nodeLength.size());
+	assert(buildInNeighbors.size() == nodeLength.size());
+	assert(buildOutNeighbors.size() == nodeLength.size());
 	assert(reverse.size() == nodeLength.size());
 	assert(nodeIDs.size() == nodeLength.size());
 	RenumberAmbiguousToEnd();
 	ambiguousNodes.clear();
+	size_t nestedNeighborBytes = 0;
+	for (size_t i = 0; i < buildInNeighbors.size(); i++)
+	{
+		nestedNeighborBytes += sizeof(std::vector<size_t>) * 2 + (buildInNeighbors[i].capacity() + buildOutNeighbors[i].capacity()) * sizeof(size_t);
+	}
+	inNeighbors = NeighborList { buildInNeighbors };
+	outNeighbors = NeighborList { buildOutNeighbors };
+	std::vector<std::vector<size_t>>{}.swap(buildInNeighbors);
+	std::vector<std::vector<size_t>>{}.swap(buildOutNeighbors);
 	findLinearizable();
 	doComponentOrder();
 	findChains();
@@ -269,13 +288,12 @@ void AlignmentGraph::Finalize(int wordSize)
 	size_t edges = 0;
 	for (size_t i = 0; i < inNeighbors.size(); i++)
 	{
-		inNeighbors[i].shrink_to_fit();
-		outNeighbors[i].shrink_to_fit();
 		if (inNeighbors[i].size() >= 2) specialNodes++;
 		edges += inNeighbors[i].size();
 	}
 	std::cout << edges << " edges" << std::endl;
 	std::cout << specialNodes << " nodes with in-degree >= 2" << std::endl;
+	std::cout << "neighbor lists use " << (inNeighbors.SizeInBytes() + outNeighbors.SizeInBytes()) << " bytes (" << nestedNeighborBytes << " bytes as vectors of vectors)" << std::endl;
 	assert(nodeSequences.size() + ambiguousNodeSequences.size() == nodeLength.size());
 	assert(inNeighbors.size() == nodeLength.size());
 	assert(outNeighbors.size() == nodeLength.size());
@@ -284,8 +302,6 @@ void AlignmentGraph::Finalize(int wordSize)
 	assert(nodeOffset.size() == nodeLength.size());
 	nodeLength.shrink_to_fit();
 	nodeIDs.shrink_to_fit();
-	inNeighbors.shrink_to_fit();
-	outNeighbors.shrink_to_fit();
 	reverse.shrink_to_fit();
 	nodeSequences.shrink_to_fit();
 	ambiguousNodeSequences.shrink_to_fit();
@@ -300,6 +316,37 @@ void AlignmentGraph::Finalize(int wordSize)
 #endif
 }
 
+AlignmentGraph::NeighborList::NeighborList() :
+	start(1, 0),
+	targets()
+{
+}
+
+AlignmentGraph::NeighborList::NeighborList(const std::vector<std::vector<size_t>>& neighbors) :
+	start(),
+	targets()
+{
+	size_t total = 0;
+	for (size_t i = 0; i < neighbors.size(); i++) total += neighbors[i].size();
+	start.reserve(neighbors.size()+1);
+	targets.reserve(total);
+	for (size_t i = 0; i < neighbors.size(); i++)
+	{
+		start.push_back(targets.size());
+		for (auto neighbor : neighbors[i])
+		{
+			if (neighbor > std::numeric_limits<uint32_t>::max()) throw CommonUtils::InvalidGraphException { "Graph has too many split nodes (max " + std::to_string(std::numeric_limits<uint32_t>::max()) + ")" };
+			targets.push_back(neighbor);
+		}
+	}
+	start.push_back(targets.size());
+}
+
+size_t AlignmentGraph::NeighborList::SizeInBytes() const
+{
+	return start.capacity() * sizeof(size_t) + targets.capacity() * sizeof(uint32_t);
+}
+
 std::pair<bool, size_t> AlignmentGraph::findBubble(const size_t start, const std::vector<bool>& ignorableTip)
 {
 	std::vector<size_t> S;
@@ -348,7 +395,7 @@ std::pair<bool, size_t> AlignmentGraph::findBubble(const size_t start, const std
 	return std::make_pair(false, 0);
 }
 
-size_t find(std::vector<size_t>& parent, size_t item)
+size_t find(SnapshotVector<size_t>& parent, size_t item)
 {
 	if (parent[item] == item) return item;
 	std::vector<size_t> stack;
@@ -358,7 +405,7 @@ size_t find(std::vector<size_t>& parent, size_t item)
 	return stack.back();
 }
 
-void merge(std::vector<size_t>& parent, std::vector<size_t>& rank, size_t left, size_t right)
+void merge(SnapshotVector<size_t>& parent, std::vector<size_t>& rank, size_t left, size_t right)
 {
 	left = find(parent, left);
 	right = find(parent, right);
@@ -889,11 +936,11 @@ std::vector<size_t> renumber(const std::vector<size_t>& vec, const std::vector<s
 	return result;
 }
 
-template <typename T>
-std::vector<T> reorder(const std::vector<T>& vec, const std::vector<size_t>& renumbering)
+template <typename T, typename Allocator>
+std::vector<T, Allocator> reorder(const std::vector<T, Allocator>& vec, const std::vector<size_t>& renumbering)
 {
 	assert(vec.size() == renumbering.size());
-	std::vector<T> result;
+	std::vector<T, Allocator> result;
 	result.resize(vec.size());
 	for (size_t i = 0; i < vec.size(); i++)
 	{
@@ -905,8 +952,8 @@ std::vector<T> reorder(const std::vector<T>& vec, const std::vector<size_t>& ren
 void AlignmentGraph::RenumberAmbiguousToEnd()
 {
 	assert(nodeSequences.size() + ambiguousNodeSequences.size() == nodeLength.size());
-	assert(inNeighbors.size() == nodeLength.size());
-	assert(outNeighbors.size() == nodeLength.size());
+	assert(buildInNeighbors.size() == nodeLength.size());
+	assert(buildOutNeighbors.size() == nodeLength.size());
 	assert(reverse.size() == nodeLength.size());
 	assert(nodeIDs.size() == nodeLength.size());
 	assert(ambiguousNodes.size() == nodeLength.size());
@@ -945,31 +992,31 @@ void AlignmentGraph::RenumberAmbiguousToEnd()
 	nodeLength = reorder(nodeLength, renumbering);
 	nodeOffset = reorder(nodeOffset, renumbering);
 	nodeIDs = reorder(nodeIDs, renumbering);
-	inNeighbors = reorder(inNeighbors, renumbering);
-	outNeighbors = reorder(outNeighbors, renumbering);
+	buildInNeighbors = reorder(buildInNeighbors, renumbering);
+	buildOutNeighbors = reorder(buildOutNeighbors, renumbering);
 	reverse = reorder(reverse, renumbering);
 	for (auto& pair : nodeLookup)
 	{
 		pair.second = renumber(pair.second, renumbering);
 	}
-	assert(inNeighbors.size() == outNeighbors.size());
-	for (size_t i = 0; i < inNeighbors.size(); i++)
+	assert(buildInNeighbors.size() == buildOutNeighbors.size());
+	for (size_t i = 0; i < buildInNeighbors.size(); i++)
 	{
-		inNeighbors[i] = renumber(inNeighbors[i], renumbering);
-		outNeighbors[i] = renumber(outNeighbors[i], renumbering);
+		buildInNeighbors[i] = renumber(buildInNeighbors[i], renumbering);
+		buildOutNeighbors[i] = renumber(buildOutNeighbors[i], renumbering);
 	}
 
 #ifndef NDEBUG
-	assert(inNeighbors.size() == outNeighbors.size());
-	for (size_t i = 0; i < inNeighbors.size(); i++)
+	assert(buildInNeighbors.size() == buildOutNeighbors.size());
+	for (size_t i = 0; i < buildInNeighbors.size(); i++)
 	{
-		for (auto neighbor : inNeighbors[i])
+		for (auto neighbor : buildInNeighbors[i])
 		{
-			assert(std::find(outNeighbors[neighbor].begin(), outNeighbors[neighbor].end(), i) != outNeighbors[neighbor].end());
+			assert(std::find(buildOutNeighbors[neighbor].begin(), buildOutNeighbors[neighbor].end(), i) != buildOutNeighbors[neighbor].end());
 		}
-		for (auto neighbor : outNeighbors[i])
+		for (auto neighbor : buildOutNeighbors[i])
 		{
-			assert(std::find(inNeighbors[neighbor].begin(), inNeighbors[neighbor].end(), i) != inNeighbors[neighbor].end());
+			assert(std::find(buildInNeighbors[neighbor].begin(), buildInNeighbors[neighbor].end(), i) != buildInNeighbors[neighbor].end());
 		}
 	}
 	for (auto pair : nodeLookup)
@@ -1108,4 +1155,253 @@ size_t AlignmentGraph::ComponentSize() const
 size_t AlignmentGraph::SizeInBP() const
 {
 	return bpSize;
-}
\ No newline at end of file
+}
+const uint64_t GraphSnapshotMagic = 0x4741424E47524150;
+// increment when the layout of the snapshot changes
+const uint64_t GraphSnapshotVersion = 3;
+// arrays start at multiples of this in the file so they can be used in place from the mapping
+const size_t GraphSnapshotAlignment = 64;
+
+SnapshotMapping::SnapshotMapping(const char* start, size_t size) :
+start(start),
+size(size)
+{
+}
+
+SnapshotMapping::~SnapshotMapping()
+{
+	munmap((void*)start, size);
+}
+
+class SnapshotWriter
+{
+public:
+	SnapshotWriter(std::ostream& file) : file(file), written(0) {}
+	template <typename T>
+	void write(T value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value);
+		writeBytes((const char*)&value, sizeof(T));
+	}
+	template <typename T, typename Allocator>
+	void write(const std::vector<T, Allocator>& vec)
+	{
+		static_assert(std::is_trivially_copyable<T>::value);
+		write<uint64_t>(vec.size());
+		char padding[GraphSnapshotAlignment] {};
+		writeBytes(padding, (GraphSnapshotAlignment - written % GraphSnapshotAlignment) % GraphSnapshotAlignment);
+		writeBytes((const char*)vec.data(), vec.size() * sizeof(T));
+	}
+	void write(const std::vector<bool>& vec)
+	{
+		write<uint64_t>(vec.size());
+		for (size_t i = 0; i < vec.size(); i++) write<uint8_t>(vec[i] ? 1 : 0);
+	}
+	void write(const std::string& str)
+	{
+		write<uint64_t>(str.size());
+		writeBytes(str.data(), str.size());
+	}
+private:
+	void writeBytes(const char* data, size_t size)
+	{
+		file.write(data, size);
+		written += size;
+	}
+	std::ostream& file;
+	size_t written;
+};
+
+class SnapshotReader
+{
+public:
+	SnapshotReader(std::shared_ptr<SnapshotMapping> mapping) : mapping(mapping), pos(mapping->start), end(mapping->start + mapping->size) {}
+	template <typename T>
+	T read()
+	{
+		static_assert(std::is_trivially_copyable<T>::value);
+		T result;
+		readBytes((char*)&result, sizeof(T));
+		return result;
+	}
+	template <typename T>
+	void read(std::vector<T>& vec)
+	{
+		const T* data;
+		size_t size = readArray(data);
+		vec.assign(data, data + size);
+	}
+	//the vector uses the array in the mapping as its storage
+	template <typename T>
+	void read(SnapshotVector<T>& vec)
+	{
+		const T* data;
+		size_t size = readArray(data);
+		SnapshotVector<T> mapped { SnapshotAllocator<T> { mapping, data, size } };
+		mapped.reserve(size);
+		mapped.resize(size);
+		//the standard library may ask for a different capacity than reserved, then the array is copied
+		if (mapped.data() != data) std::copy(data, data + size, mapped.begin());
+		vec = std::move(mapped);
+	}
+	void read(std::vector<bool>& vec)
+	{
+		size_t size = read<uint64_t>();
+		if (size > (size_t)(end - pos)) throw CommonUtils::InvalidGraphException { "Graph snapshot is truncated" };
+		vec.resize(size);
+		for (size_t i = 0; i < size; i++) vec[i] = read<uint8_t>() != 0;
+	}
+	void read(std::string& str)
+	{
+		size_t size = read<uint64_t>();
+		if (size > (size_t)(end - pos)) throw CommonUtils::InvalidGraphException { "Graph snapshot is truncated" };
+		str.assign(pos, size);
+		pos += size;
+	}
+private:
+	template <typename T>
+	size_t readArray(const T*& data)
+	{
+		static_assert(std::is_trivially_copyable<T>::value);
+		static_assert(GraphSnapshotAlignment % alignof(T) == 0);
+		size_t size = read<uint64_t>();
+		size_t padding = (GraphSnapshotAlignment - (pos - mapping->start) % GraphSnapshotAlignment) % GraphSnapshotAlignment;
+		if (padding > (size_t)(end - pos)) throw CommonUtils::InvalidGraphException { "Graph snapshot is truncated" };
+		pos += padding;
+		if (size > (size_t)(end - pos) / sizeof(T)) throw CommonUtils::InvalidGraphException { "Graph snapshot is truncated" };
+		data = (const T*)pos;
+		pos += size * sizeof(T);
+		return size;
+	}
+	void readBytes(char* target, size_t size)
+	{
+		if (size > (size_t)(end - pos)) throw CommonUtils::InvalidGraphException { "Graph snapshot is truncated" };
+		memcpy(target, pos, size);
+		pos += size;
+	}
+	std::shared_ptr<SnapshotMapping> mapping;
+	const char* pos;
+	const char* end;
+};
+
+void AlignmentGraph::SaveSnapshot(const std::string& filename) const
+{
+	assert(finalized);
+	// other processes may be loading the snapshot, so write it elsewhere and move it into place once complete
+	std::string tempFile = CommonUtils::TemporaryFileName(filename);
+	std::ofstream file { tempFile, std::ios::binary };
+	if (!file.good()) throw CommonUtils::InvalidGraphException { "Could not write graph snapshot to " + tempFile };
+	SnapshotWriter writer { file };
+	writer.write<uint64_t>(GraphSnapshotMagic);
+	writer.write<uint64_t>(GraphSnapshotVersion);
+	writer.write<uint64_t>(bpSize);
+	writer.write<uint64_t>(firstAmbiguous);
+	writer.write<uint64_t>(DBGoverlap);
+	writer.write(nodeLength);
+	writer.write(nodeOffset);
+	writer.write(nodeIDs);
+	writer.write(reverse);
+	writer.write(linearizable);
+	writer.write(nodeSequences);
+	writer.write(ambiguousNodeSequences);
+	writer.write(componentNumber);
+	writer.write(chainNumber);
+	writer.write(chainApproxPos);
+	writer.write(inNeighbors.start);
+	writer.write(inNeighbors.targets);
+	writer.write(outNeighbors.start);
+	writer.write(outNeighbors.targets);
+	writer.write<uint64_t>(nodeLookup.size());
+	for (const auto& pair : nodeLookup)
+	{
+		writer.write<int>(pair.first);
+		writer.write(pair.second);
+		writer.write<uint64_t>(originalNodeSize.at(pair.first));
+	}
+	writer.write<uint64_t>(originalNodeName.size());
+	for (const auto& pair : originalNodeName)
+	{
+		writer.write<int>(pair.first);
+		writer.write(pair.second);
+	}
+	file.close();
+	if (file.fail())
+	{
+		std::remove(tempFile.c_str());
+		throw CommonUtils::InvalidGraphException { "Could not write graph snapshot to " + tempFile };
+	}
+	if (std::rename(tempFile.c_str(), filename.c_str()) != 0)
+	{
+		std::remove(tempFile.c_str());
+		throw CommonUtils::InvalidGraphException { "Could not move graph snapshot from " + tempFile + " to " + filename };
+	}
+}
+
+AlignmentGraph AlignmentGraph::LoadSnapshot(const std::string& filename)
+{
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd == -1) throw CommonUtils::InvalidGraphException { "Could not open graph snapshot " + filename };
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) == -1)
+	{
+		close(fd);
+		throw CommonUtils::InvalidGraphException { "Could not open graph snapshot " + filename };
+	}
+	size_t fileSize = fileStat.st_size;
+	// shared and read only, so processes loading the same snapshot use the same physical pages
+	void* mapped = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mapped == MAP_FAILED) throw CommonUtils::InvalidGraphException { "Could not map graph snapshot " + filename };
+	// the arrays of the graph keep the mapping alive
+	auto mapping = std::make_shared<SnapshotMapping>((const char*)mapped, fileSize);
+	AlignmentGraph result;
+	{
+		SnapshotReader reader { mapping };
+		if (reader.read<uint64_t>() != GraphSnapshotMagic) throw CommonUtils::InvalidGraphException { filename + " is not a graph snapshot" };
+		if (reader.read<uint64_t>() != GraphSnapshotVersion) throw CommonUtils::InvalidGraphException { "Graph snapshot " + filename + " was written by an incompatible version" };
+		result.bpSize = reader.read<uint64_t>();
+		result.firstAmbiguous = reader.read<uint64_t>();
+		result.DBGoverlap = reader.read<uint64_t>();
+		reader.read(result.nodeLength);
+		reader.read(result.nodeOffset);
+		reader.read(result.nodeIDs);
+		reader.read(result.reverse);
+		reader.read(result.linearizable);
+		reader.read(result.nodeSequences);
+		reader.read(result.ambiguousNodeSequences);
+		reader.read(result.componentNumber);
+		reader.read(result.chainNumber);
+		reader.read(result.chainApproxPos);
+		for (auto neighbors : { &result.inNeighbors, &result.outNeighbors })
+		{
+			reader.read(neighbors->start);
+			reader.read(neighbors->targets);
+			if (neighbors->start.size() != result.nodeLength.size()+1 || neighbors->start.back() != neighbors->targets.size()) throw CommonUtils::InvalidGraphException { "Graph snapshot " + filename + " is corrupted" };
+		}
+		size_t numOriginalNodes = reader.read<uint64_t>();
+		result.nodeLookup.reserve(numOriginalNodes);
+		result.originalNodeSize.reserve(numOriginalNodes);
+		for (size_t i = 0; i < numOriginalNodes; i++)
+		{
+			int nodeId = reader.read<int>();
+			reader.read(result.nodeLookup[nodeId]);
+			result.originalNodeSize[nodeId] = reader.read<uint64_t>();
+		}
+		size_t numNames = reader.read<uint64_t>();
+		result.originalNodeName.reserve(numNames);
+		for (size_t i = 0; i < numNames; i++)
+		{
+			int nodeId = reader.read<int>();
+			reader.read(result.originalNodeName[nodeId]);
+		}
+	}
+	if (result.nodeOffset.size() != result.nodeLength.size() || result.nodeIDs.size() != result.nodeLength.size() || result.reverse.size() != result.nodeLength.size() || result.nodeSequences.size() + result.ambiguousNodeSequences.size() != result.nodeLength.size())
+	{
+		throw CommonUtils::InvalidGraphException { "Graph snapshot " + filename + " is corrupted" };
+	}
+	result.finalized = true;
+	std::cout << result.nodeLookup.size() << " original nodes" << std::endl;
+	std::cout << result.nodeLength.size() << " split nodes" << std::endl;
+	std::cout << result.ambiguousNodeSequences.size() << " ambiguous split nodes" << std::endl;
+	return result;
+}
@@ -7,9 +7,95 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <tuple>
+#include <string>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <phmap.h>
 #include "ThreadReadAssertion.h"
 
+//a read-only mmap of a graph snapshot, shared by the arrays that point into it
+class SnapshotMapping
+{
+public:
+	SnapshotMapping(const char* start, size_t size);
+	~SnapshotMapping();
+	SnapshotMapping(const SnapshotMapping& other) = delete;
+	SnapshotMapping& operator=(const SnapshotMapping& other) = delete;
+	bool contains(const void* ptr) const
+	{
+		return (const char*)ptr >= start && (const char*)ptr < start + size;
+	}
+	//each array in the mapping can be handed to one vector only, later allocations come from the heap
+	bool claim(const void* ptr)
+	{
+		std::lock_guard<std::mutex> guard { claimMutex };
+		return claimed.insert(ptr).second;
+	}
+	const char* const start;
+	const size_t size;
+private:
+	std::mutex claimMutex;
+	std::unordered_set<const void*> claimed;
+};
+
+//allocates from the heap, except that a vector loaded from a snapshot gets the array in the mapping
+//as its storage without copying or touching it, so processes loading the same snapshot share the pages.
+//vectors backed by the mapping are read only
+template <typename T>
+class SnapshotAllocator
+{
+public:
+	typedef T value_type;
+	typedef std::true_type propagate_on_container_move_assignment;
+	typedef std::true_type propagate_on_container_swap;
+	SnapshotAllocator() = default;
+	SnapshotAllocator(std::shared_ptr<SnapshotMapping> mapping, const T* array, size_t count) : mapping(mapping), array(array), count(count) {}
+	template <typename U>
+	SnapshotAllocator(const SnapshotAllocator<U>& other) : mapping(other.mapping) {}
+	T* allocate(size_t n)
+	{
+		if (mapping != nullptr && array != nullptr && n == count && mapping->claim(array)) return (T*)array;
+		return std::allocator<T>{}.allocate(n);
+	}
+	void deallocate(T* ptr, size_t n)
+	{
+		if (mapping != nullptr && mapping->contains(ptr)) return;
+		std::allocator<T>{}.deallocate(ptr, n);
+	}
+	//default construction in the mapping keeps the stored value
+	template <typename U>
+	void construct(U* ptr)
+	{
+		if (mapping != nullptr && mapping->contains(ptr)) return;
+		::new((void*)ptr) U();
+	}
+	template <typename U, typename... Args>
+	void construct(U* ptr, Args&&... args)
+	{
+		::new((void*)ptr) U(std::forward<Args>(args)...);
+	}
+	//copies own their data
+	SnapshotAllocator select_on_container_copy_construction() const
+	{
+		return SnapshotAllocator {};
+	}
+	template <typename U>
+	bool operator==(const SnapshotAllocator<U>& other) const { return mapping == other.mapping; }
+	template <typename U>
+	bool operator!=(const SnapshotAllocator<U>& other) const { return mapping != other.mapping; }
+private:
+	std::shared_ptr<SnapshotMapping> mapping;
+	const T* array = nullptr;
+	size_t count = 0;
+	template <typename U>
+	friend class SnapshotAllocator;
+};
+
+//the arrays of a finalized graph that are stored in snapshots
+template <typename T>
+using SnapshotVector = std::vector<T, SnapshotAllocator<T>>;
+
 
 class AlignmentGraph
 {
@@ -77,6 +163,38 @@ public:
 		size_t seqPos;
 	};
 
+	//compressed sparse row adjacency, neighbors of node i are targets[start[i]] .. targets[start[i+1]-1]
+	class NeighborList
+	{
+	public:
+		class Neighbors
+		{
+		public:
+			Neighbors(const uint32_t* first, const uint32_t* last) : first(first), last(last) {};
+			const uint32_t* begin() const { return first; }
+			const uint32_t* end() const { return last; }
+			size_t size() const { return last - first; }
+			bool empty() const { return first == last; }
+			size_t operator[](size_t index) const { assert(index < size()); return first[index]; }
+		private:
+			const uint32_t* first;
+			const uint32_t* last;
+		};
+		NeighborList();
+		NeighborList(const std::vector<std::vector<size_t>>& neighbors);
+		Neighbors operator[](size_t node) const
+		{
+			assert(node+1 < start.size());
+			return Neighbors { targets.data() + start[node], targets.data() + start[node+1] };
+		}
+		size_t size() const { return start.size()-1; }
+		size_t SizeInBytes() const;
+	private:
+		SnapshotVector<size_t> start;
+		SnapshotVector<uint32_t> targets;
+		friend class AlignmentGraph;
+	};
+
 	class SeedHit
 	{
 	public:
@@ -106,6 +224,8 @@ public:
 	size_t ComponentSize() const;
 	static AlignmentGraph DummyGraph();
 	size_t getDBGoverlap() const;
+	void SaveSnapshot(const std::string& filename) const;
+	static AlignmentGraph LoadSnapshot(const std::string& filename);
 
 private:
 	void fixChainApproxPos(const size_t start);
@@ -118,23 +238,26 @@ private:
 	void AddNode(int nodeId, int offset, const std::string& sequence, bool reverseNode);
 	void RenumberAmbiguousToEnd();
 	void doComponentOrder();
-	std::vector<size_t> nodeLength;
+	SnapshotVector<size_t> nodeLength;
 	std::unordered_map<int, std::vector<size_t>> nodeLookup;
 	std::unordered_map<int, size_t> originalNodeSize;
 	std::unordered_map<int, std::string> originalNodeName;
-	std::vector<size_t> nodeOffset;
-	std::vector<int> nodeIDs;
-	std::vector<std::vector<size_t>> inNeighbors;
-	std::vector<std::vector<size_t>> outNeighbors;
+	SnapshotVector<size_t> nodeOffset;
+	SnapshotVector<int> nodeIDs;
+	NeighborList inNeighbors;
+	NeighborList outNeighbors;
+	//only used while adding nodes and edges, moved to inNeighbors and outNeighbors in Finalize
+	std::vector<std::vector<size_t>> buildInNeighbors;
+	std::vector<std::vector<size_t>> buildOutNeighbors;
 	std::vector<bool> reverse;
 	std::vector<bool> linearizable;
-	std::vector<NodeChunkSequence> nodeSequences;
+	SnapshotVector<NodeChunkSequence> nodeSequences;
 	size_t bpSize;
-	std::vector<AmbiguousChunkSequence> ambiguousNodeSequences;
+	SnapshotVector<AmbiguousChunkSequence> ambiguousNodeSequences;
 	std::vector<bool> ambiguousNodes;
-	std::vector<size_t> componentNumber;
-	std::vector<size_t> chainNumber;
-	std::vector<size_t> chainApproxPos;
+	SnapshotVector<size_t> componentNumber;
+	SnapshotVector<size_t> chainNumber;
+	SnapshotVector<size_t> chainApproxPos;
 	size_t firstAmbiguous;
 	size_t DBGoverlap;
 	bool finalized;
@@ -0,0 +1,119 @@
+#include <immintrin.h>
+#include <limits>
+#include "BatchedSliceKernel.h"
+
+namespace BatchedSliceKernel
+{
+	typedef void(*KernelFunction)(size_t, const uint64_t*, uint64_t*, uint64_t*, uint64_t*, uint64_t*);
+
+	//same as GraphAlignerBitvectorCommon::getNextSlice
+	void nextSlicesScalar(size_t count, const uint64_t* EqIn, uint64_t* VP, uint64_t* VN, uint64_t* hinP, uint64_t* hinN)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			uint64_t Eq = EqIn[i];
+			uint64_t Xv = Eq | VN[i];
+			Eq |= hinN[i];
+			uint64_t Xh = (((Eq & VP[i]) + VP[i]) ^ VP[i]) | Eq;
+			uint64_t Ph = VN[i] | ~(Xh | VP[i]);
+			uint64_t Mh = VP[i] & Xh;
+			uint64_t tempMh = (Mh << 1) | hinN[i];
+			uint64_t tempPh = (Ph << 1) | hinP[i];
+			VP[i] = tempMh | ~(Xv | tempPh);
+			VN[i] = tempPh & Xv;
+			hinN[i] = Mh >> 63;
+			hinP[i] = Ph >> 63;
+		}
+	}
+
+	__attribute__((target("avx2")))
+	void nextSlicesAVX2(size_t count, const uint64_t* EqIn, uint64_t* VP, uint64_t* VN, uint64_t* hinP, uint64_t* hinN)
+	{
+		const __m256i ones = _mm256_set1_epi64x(-1);
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m256i Eq = _mm256_loadu_si256((const __m256i*)(EqIn + i));
+			__m256i vp = _mm256_loadu_si256((const __m256i*)(VP + i));
+			__m256i vn = _mm256_loadu_si256((const __m256i*)(VN + i));
+			__m256i hp = _mm256_loadu_si256((const __m256i*)(hinP + i));
+			__m256i hn = _mm256_loadu_si256((const __m256i*)(hinN + i));
+			__m256i Xv = _mm256_or_si256(Eq, vn);
+			Eq = _mm256_or_si256(Eq, hn);
+			__m256i Xh = _mm256_or_si256(_mm256_xor_si256(_mm256_add_epi64(_mm256_and_si256(Eq, vp), vp), vp), Eq);
+			__m256i Ph = _mm256_or_si256(vn, _mm256_xor_si256(_mm256_or_si256(Xh, vp), ones));
+			__m256i Mh = _mm256_and_si256(vp, Xh);
+			__m256i tempMh = _mm256_or_si256(_mm256_slli_epi64(Mh, 1), hn);
+			__m256i tempPh = _mm256_or_si256(_mm256_slli_epi64(Ph, 1), hp);
+			vp = _mm256_or_si256(tempMh, _mm256_xor_si256(_mm256_or_si256(Xv, tempPh), ones));
+			vn = _mm256_and_si256(tempPh, Xv);
+			_mm256_storeu_si256((__m256i*)(VP + i), vp);
+			_mm256_storeu_si256((__m256i*)(VN + i), vn);
+			_mm256_storeu_si256((__m256i*)(hinP + i), _mm256_srli_epi64(Ph, 63));
+			_mm256_storeu_si256((__m256i*)(hinN + i), _mm256_srli_epi64(Mh, 63));
+		}
+		nextSlicesScalar(count - i, EqIn + i, VP + i, VN + i, hinP + i, hinN + i);
+	}
+
+	__attribute__((target("avx512f")))
+	void nextSlicesAVX512(size_t count, const uint64_t* EqIn, uint64_t* VP, uint64_t* VN, uint64_t* hinP, uint64_t* hinN)
+	{
+		//unmasked shift intrinsics trigger -Wmaybe-uninitialized in gcc's headers, use add and zero-masked shift instead
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m512i Eq = _mm512_loadu_si512(EqIn + i);
+			__m512i vp = _mm512_loadu_si512(VP + i);
+			__m512i vn = _mm512_loadu_si512(VN + i);
+			__m512i hp = _mm512_loadu_si512(hinP + i);
+			__m512i hn = _mm512_loadu_si512(hinN + i);
+			__m512i Xv = _mm512_or_si512(Eq, vn);
+			Eq = _mm512_or_si512(Eq, hn);
+			__m512i Xh = _mm512_or_si512(_mm512_xor_si512(_mm512_add_epi64(_mm512_and_si512(Eq, vp), vp), vp), Eq);
+			//0xF1 = a | ~(b | c)
+			__m512i Ph = _mm512_ternarylogic_epi64(vn, Xh, vp, 0xF1);
+			__m512i Mh = _mm512_and_si512(vp, Xh);
+			__m512i tempMh = _mm512_or_si512(_mm512_add_epi64(Mh, Mh), hn);
+			__m512i tempPh = _mm512_or_si512(_mm512_add_epi64(Ph, Ph), hp);
+			vp = _mm512_ternarylogic_epi64(tempMh, Xv, tempPh, 0xF1);
+			vn = _mm512_and_si512(tempPh, Xv);
+			_mm512_storeu_si512(VP + i, vp);
+			_mm512_storeu_si512(VN + i, vn);
+			_mm512_storeu_si512(hinP + i, _mm512_maskz_srli_epi64(0xFF, Ph, 63));
+			_mm512_storeu_si512(hinN + i, _mm512_maskz_srli_epi64(0xFF, Mh, 63));
+		}
+		nextSlicesAVX2(count - i, EqIn + i, VP + i, VN + i, hinP + i, hinN + i);
+	}
+
+	struct Implementation
+	{
+		KernelFunction function;
+		const char* name;
+		size_t laneWidth;
+	};
+
+	Implementation pickImplementation()
+	{
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx512f")) return Implementation { nextSlicesAVX512, "AVX-512", 8 };
+		if (__builtin_cpu_supports("avx2")) return Implementation { nextSlicesAVX2, "AVX2", 4 };
+		return Implementation { nextSlicesScalar, "scalar", std::numeric_limits<size_t>::max() };
+	}
+
+	const Implementation selected = pickImplementation();
+
+	void NextSlices(size_t count, const uint64_t* Eq, uint64_t* VP, uint64_t* VN, uint64_t* hinP, uint64_t* hinN)
+	{
+		selected.function(count, Eq, VP, VN, hinP, hinN);
+	}
+
+	const char* SelectedImplementation()
+	{
+		return selected.name;
+	}
+
+	size_t LaneWidth()
+	{
+		return selected.laneWidth;
+	}
+}
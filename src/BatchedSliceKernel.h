@@ -0,0 +1,19 @@
+#ifndef BatchedSliceKernel_h
+#define BatchedSliceKernel_h
+
+#include <cstdint>
+#include <cstddef>
+
+//Myers' bit-parallel step for several independent 64-row slices at once, for a driver which aligns several reads in lock-step.
+//uses AVX-512 or AVX2 if the CPU supports them, otherwise a scalar loop. the aligner doesn't use it yet
+namespace BatchedSliceKernel
+{
+	//one column step for each of the count lanes. VP and VN are updated in place.
+	//hinP and hinN are the horizontal input on entry and the horizontal output of the last row on return
+	void NextSlices(size_t count, const uint64_t* Eq, uint64_t* VP, uint64_t* VN, uint64_t* hinP, uint64_t* hinN);
+	const char* SelectedImplementation();
+	//lanes per vector of the selected implementation, SIZE_MAX for the scalar one
+	size_t LaneWidth();
+}
+
+#endif
@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "KmerHashKernel.h"
+#include "KmerIterators.h"
+
+//time per base of the k-mer iterators on a random sequence, best of several passes
+
+struct IteratorResult
+{
+	size_t kmers;
+	uint64_t checksum;
+	double nsPerBase;
+};
+
+template <typename IterateF>
+IteratorResult timeIterator(const std::string& sequence, size_t passes, IterateF iterate)
+{
+	IteratorResult result { 0, 0, 0 };
+	double bestNs = 0;
+	for (size_t pass = 0; pass < passes; pass++)
+	{
+		size_t kmers = 0;
+		uint64_t checksum = 0;
+		auto timeStart = std::chrono::steady_clock::now();
+		iterate([&kmers, &checksum](size_t pos, size_t kmer)
+		{
+			kmers += 1;
+			checksum += (kmer * 0x9E3779B97F4A7C15) ^ pos;
+		});
+		auto timeEnd = std::chrono::steady_clock::now();
+		double ns = std::chrono::duration_cast<std::chrono::nanoseconds>(timeEnd - timeStart).count();
+		if (pass == 0 || ns < bestNs) bestNs = ns;
+		result.kmers = kmers;
+		result.checksum = checksum;
+	}
+	result.nsPerBase = bestNs / sequence.size();
+	return result;
+}
+
+void printResult(const std::string& name, const IteratorResult& result)
+{
+	std::cout << name << "\t" << result.kmers << "\t" << std::hex << result.checksum << std::dec << "\t" << result.nsPerBase << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	size_t sequenceLength = 10000000;
+	size_t passes = 5;
+	if (argc >= 2) sequenceLength = std::stoull(argv[1]);
+	if (argc >= 3) passes = std::stoull(argv[2]);
+	if (sequenceLength == 0 || passes == 0)
+	{
+		std::cerr << "usage: BenchmarkMinimizers [sequence length (default 10000000)] [passes (default 5)]" << std::endl;
+		std::exit(1);
+	}
+	//uniform random bases with an N now and then so the iterators restart
+	std::mt19937_64 rng { 1 };
+	std::string sequence;
+	sequence.resize(sequenceLength);
+	for (size_t i = 0; i < sequenceLength; i++)
+	{
+		sequence[i] = (rng() % 10000 == 0) ? 'N' : "ACGT"[rng() % 4];
+	}
+	std::cerr << sequenceLength << "bp, best of " << passes << " passes, hash kernel " << KmerHashKernel::SelectedImplementation() << std::endl;
+
+	std::cout << "iterator\tk-mers\tchecksum\tns/base" << std::endl;
+	printResult("read k-mers k15", timeIterator(sequence, passes, [&sequence](auto callback) { iterateKmers(sequence, 15, 20, callback); }));
+	printResult("minimizers k15 w20", timeIterator(sequence, passes, [&sequence](auto callback) { iterateMinimizersReal(sequence, 15, 20, callback); }));
+	printResult("minimizers k19 w30", timeIterator(sequence, passes, [&sequence](auto callback) { iterateMinimizersReal(sequence, 19, 30, callback); }));
+	printResult("syncmers k15 s9", timeIterator(sequence, passes, [&sequence](auto callback) { iterateSyncmers(sequence, 15, 9, callback); }));
+	printResult("syncmers k19 s7", timeIterator(sequence, passes, [&sequence](auto callback) { iterateSyncmers(sequence, 19, 7, callback); }));
+
+	//the hash alone, on k-mers which are already packed
+	std::vector<uint64_t> kmers;
+	std::vector<uint64_t> hashes;
+	kmers.resize(KmerHashBlockSize);
+	hashes.resize(KmerHashBlockSize);
+	for (size_t i = 0; i < KmerHashBlockSize; i++) kmers[i] = rng() & 0x3FFFFFFF;
+	double bestNs[2] = { 0, 0 };
+	uint64_t checksum = 0;
+	for (size_t pass = 0; pass < passes; pass++)
+	{
+		for (size_t vectorized = 0; vectorized < 2; vectorized++)
+		{
+			auto timeStart = std::chrono::steady_clock::now();
+			for (size_t block = 0; block < sequenceLength / KmerHashBlockSize; block++)
+			{
+				kmers[block % KmerHashBlockSize] ^= block;
+				if (vectorized)
+				{
+					KmerHashKernel::HashKmers(KmerHashBlockSize, kmers.data(), hashes.data());
+				}
+				else
+				{
+					for (size_t i = 0; i < KmerHashBlockSize; i++) hashes[i] = KmerHashKernel::Hash(kmers[i]);
+				}
+				checksum ^= hashes[block % KmerHashBlockSize];
+			}
+			auto timeEnd = std::chrono::steady_clock::now();
+			double ns = std::chrono::duration_cast<std::chrono::nanoseconds>(timeEnd - timeStart).count();
+			if (pass == 0 || ns < bestNs[vectorized]) bestNs[vectorized] = ns;
+		}
+	}
+	std::cout << "hash scalar\t" << sequenceLength << "\t-\t" << bestNs[0] / sequenceLength << std::endl;
+	std::cout << "hash " << KmerHashKernel::SelectedImplementation() << "\t" << sequenceLength << "\t" << std::hex << checksum << std::dec << "\t" << bestNs[1] / sequenceLength << std::endl;
+}
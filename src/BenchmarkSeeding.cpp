@@ -0,0 +1,158 @@
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+#include "AlignmentGraph.h"
+#include "BigraphToDigraph.h"
+#include "CommonUtils.h"
+#include "GfaGraph.h"
+#include "GraphAlignerWrapper.h"
+#include "MinimizerSeeder.h"
+#include "ThreadReadAssertion.h"
+#include "fastqloader.h"
+
+//seeds and aligns the same reads with window minimizers and with closed syncmers and reports the seeds and extensions per read
+//and the throughput. the times include seeding, chaining and extension but not building the index. with --seeding-only
+//only the index lookups are timed, over several passes of the reads
+
+const double minimizerSeedDensity = 10;
+const double minimizerKeepFraction = 0.999;
+const size_t seedingOnlyPasses = 5;
+
+struct BenchmarkResult
+{
+	size_t indexMilliseconds;
+	size_t milliseconds;
+	size_t seeds;
+	size_t seedsExtended;
+	size_t alignedBp;
+	size_t failed;
+};
+
+BenchmarkResult benchmark(const AlignmentGraph& graph, const std::vector<FastQ>& reads, size_t minimizerLength, size_t windowSize, size_t syncmerLength, size_t bandwidth)
+{
+	BenchmarkResult result { 0, 0, 0, 0, 0, 0 };
+	auto indexStart = std::chrono::steady_clock::now();
+	MinimizerSeeder seeder { graph, minimizerLength, windowSize, syncmerLength, 1, 256, minimizerKeepFraction, "" };
+	auto indexEnd = std::chrono::steady_clock::now();
+	result.indexMilliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(indexEnd - indexStart).count();
+	GraphAlignerCommon<size_t, int32_t, uint64_t>::AlignerGraphsizedState reusableState { graph, bandwidth, true };
+	auto timeStart = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < reads.size(); i++)
+	{
+		assertSetNoRead(reads[i].seq_id);
+		std::vector<SeedHit> seeds = seeder.getSeeds(reads[i].sequence, minimizerSeedDensity);
+		result.seeds += seeds.size();
+		if (seeds.size() == 0)
+		{
+			result.failed += 1;
+			continue;
+		}
+		OrderSeeds(graph, seeds);
+		try
+		{
+			auto alignments = AlignOneWay(graph, reads[i].seq_id, reads[i].sequence, bandwidth, 0, std::numeric_limits<size_t>::max(), true, true, seeds, reusableState, true, false, false, 1, -1, false, .5, 0, 0);
+			result.seedsExtended += alignments.seedsExtended;
+			for (const auto& aln : alignments.alignments)
+			{
+				result.alignedBp += aln.alignmentLength();
+			}
+			if (alignments.alignments.size() == 0) result.failed += 1;
+		}
+		catch (const ThreadReadAssertion::AssertionFailure& a)
+		{
+			reusableState.clear();
+			result.failed += 1;
+		}
+	}
+	auto timeEnd = std::chrono::steady_clock::now();
+	result.milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(timeEnd - timeStart).count();
+	return result;
+}
+
+BenchmarkResult benchmarkSeeding(const AlignmentGraph& graph, const std::vector<FastQ>& reads, size_t minimizerLength, size_t windowSize, size_t syncmerLength)
+{
+	BenchmarkResult result { 0, 0, 0, 0, 0, 0 };
+	auto indexStart = std::chrono::steady_clock::now();
+	MinimizerSeeder seeder { graph, minimizerLength, windowSize, syncmerLength, 1, 256, minimizerKeepFraction, "" };
+	auto indexEnd = std::chrono::steady_clock::now();
+	result.indexMilliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(indexEnd - indexStart).count();
+	auto timeStart = std::chrono::steady_clock::now();
+	for (size_t pass = 0; pass < seedingOnlyPasses; pass++)
+	{
+		for (size_t i = 0; i < reads.size(); i++)
+		{
+			std::vector<SeedHit> seeds = seeder.getSeeds(reads[i].sequence, minimizerSeedDensity);
+			result.seeds += seeds.size();
+			if (seeds.size() == 0) result.failed += 1;
+		}
+	}
+	auto timeEnd = std::chrono::steady_clock::now();
+	result.milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(timeEnd - timeStart).count();
+	result.seeds /= seedingOnlyPasses;
+	result.failed /= seedingOnlyPasses;
+	return result;
+}
+
+void printSeedingResult(const std::string& mode, const BenchmarkResult& result, size_t numReads, size_t readBp)
+{
+	double seconds = std::max(result.milliseconds, (size_t)1) / 1000.0;
+	double reads = std::max(numReads, (size_t)1);
+	std::cout << mode << "\t" << result.indexMilliseconds << "\t" << result.milliseconds << "\t" << (numReads * seedingOnlyPasses / seconds) << "\t" << (readBp * seedingOnlyPasses / seconds / 1000000) << "\t" << (result.seeds / reads) << "\t" << result.failed << std::endl;
+}
+
+void printResult(const std::string& mode, const BenchmarkResult& result, size_t numReads)
+{
+	double seconds = std::max(result.milliseconds, (size_t)1) / 1000.0;
+	double reads = std::max(numReads, (size_t)1);
+	std::cout << mode << "\t" << result.indexMilliseconds << "\t" << result.milliseconds << "\t" << (numReads / seconds) << "\t" << (result.seeds / reads) << "\t" << (result.seedsExtended / reads) << "\t" << result.alignedBp << "\t" << result.failed << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	bool seedingOnly = argc >= 2 && std::string { argv[1] } == "--seeding-only";
+	if (seedingOnly)
+	{
+		argv++;
+		argc--;
+	}
+	if (argc < 3)
+	{
+		std::cerr << "usage: BenchmarkSeeding [--seeding-only] graph.gfa|graph.gabin reads.fa [k-mer length (default 15)] [minimizer window size (default 20)] [syncmer s-mer length (default 2k-w-1, same density as the minimizers)] [bandwidth (default 10)]" << std::endl;
+		std::exit(1);
+	}
+	std::string graphFile { argv[1] };
+	std::string readFile { argv[2] };
+	size_t minimizerLength = 15;
+	size_t windowSize = 20;
+	size_t bandwidth = 10;
+	if (argc >= 4) minimizerLength = std::stoull(argv[3]);
+	if (argc >= 5) windowSize = std::stoull(argv[4]);
+	//closed syncmers have a density of 2/(k-s+1) and window minimizers about 2/(w-k+2)
+	size_t syncmerLength = (2 * minimizerLength > windowSize + 1) ? 2 * minimizerLength - windowSize - 1 : 1;
+	if (argc >= 6) syncmerLength = std::stoull(argv[5]);
+	if (argc >= 7) bandwidth = std::stoull(argv[6]);
+	if (minimizerLength * 2 >= sizeof(size_t) * 8 || windowSize < minimizerLength || syncmerLength == 0 || syncmerLength >= minimizerLength)
+	{
+		std::cerr << "need k < 32, w >= k and 0 < s < k" << std::endl;
+		std::exit(1);
+	}
+
+	AlignmentGraph graph = (graphFile.size() >= 6 && graphFile.substr(graphFile.size()-6) == ".gabin") ? AlignmentGraph::LoadSnapshot(graphFile) : DirectedGraph::BuildFromGFA(GfaGraph::LoadFromFile(graphFile, true));
+	auto reads = loadFastqFromFile(readFile, false);
+	size_t readBp = 0;
+	for (const auto& read : reads) readBp += read.sequence.size();
+	std::cerr << reads.size() << " reads, " << readBp << "bp, k " << minimizerLength << ", w " << windowSize << ", s " << syncmerLength << ", bandwidth " << bandwidth << std::endl;
+
+	if (seedingOnly)
+	{
+		std::cout << "mode\tindex ms\tms\treads/s\tMbp/s\tseeds/read\tno seeds" << std::endl;
+		printSeedingResult("minimizer", benchmarkSeeding(graph, reads, minimizerLength, windowSize, 0), reads.size(), readBp);
+		printSeedingResult("syncmer", benchmarkSeeding(graph, reads, minimizerLength, windowSize, syncmerLength), reads.size(), readBp);
+		return 0;
+	}
+	std::cout << "mode\tindex ms\tms\treads/s\tseeds/read\textended/read\taligned bp\tfailed" << std::endl;
+	printResult("minimizer", benchmark(graph, reads, minimizerLength, windowSize, 0, bandwidth), reads.size());
+	printResult("syncmer", benchmark(graph, reads, minimizerLength, windowSize, syncmerLength, bandwidth), reads.size());
+}
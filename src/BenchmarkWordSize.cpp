@@ -0,0 +1,104 @@
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+#include "AlignmentGraph.h"
+#include "BigraphToDigraph.h"
+#include "CommonUtils.h"
+#include "GfaGraph.h"
+#include "GraphAlignerWrapper.h"
+#include "MinimizerSeeder.h"
+#include "ThreadReadAssertion.h"
+#include "fastqloader.h"
+
+//aligns the same reads with the same seeds using each DP word size and reports the extension throughput
+//seeding and seed ordering are done once beforehand and not included in the times
+
+const size_t minimizerLength = 15;
+const size_t minimizerWindowSize = 20;
+const double minimizerSeedDensity = 10;
+const double minimizerKeepFraction = 0.999;
+
+struct BenchmarkResult
+{
+	size_t milliseconds;
+	size_t alignedBp;
+	size_t slices;
+	size_t failed;
+};
+
+template <typename Word>
+BenchmarkResult benchmark(const AlignmentGraph& graph, const std::vector<FastQ>& reads, const std::vector<std::vector<SeedHit>>& seeds, size_t bandwidth, size_t repeats)
+{
+	BenchmarkResult result { 0, 0, 0, 0 };
+	typename GraphAlignerCommon<size_t, int32_t, Word>::AlignerGraphsizedState reusableState { graph, bandwidth, true };
+	auto timeStart = std::chrono::steady_clock::now();
+	for (size_t repeat = 0; repeat < repeats; repeat++)
+	{
+		for (size_t i = 0; i < reads.size(); i++)
+		{
+			if (seeds[i].size() == 0) continue;
+			assertSetNoRead(reads[i].seq_id);
+			result.slices += (reads[i].sequence.size() + WordConfiguration<Word>::WordSize - 1) / WordConfiguration<Word>::WordSize;
+			try
+			{
+				auto alignments = AlignOneWay(graph, reads[i].seq_id, reads[i].sequence, bandwidth, 0, std::numeric_limits<size_t>::max(), true, true, seeds[i], reusableState, true, false, false, 1, -1, false, .5, 0, 0);
+				for (const auto& aln : alignments.alignments)
+				{
+					result.alignedBp += aln.alignmentLength();
+				}
+			}
+			catch (const ThreadReadAssertion::AssertionFailure& a)
+			{
+				reusableState.clear();
+				result.failed += 1;
+			}
+		}
+	}
+	auto timeEnd = std::chrono::steady_clock::now();
+	result.milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(timeEnd - timeStart).count();
+	return result;
+}
+
+void printResult(size_t wordSize, const BenchmarkResult& result, size_t readBp)
+{
+	double seconds = std::max(result.milliseconds, (size_t)1) / 1000.0;
+	std::cout << wordSize << "\t" << result.milliseconds << "\t" << (readBp / seconds / 1000000.0) << "\t" << result.slices << "\t" << result.alignedBp << "\t" << result.failed << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		std::cerr << "usage: BenchmarkWordSize graph.gfa|graph.gabin reads.fa [bandwidth (default 10)] [repeats (default 1)]" << std::endl;
+		std::exit(1);
+	}
+	std::string graphFile { argv[1] };
+	std::string readFile { argv[2] };
+	size_t bandwidth = 10;
+	size_t repeats = 1;
+	if (argc >= 4) bandwidth = std::stoull(argv[3]);
+	if (argc >= 5) repeats = std::stoull(argv[4]);
+
+	AlignmentGraph graph = (graphFile.size() >= 6 && graphFile.substr(graphFile.size()-6) == ".gabin") ? AlignmentGraph::LoadSnapshot(graphFile) : DirectedGraph::BuildFromGFA(GfaGraph::LoadFromFile(graphFile, true));
+	auto reads = loadFastqFromFile(readFile, false);
+	size_t readBp = 0;
+	for (const auto& read : reads) readBp += read.sequence.size();
+	readBp *= repeats;
+
+	MinimizerSeeder seeder { graph, minimizerLength, minimizerWindowSize, 0, 1, 256, minimizerKeepFraction, "" };
+	std::vector<std::vector<SeedHit>> seeds;
+	seeds.reserve(reads.size());
+	for (const auto& read : reads)
+	{
+		seeds.push_back(seeder.getSeeds(read.sequence, minimizerSeedDensity));
+		OrderSeeds(graph, seeds.back());
+	}
+	std::cerr << reads.size() << " reads, " << readBp / repeats << "bp, bandwidth " << bandwidth << ", " << repeats << " repeats" << std::endl;
+
+	std::cout << "wordsize\tms\tread Mbp/s\tslices\taligned bp\tfailed" << std::endl;
+	printResult(64, benchmark<uint64_t>(graph, reads, seeds, bandwidth, repeats), readBp);
+	printResult(128, benchmark<__uint128_t>(graph, reads, seeds, bandwidth, repeats), readBp);
+	printResult(256, benchmark<Word256>(graph, reads, seeds, bandwidth, repeats), readBp);
+}
@@ -0,0 +1,128 @@
+#ifndef BlockingQueue_h
+#define BlockingQueue_h
+
+#include <vector>
+#include <cassert>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+
+//bounded multi-producer multi-consumer FIFO on a ring buffer
+//push blocks while the queue is full and pop blocks while it is empty, waiting on condition variables instead of polling
+//meant for handing over batches of work so the lock is taken once per batch, not once per item
+template <typename T>
+class BlockingQueue
+{
+public:
+	BlockingQueue(size_t capacity) :
+	items(capacity),
+	first(0),
+	count(0),
+	closed(false),
+	waitingConsumers(0)
+	{
+		assert(capacity > 0);
+	}
+	BlockingQueue(const BlockingQueue& other) = delete;
+	BlockingQueue& operator=(const BlockingQueue& other) = delete;
+	//returns false if the queue was closed, in which case item is not moved from
+	bool push(T& item)
+	{
+		std::unique_lock<std::mutex> lock { mutex };
+		notFull.wait(lock, [this]() { return closed || count < items.size(); });
+		if (closed) return false;
+		items[(first + count) % items.size()] = std::move(item);
+		count += 1;
+		lock.unlock();
+		notEmpty.notify_one();
+		return true;
+	}
+	bool tryPush(T& item)
+	{
+		std::unique_lock<std::mutex> lock { mutex };
+		if (closed || count == items.size()) return false;
+		items[(first + count) % items.size()] = std::move(item);
+		count += 1;
+		lock.unlock();
+		notEmpty.notify_one();
+		return true;
+	}
+	//returns false once the queue is closed and empty
+	bool pop(T& item)
+	{
+		std::unique_lock<std::mutex> lock { mutex };
+		if (!closed && count == 0)
+		{
+			waitingConsumers += 1;
+			notEmpty.wait(lock, [this]() { return closed || count > 0; });
+			waitingConsumers -= 1;
+		}
+		if (count == 0) return false;
+		popLocked(item);
+		lock.unlock();
+		notFull.notify_one();
+		return true;
+	}
+	//waits like pop, then takes up to maxItems at once
+	bool popBatch(std::vector<T>& result, size_t maxItems)
+	{
+		assert(maxItems > 0);
+		std::unique_lock<std::mutex> lock { mutex };
+		if (!closed && count == 0)
+		{
+			waitingConsumers += 1;
+			notEmpty.wait(lock, [this]() { return closed || count > 0; });
+			waitingConsumers -= 1;
+		}
+		if (count == 0) return false;
+		while (count > 0 && result.size() < maxItems)
+		{
+			result.emplace_back();
+			popLocked(result.back());
+		}
+		lock.unlock();
+		notFull.notify_all();
+		return true;
+	}
+	bool tryPop(T& item)
+	{
+		std::unique_lock<std::mutex> lock { mutex };
+		if (count == 0) return false;
+		popLocked(item);
+		lock.unlock();
+		notFull.notify_one();
+		return true;
+	}
+	//no more pushes. consumers get the remaining items and then pop returns false
+	void close()
+	{
+		{
+			std::lock_guard<std::mutex> lock { mutex };
+			closed = true;
+		}
+		notEmpty.notify_all();
+		notFull.notify_all();
+	}
+	//lets a producer hand over a partial batch instead of letting consumers idle
+	bool hasWaitingConsumers() const
+	{
+		return waitingConsumers > 0;
+	}
+private:
+	void popLocked(T& item)
+	{
+		item = std::move(items[first]);
+		first = (first + 1) % items.size();
+		count -= 1;
+	}
+	std::vector<T> items;
+	size_t first;
+	size_t count;
+	bool closed;
+	std::atomic<size_t> waitingConsumers;
+	std::mutex mutex;
+	std::condition_variable notEmpty;
+	std::condition_variable notFull;
+};
+
+#endif
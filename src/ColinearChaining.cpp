@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <numeric>
+#include "ColinearChaining.h"
+
+namespace ColinearChaining
+{
+
+const int64_t NoValue = std::numeric_limits<int64_t>::min();
+const size_t NoPredecessor = std::numeric_limits<size_t>::max();
+
+//maximum of a range of values, with the anchor the maximum came from
+class RangeMaxTree
+{
+public:
+	RangeMaxTree(size_t size) :
+	size(size),
+	items(size * 2, std::make_pair(NoValue, NoPredecessor))
+	{
+	}
+	void set(size_t pos, int64_t value, size_t anchor)
+	{
+		assert(pos < size);
+		pos += size;
+		items[pos] = std::make_pair(value, anchor);
+		while (pos > 1)
+		{
+			pos /= 2;
+			items[pos] = std::max(items[pos * 2], items[pos * 2 + 1]);
+		}
+	}
+	//max of [start, end)
+	std::pair<int64_t, size_t> max(size_t start, size_t end) const
+	{
+		assert(start <= end);
+		assert(end <= size);
+		std::pair<int64_t, size_t> result { NoValue, NoPredecessor };
+		for (start += size, end += size; start < end; start /= 2, end /= 2)
+		{
+			if (start & 1) result = std::max(result, items[start++]);
+			if (end & 1) result = std::max(result, items[--end]);
+		}
+		return result;
+	}
+private:
+	size_t size;
+	std::vector<std::pair<int64_t, size_t>> items;
+};
+
+std::vector<Chain> chainAnchors(const std::vector<Anchor>& anchors)
+{
+	size_t n = anchors.size();
+	std::vector<int64_t> diagonal;
+	diagonal.resize(n);
+	for (size_t i = 0; i < n; i++)
+	{
+		diagonal[i] = anchors[i].graphPos - anchors[i].readPos;
+	}
+	std::vector<size_t> order;
+	order.resize(n);
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [&diagonal](size_t left, size_t right) { return diagonal[left] < diagonal[right] || (diagonal[left] == diagonal[right] && left < right); });
+	std::vector<int64_t> sortedDiagonals;
+	std::vector<size_t> diagonalRank;
+	sortedDiagonals.resize(n);
+	diagonalRank.resize(n);
+	for (size_t i = 0; i < n; i++)
+	{
+		sortedDiagonals[i] = diagonal[order[i]];
+		diagonalRank[order[i]] = i;
+	}
+	std::sort(order.begin(), order.end(), [&anchors](size_t left, size_t right) { return anchors[left].readPos < anchors[right].readPos || (anchors[left].readPos == anchors[right].readPos && left < right); });
+	//predecessors at least this far back in the read are strictly forward in the graph and don't overlap the anchor, so
+	//they go to the range max trees. the recent ones are checked one by one
+	int64_t recentWindow = MaxChainDiagonalGap;
+	for (size_t i = 0; i < n; i++)
+	{
+		recentWindow = std::max(recentWindow, (int64_t)anchors[i].length);
+	}
+	recentWindow = std::min(recentWindow, MaxChainReadGap);
+	//a gap from diagonal a to b costs |a - b|, so split the predecessors by whether they are on a lower or a higher diagonal
+	//and store score + diagonal for the lower ones and score - diagonal for the higher ones
+	RangeMaxTree lowerDiagonals { n };
+	RangeMaxTree higherDiagonals { n };
+	std::vector<int64_t> score;
+	std::vector<size_t> predecessor;
+	score.resize(n, 0);
+	predecessor.resize(n, NoPredecessor);
+	size_t windowStart = 0;
+	size_t inserted = 0;
+	size_t computed = 0;
+	for (size_t k = 0; k < n; k++)
+	{
+		size_t i = order[k];
+		//anchors at the same read position can't be each other's predecessors
+		while (computed < k && anchors[order[computed]].readPos < anchors[i].readPos) computed++;
+		while (inserted < computed && anchors[order[inserted]].readPos + recentWindow < anchors[i].readPos)
+		{
+			size_t added = order[inserted];
+			lowerDiagonals.set(diagonalRank[added], score[added] + diagonal[added], added);
+			higherDiagonals.set(diagonalRank[added], score[added] - diagonal[added], added);
+			inserted++;
+		}
+		while (windowStart < inserted && anchors[order[windowStart]].readPos + MaxChainReadGap < anchors[i].readPos)
+		{
+			size_t removed = order[windowStart];
+			lowerDiagonals.set(diagonalRank[removed], NoValue, NoPredecessor);
+			higherDiagonals.set(diagonalRank[removed], NoValue, NoPredecessor);
+			windowStart++;
+		}
+		size_t low = std::lower_bound(sortedDiagonals.begin(), sortedDiagonals.end(), diagonal[i] - MaxChainDiagonalGap) - sortedDiagonals.begin();
+		size_t mid = std::upper_bound(sortedDiagonals.begin(), sortedDiagonals.end(), diagonal[i]) - sortedDiagonals.begin();
+		size_t high = std::upper_bound(sortedDiagonals.begin(), sortedDiagonals.end(), diagonal[i] + MaxChainDiagonalGap) - sortedDiagonals.begin();
+		int64_t length = anchors[i].length;
+		score[i] = length;
+		auto fromLower = lowerDiagonals.max(low, mid);
+		if (fromLower.first != NoValue && fromLower.first - diagonal[i] + length > score[i])
+		{
+			score[i] = fromLower.first - diagonal[i] + length;
+			predecessor[i] = fromLower.second;
+		}
+		auto fromHigher = higherDiagonals.max(mid, high);
+		if (fromHigher.first != NoValue && fromHigher.first + diagonal[i] + length > score[i])
+		{
+			score[i] = fromHigher.first + diagonal[i] + length;
+			predecessor[i] = fromHigher.second;
+		}
+		//a recent predecessor on a higher diagonal may be at or past this anchor in the graph, and an overlapping one only
+		//adds the bases past its end
+		for (size_t recent = std::max(inserted, windowStart); recent < computed; recent++)
+		{
+			size_t j = order[recent];
+			if (anchors[j].graphPos >= anchors[i].graphPos) continue;
+			if (std::abs(diagonal[i] - diagonal[j]) > MaxChainDiagonalGap) continue;
+			if (anchors[j].readPos + MaxChainReadGap < anchors[i].readPos) continue;
+			int64_t gain = std::min(length, anchors[i].readPos - anchors[j].readPos);
+			int64_t candidate = score[j] + gain - std::abs(diagonal[i] - diagonal[j]);
+			if (candidate > score[i])
+			{
+				score[i] = candidate;
+				predecessor[i] = j;
+			}
+		}
+	}
+	//backtrace from the best unused ends. a chain stops where it runs into a better chain
+	std::sort(order.begin(), order.end(), [&score](size_t left, size_t right) { return score[left] > score[right] || (score[left] == score[right] && left < right); });
+	std::vector<bool> used;
+	used.resize(n, false);
+	std::vector<Chain> result;
+	for (size_t end : order)
+	{
+		if (used[end]) continue;
+		result.emplace_back();
+		Chain& chain = result.back();
+		int64_t gapCost = 0;
+		size_t i = end;
+		while (true)
+		{
+			used[i] = true;
+			chain.anchors.push_back(i);
+			size_t previous = predecessor[i];
+			if (previous == NoPredecessor || used[previous]) break;
+			gapCost += std::abs(diagonal[i] - diagonal[previous]);
+			i = previous;
+		}
+		std::reverse(chain.anchors.begin(), chain.anchors.end());
+		int64_t coveredBps = 0;
+		int64_t lastEnd = NoValue;
+		for (size_t anchor : chain.anchors)
+		{
+			int64_t start = anchors[anchor].readPos - (int64_t)anchors[anchor].length + 1;
+			int64_t end = anchors[anchor].readPos + 1;
+			assert(end > lastEnd);
+			coveredBps += end - std::max(start, lastEnd);
+			lastEnd = end;
+		}
+		chain.score = std::max(coveredBps - gapCost, (int64_t)0);
+	}
+	std::stable_sort(result.begin(), result.end(), [](const Chain& left, const Chain& right) { return left.score > right.score; });
+	return result;
+}
+
+}
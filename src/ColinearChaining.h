@@ -0,0 +1,35 @@
+#ifndef ColinearChaining_h
+#define ColinearChaining_h
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ColinearChaining
+{
+	//an exact match ending at readPos in the read and graphPos in the linear coordinates of a chain of bubbles
+	struct Anchor
+	{
+		int64_t graphPos;
+		int64_t readPos;
+		size_t length;
+	};
+	struct Chain
+	{
+		//indices to the anchors, in read order
+		std::vector<size_t> anchors;
+		//bases of the read covered by the anchors minus the gap costs, the same score the DP maximizes
+		size_t score;
+	};
+	//anchors further apart than this in the read aren't chained
+	const int64_t MaxChainReadGap = 5000;
+	//nor anchors whose diagonals differ by more than this
+	const int64_t MaxChainDiagonalGap = 500;
+	//sparse DP over the anchors, where a gap costs the difference of the diagonals and an anchor adds the read bases past
+	//the end of its predecessor. a predecessor must be strictly before the anchor both in the read and in the graph.
+	//every anchor goes to exactly one chain, the chains are returned best first. O(n log n) plus a linear scan over the
+	//predecessors within max(MaxChainDiagonalGap, longest anchor) bases back in the read
+	std::vector<Chain> chainAnchors(const std::vector<Anchor>& anchors);
+}
+
+#endif
@@ -1,3 +1,4 @@
+#include <unistd.h>
 #include "CommonUtils.h"
 #include "stream.hpp"
 
@@ -64,15 +65,20 @@ namespace CommonUtils
 		return result;
 	}
 
-	std::string ReverseComplement(std::string str)
+	std::string ReverseComplement(std::string_view str)
 	{
 		std::string result;
-		result.reserve(str.size());
-		for (int i = str.size()-1; i >= 0; i--)
+		ReverseComplement(str, result);
+		return result;
+	}
+
+	void ReverseComplement(std::string_view str, std::string& result)
+	{
+		result.resize(str.size());
+		for (size_t i = 0; i < str.size(); i++)
 		{
-			result += Complement(str[i]);
+			result[i] = Complement(str[str.size()-1-i]);
 		}
-		return result;
 	}
 
 	char Complement(char c)
@@ -133,6 +139,11 @@ namespace CommonUtils
 	}
 	}
 
+	std::string TemporaryFileName(const std::string& filename)
+	{
+		return filename + ".tmp." + std::to_string(getpid());
+	}
+
 }
 
 BufferedWriter::BufferedWriter() : stream(nullptr) {};
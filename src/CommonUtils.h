@@ -4,6 +4,7 @@
 #include <algorithm>
 #include <functional>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <sstream>
 #include "vg.pb.h"
@@ -17,9 +18,14 @@ namespace CommonUtils
 	};
 	vg::Graph LoadVGGraph(std::string filename);
 	char Complement(char original);
-	std::string ReverseComplement(std::string original);
+	std::string ReverseComplement(std::string_view original);
+	//writes into result to reuse its buffer
+	void ReverseComplement(std::string_view original, std::string& result);
 	vg::Alignment LoadVGAlignment(std::string filename);
 	std::vector<vg::Alignment> LoadVGAlignments(std::string filename);
+	//a file next to filename that is unique to this process. write there and rename() it over filename
+	//so that other processes never see a partially written file
+	std::string TemporaryFileName(const std::string& filename);
 }
 
 class BufferedWriter : std::ostream
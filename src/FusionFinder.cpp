@@ -207,7 +207,7 @@ void addBestAlnsOnePair(std::unordered_map<size_t, FusionAlignment>& bestAlns, c
 			}
 			else
 			{
-				alignments = AlignOneWay(alignmentGraph, read.seq_id, read.sequence, 100, 100, true, reusableState, true, true, false, false, 0, 0, 0);
+				alignments = AlignOneWay(alignmentGraph, read.seq_id, read.sequence, 100, 100, true, reusableState, true, true, false, false, 0, 0, 0, 0);
 			}
 			if (bestAlns.count(readIndex) == 1 && alignments.alignments[0].alignmentScore > bestAlns.at(readIndex).alignment->score()) continue;
 			AddAlignment(read.seq_id, read.sequence, alignments.alignments[0]);
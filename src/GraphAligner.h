@@ -4,10 +4,14 @@
 #include <chrono>
 #include <algorithm>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <iostream>
+#include <memory>
+#include <unordered_map>
 #include "AlignmentGraph.h"
 #include "CommonUtils.h"
+#include "ColinearChaining.h"
 #include "GraphAlignerWrapper.h"
 #include "ThreadReadAssertion.h"
 #include "GraphAlignerCommon.h"
@@ -30,6 +34,7 @@ private:
 	using Trace = typename Common::Trace;
 	using OnewayTrace = typename Common::OnewayTrace;
 	using AlignerGraphsizedState = typename Common::AlignerGraphsizedState;
+	using ExtensionPool = typename Common::ExtensionPool;
 	using TraceItem = typename Common::TraceItem;
 	const Params& params;
 	BitvectorAligner bvAligner;
@@ -46,11 +51,12 @@ public:
 		if (!params.quietMode) logger = { std::cerr };
 	}
 	
-	AlignmentResult AlignOneWay(const std::string& seq_id, const std::string& sequence, AlignerGraphsizedState& reusableState, size_t DPRestartStride) const
+	AlignmentResult AlignOneWay(const std::string_view& seq_id, const std::string_view& sequence, AlignerGraphsizedState& reusableState, size_t DPRestartStride) const
 	{
 		AlignmentResult result;
 		result.readName = seq_id;
-		std::string bwSequence = CommonUtils::ReverseComplement(sequence);
+		std::string& bwSequence = reusableState.reverseSequence;
+		CommonUtils::ReverseComplement(sequence, bwSequence);
 		auto fw = fullstartOneWay(seq_id, reusableState, sequence, bwSequence, 0);
 		if (!fw.alignmentFailed()) result.alignments.emplace_back(std::move(fw));
 		if (DPRestartStride > 0)
@@ -78,7 +84,7 @@ public:
 		return result;
 	}
 
-	AlignmentResult AlignOneWayDijkstra(const std::string& seq_id, const std::string& sequence, AlignerGraphsizedState& reusableState) const
+	AlignmentResult AlignOneWayDijkstra(const std::string_view& seq_id, const std::string_view& sequence, AlignerGraphsizedState& reusableState) const
 	{
 		AlignmentResult result;
 		result.readName = seq_id;
@@ -107,7 +113,9 @@ public:
 		return result;
 	}
 
-	AlignmentResult AlignOneWay(const std::string& seq_id, const std::string& sequence, const std::vector<SeedHit>& seedHits, AlignerGraphsizedState& reusableState) const
+	//with an extension pool, idle threads extend the following seeds speculatively. the seeds are still committed here in order
+	//and skipped based on the alignments committed so far, so the result is the same as extending them one by one
+	AlignmentResult AlignOneWay(const std::string_view& seq_id, const std::string_view& sequence, const std::vector<SeedHit>& seedHits, AlignerGraphsizedState& reusableState, ExtensionPool* extensionPool) const
 	{
 		assert(params.graph.finalized);
 		AlignmentResult result;
@@ -117,7 +125,11 @@ public:
 		size_t extendSeeds = params.seedExtendDensity * sequence.size() + 1;
 		if (params.seedExtendDensity == -1) extendSeeds = seedHits.size();
 		size_t worstExtendedSeedScore = 0;
-		std::string revSequence = CommonUtils::ReverseComplement(sequence);
+		std::string& revSequence = reusableState.reverseSequence;
+		CommonUtils::ReverseComplement(sequence, revSequence);
+		//the log lines would come out of order
+		if (!params.quietMode) extensionPool = nullptr;
+		SpeculativeExtensions speculative;
 		for (size_t i = 0; i < seedHits.size(); i++)
 		{
 			if (params.sloppyOptimizations && ((params.nondeterministicOptimizations && seedHits[i].seedGoodness == seedScoreForEndToEndAln) || seedHits[i].seedGoodness < seedScoreForEndToEndAln))
@@ -132,45 +144,22 @@ public:
 			}
 			assertSetRead(seq_id, seedHits[i].nodeID, seedHits[i].reverse, seedHits[i].seqPos, seedHits[i].matchLen, seedHits[i].nodeOffset);
 			if (!logger.inputDiscarded()) logger << seq_id << " seed " << i << "/" << seedHits.size() << " " << ThreadReadAssertion::assertGetSeedInfo();
-			if (seedHits[i].seedClusterSize < params.minSeedClusterSize)
+			const char* skipReason = seedSkipReason(seedHits[i], result);
+			if (skipReason != nullptr)
 			{
-				logger << " skipped (cluster size)";
+				logger << " skipped (" << skipReason << ")";
 				logger << BufferedWriter::Flush;
+				speculative.discard(i);
 				continue;
 			}
-			if (params.sloppyOptimizations)
-			{
-				bool found = false;
-				for (const auto& aln : result.alignments)
-				{
-					if (aln.alignmentStart <= seedHits[i].seqPos && aln.alignmentEnd >= seedHits[i].seqPos && (params.nondeterministicOptimizations || aln.seedGoodness > seedHits[i].seedGoodness))
-					{
-						logger << " skipped (overlap)";
-						logger << BufferedWriter::Flush;
-						found = true;
-						break;
-					}
-				}
-				if (found) continue;
-			}
-			bool found = false;
-			for (const auto& aln : result.alignments)
-			{
-				if (exactAlignmentPart(aln, seedHits[i]))
-				{
-					logger << " skipped (existing alignment)";
-					logger << BufferedWriter::Flush;
-					found = true;
-					break;
-				}
-			}
-			if (found) continue;
 			logger << BufferedWriter::Flush;
 			worstExtendedSeedScore = seedHits[i].seedGoodness;
 			result.seedsExtended += 1;
-			auto item = getAlignmentFromSeed(seq_id, sequence, revSequence, seedHits[i], reusableState);
+			if (extensionPool != nullptr) startSpeculativeExtensions(seq_id, sequence, revSequence, seedHits, i, result, seedScoreForEndToEndAln, extendSeeds, speculative, *extensionPool);
+			auto item = speculative.has(i) ? speculative.take(i, reusableState) : getAlignmentFromSeed(seq_id, sequence, revSequence, seedHits[i], reusableState);
 			if (item.alignmentFailed()) continue;
 			item.seedGoodness = seedHits[i].seedGoodness;
+			item.seedChain = seedHits[i].seedChain;
 			result.alignments.emplace_back(std::move(item));
 			if (params.sloppyOptimizations)
 			{
@@ -196,19 +185,19 @@ public:
 		return result;
 	}
 
-	void AddAlignment(const std::string& seq_id, const std::string& sequence, AlignmentResult::AlignmentItem& alignment) const
+	void AddAlignment(const std::string_view& seq_id, const std::string_view& sequence, AlignmentResult::AlignmentItem& alignment) const
 	{
 		assert(alignment.trace->trace.size() > 0);
 		auto vgAln = VGAlignment::traceToAlignment(seq_id, sequence, alignment.trace->score, alignment.trace->trace, 0, false);
 		alignment.alignment = vgAln;
-		alignment.alignment->set_sequence(sequence.substr(alignment.alignmentStart, alignment.alignmentEnd - alignment.alignmentStart));
+		alignment.alignment->set_sequence(std::string { sequence.substr(alignment.alignmentStart, alignment.alignmentEnd - alignment.alignmentStart) });
 		alignment.alignment->set_query_position(alignment.alignmentStart);
 	}
 
-	void AddGAFLine(const std::string& seq_id, const std::string& sequence, AlignmentResult::AlignmentItem& alignment, bool cigarMatchMismatchMerge) const
+	void AddGAFLine(const std::string_view& seq_id, const std::string_view& sequence, const AlignmentResult::AlignmentItem& alignment, bool cigarMatchMismatchMerge, std::string& out) const
 	{
 		assert(alignment.trace->trace.size() > 0);
-		alignment.GAFline = GAFAlignment::traceToAlignment(seq_id, sequence, *alignment.trace, params, cigarMatchMismatchMerge);
+		GAFAlignment::traceToAlignment(seq_id, sequence, *alignment.trace, params, cigarMatchMismatchMerge, out);
 	}
 
 	void AddCorrected(AlignmentResult::AlignmentItem& alignment) const
@@ -224,9 +213,11 @@ public:
 		}
 	}
 
+	//chains the seeds colinearly within each chain of bubbles and orders them by chain score. the best seed of a chain goes
+	//first and the rest of the chain is only extended if that fails
 	void orderSeedsByChaining(std::vector<SeedHit>& seedHits) const
 	{
-		phmap::flat_hash_map<size_t, std::vector<std::pair<size_t, size_t>>> seedPoses;
+		phmap::flat_hash_map<size_t, std::vector<std::pair<size_t, ColinearChaining::Anchor>>> seedPoses;
 		for (size_t i = 0; i < seedHits.size(); i++)
 		{
 			int forwardNodeId;
@@ -252,48 +243,156 @@ public:
 				realOffset = seedHits[i].alignmentGraphNodeOffset;
 				assert(params.graph.chainApproxPos[nodeIndex] + realOffset >= seedHits[i].seqPos);
 			}
-			seedPoses[params.graph.chainNumber[nodeIndex]].emplace_back(i, params.graph.chainApproxPos[nodeIndex] + realOffset - seedHits[i].seqPos);
+			seedPoses[params.graph.chainNumber[nodeIndex]].emplace_back(i, ColinearChaining::Anchor { (int64_t)(params.graph.chainApproxPos[nodeIndex] + realOffset), (int64_t)seedHits[i].seqPos, seedHits[i].matchLen });
 		}
-		for (auto& pair : seedPoses)
+		//score, seeds with the best first
+		std::vector<std::pair<size_t, std::vector<size_t>>> chains;
+		std::vector<ColinearChaining::Anchor> anchors;
+		for (const auto& pair : seedPoses)
 		{
-			std::sort(pair.second.begin(), pair.second.end(), [](std::pair<size_t, size_t> left, std::pair<size_t, size_t> right) { return left.second < right.second; });
-			size_t clusterStart = 0;
-			for (size_t i = 1; i <= pair.second.size(); i++)
+			anchors.clear();
+			for (const auto& seed : pair.second) anchors.push_back(seed.second);
+			for (const auto& chain : ColinearChaining::chainAnchors(anchors))
 			{
-				assert(i == pair.second.size() || pair.second[i].second >= pair.second[i-1].second);
-				if (i < pair.second.size() && pair.second[i].second <= pair.second[i-1].second + 100) continue;
-				assert(i > clusterStart);
-				std::sort(pair.second.begin()+clusterStart, pair.second.begin()+i, [&seedHits](std::pair<size_t, size_t> left, std::pair<size_t, size_t> right) { return seedHits[left.first].seqPos < seedHits[right.first].seqPos; });
-				size_t matchingBps = 0;
-				int lastEnd = std::numeric_limits<int>::min();
-				for (size_t j = clusterStart; j < i; j++)
-				{
-					int thisStart = (int)seedHits[pair.second[j].first].seqPos - (int)seedHits[pair.second[j].first].matchLen + 1;
-					int thisEnd = (int)seedHits[pair.second[j].first].seqPos;
-					assert(thisEnd >= lastEnd);
-					assert(thisEnd > thisStart);
-					matchingBps += (thisEnd - std::max(thisStart, lastEnd));
-					// matchingBps += seedHits[pair.second[j].first].rawSeedGoodness;
-					lastEnd = thisEnd;
-				}
-				for (size_t j = clusterStart; j < i; j++)
-				{
-					seedHits[pair.second[j].first].seedGoodness = matchingBps + seedHits[pair.second[j].first].rawSeedGoodness;
-					seedHits[pair.second[j].first].seedClusterSize = i - clusterStart;
-				}
-				clusterStart = i;
+				chains.emplace_back();
+				chains.back().first = chain.score;
+				for (size_t anchor : chain.anchors) chains.back().second.push_back(pair.second[anchor].first);
+				std::sort(chains.back().second.begin(), chains.back().second.end(), [&seedHits](size_t left, size_t right) { return seedHits[left].rawSeedGoodness > seedHits[right].rawSeedGoodness || (seedHits[left].rawSeedGoodness == seedHits[right].rawSeedGoodness && left < right); });
 			}
 		}
-		std::sort(seedHits.begin(), seedHits.end(), [](const SeedHit& left, const SeedHit& right) { return left.seedGoodness < right.seedGoodness; });
-		std::reverse(seedHits.begin(), seedHits.end());
+		//the seed indices break ties so the order doesn't depend on the hash map
+		std::sort(chains.begin(), chains.end(), [](const std::pair<size_t, std::vector<size_t>>& left, const std::pair<size_t, std::vector<size_t>>& right) { return left.first > right.first || (left.first == right.first && left.second[0] < right.second[0]); });
+		std::vector<SeedHit> ordered;
+		ordered.reserve(seedHits.size());
+		for (size_t i = 0; i < chains.size(); i++)
+		{
+			for (size_t seed : chains[i].second)
+			{
+				ordered.push_back(seedHits[seed]);
+				ordered.back().seedGoodness = chains[i].first;
+				ordered.back().seedClusterSize = chains[i].second.size();
+				ordered.back().seedChain = i;
+			}
+		}
+		assert(ordered.size() == seedHits.size());
+		seedHits = std::move(ordered);
 	}
 
 private:
 
-	AlignmentResult::AlignmentItem fullstartOneWay(const std::string& seq_id, AlignerGraphsizedState& reusableState, const std::string& fwSequence, const std::string& bwSequence, size_t offset) const
+	//seed extensions handed to the extension pool, by seed index
+	class SpeculativeExtensions
+	{
+		struct Extension
+		{
+			std::shared_ptr<typename ExtensionPool::Task> task;
+			AlignmentResult::AlignmentItem item;
+		};
+	public:
+		SpeculativeExtensions() :
+		nextCandidate(0),
+		extensions(),
+		discarded()
+		{
+		}
+		~SpeculativeExtensions()
+		{
+			//the tasks refer to the read and the results, wait for the ones that are running
+			for (auto& pair : extensions) pair.second->task->cancelOrWait();
+			for (auto& extension : discarded) extension->task->cancelOrWait();
+		}
+		SpeculativeExtensions(const SpeculativeExtensions& other) = delete;
+		SpeculativeExtensions& operator=(const SpeculativeExtensions& other) = delete;
+		bool has(size_t seed) const
+		{
+			return extensions.count(seed) == 1;
+		}
+		size_t size() const
+		{
+			return extensions.size();
+		}
+		//runs the extension with state if no helper has started it yet
+		AlignmentResult::AlignmentItem take(size_t seed, AlignerGraphsizedState& state)
+		{
+			auto found = extensions.find(seed);
+			assert(found != extensions.end());
+			found->second->task->runOrWait(state);
+			AlignmentResult::AlignmentItem result = std::move(found->second->item);
+			extensions.erase(found);
+			return result;
+		}
+		void discard(size_t seed)
+		{
+			auto found = extensions.find(seed);
+			if (found == extensions.end()) return;
+			if (!found->second->task->tryCancel()) discarded.emplace_back(std::move(found->second));
+			extensions.erase(found);
+		}
+		template <typename F>
+		bool trySubmit(size_t seed, ExtensionPool& pool, F work)
+		{
+			assert(!has(seed));
+			auto extension = std::make_unique<Extension>();
+			AlignmentResult::AlignmentItem* itemPtr = &extension->item;
+			extension->task = std::make_shared<typename ExtensionPool::Task>([work, itemPtr](AlignerGraphsizedState& state) { *itemPtr = work(state); });
+			if (!pool.trySubmit(extension->task)) return false;
+			extensions[seed] = std::move(extension);
+			return true;
+		}
+		//seeds before this have already been considered for speculation
+		size_t nextCandidate;
+	private:
+		std::unordered_map<size_t, std::unique_ptr<Extension>> extensions;
+		std::vector<std::unique_ptr<Extension>> discarded;
+	};
+
+	//nullptr if the seed should be extended
+	const char* seedSkipReason(const SeedHit& seedHit, const AlignmentResult& result) const
+	{
+		if (seedHit.seedClusterSize < params.minSeedClusterSize) return "cluster size";
+		if (params.sloppyOptimizations)
+		{
+			for (const auto& aln : result.alignments)
+			{
+				if (aln.seedChain == seedHit.seedChain) return "chain extended";
+				if (aln.alignmentStart <= seedHit.seqPos && aln.alignmentEnd >= seedHit.seqPos && (params.nondeterministicOptimizations || aln.seedGoodness > seedHit.seedGoodness)) return "overlap";
+			}
+		}
+		for (const auto& aln : result.alignments)
+		{
+			if (exactAlignmentPart(aln, seedHit)) return "existing alignment";
+		}
+		return nullptr;
+	}
+
+	//hands the seeds after the current one to idle helpers, as long as they would be extended with the alignments found so far.
+	//more alignments only make seeds skipped, so a wasted extension is discarded later but a needed one is never missed
+	void startSpeculativeExtensions(const std::string_view& seq_id, const std::string_view& sequence, const std::string_view& revSequence, const std::vector<SeedHit>& seedHits, size_t current, const AlignmentResult& result, size_t seedScoreForEndToEndAln, size_t extendSeeds, SpeculativeExtensions& speculative, ExtensionPool& pool) const
+	{
+		size_t planned = result.seedsExtended + speculative.size();
+		if (speculative.has(current)) planned -= 1;
+		size_t j = std::max(current + 1, speculative.nextCandidate);
+		for (; j < seedHits.size() && planned < extendSeeds && pool.hasIdleHelpers(); j++)
+		{
+			if (params.sloppyOptimizations && seedHits[j].seedGoodness < seedScoreForEndToEndAln) break;
+			if (seedSkipReason(seedHits[j], result) != nullptr) continue;
+			const SeedHit& seedHit = seedHits[j];
+			bool submitted = speculative.trySubmit(j, pool, [this, seq_id, sequence, revSequence, &seedHit](AlignerGraphsizedState& state)
+			{
+				assertSetRead(seq_id, seedHit.nodeID, seedHit.reverse, seedHit.seqPos, seedHit.matchLen, seedHit.nodeOffset);
+				return getAlignmentFromSeed(seq_id, sequence, revSequence, seedHit, state);
+			});
+			if (!submitted) break;
+			planned += 1;
+		}
+		speculative.nextCandidate = j;
+	}
+
+	AlignmentResult::AlignmentItem fullstartOneWay(const std::string_view& seq_id, AlignerGraphsizedState& reusableState, const std::string_view& fwSequence, const std::string_view& bwSequence, size_t offset) const
 	{
 		auto timeStart = std::chrono::system_clock::now();
 		assert(params.graph.finalized);
+		reusableState.arena.reset();
 		std::string_view fwView { fwSequence.data() + offset, fwSequence.size() - offset };
 		auto fwTrace = getBacktraceFullStart(fwView, reusableState);
 		auto timeEnd = std::chrono::system_clock::now();
@@ -411,16 +510,9 @@ private:
 		return false;
 	}
 
-	OnewayTrace getBacktraceDijkstra(const std::string& sequence, AlignerGraphsizedState& reusableState) const
+	OnewayTrace getBacktraceDijkstra(const std::string_view& sequence, AlignerGraphsizedState& reusableState) const
 	{
-		std::string_view seq { sequence.data(), sequence.size() };
-		return dijkstraAligner.getBacktraceFullStart(seq, params.forceGlobal, reusableState);
-	}
-
-	OnewayTrace getBacktraceFullStart(const std::string& sequence, AlignerGraphsizedState& reusableState) const
-	{
-		std::string_view seq { sequence.data(), sequence.size() };
-		return getBacktraceFullStart(seq, reusableState);
+		return dijkstraAligner.getBacktraceFullStart(sequence, params.forceGlobal, reusableState);
 	}
 
 	OnewayTrace getBacktraceFullStart(const std::string_view& seq, AlignerGraphsizedState& reusableState) const
@@ -428,7 +520,7 @@ private:
 		return bvAligner.getBacktraceFullStart(seq, params.forceGlobal, params.Xdropcutoff, reusableState);
 	}
 
-	Trace getTwoDirectionalTrace(const std::string& sequence, const std::string& revSequence, SeedHit seedHit, AlignerGraphsizedState& reusableState) const
+	Trace getTwoDirectionalTrace(const std::string_view& sequence, const std::string_view& revSequence, SeedHit seedHit, AlignerGraphsizedState& reusableState) const
 	{
 		assert(seedHit.seqPos >= 0);
 		assert(seedHit.seqPos < sequence.size());
@@ -475,7 +567,7 @@ private:
 		return result;
 	}
 
-	void fixForwardTraceSeqPos(std::vector<TraceItem>& trace, LengthType start, const std::string& sequence) const
+	void fixForwardTraceSeqPos(std::vector<TraceItem>& trace, LengthType start, const std::string_view& sequence) const
 	{
 		if (trace.size() == 0) return;
 		for (size_t i = 0; i < trace.size(); i++)
@@ -491,7 +583,7 @@ private:
 	}
 
 	//end is the (fw) index of the last alignable base pair, not one beyond
-	void fixReverseTraceSeqPosAndOrder(std::vector<TraceItem>& trace, LengthType end, const std::string& sequence) const
+	void fixReverseTraceSeqPosAndOrder(std::vector<TraceItem>& trace, LengthType end, const std::string_view& sequence) const
 	{
 		if (trace.size() == 0) return;
 		std::reverse(trace.begin(), trace.end());
@@ -515,9 +607,11 @@ private:
 		trace.back().nodeSwitch = false;
 	}
 
-	AlignmentResult::AlignmentItem getAlignmentFromSeed(const std::string& seq_id, const std::string& sequence, const std::string& revSequence, SeedHit seedHit, AlignerGraphsizedState& reusableState) const
+	AlignmentResult::AlignmentItem getAlignmentFromSeed(const std::string_view& seq_id, const std::string_view& sequence, const std::string_view& revSequence, SeedHit seedHit, AlignerGraphsizedState& reusableState) const
 	{
 		assert(params.graph.finalized);
+		//the DP tables of the previous extension are gone, reuse their memory
+		reusableState.arena.reset();
 		auto timeStart = std::chrono::system_clock::now();
 
 		auto trace = getTwoDirectionalTrace(sequence, revSequence, seedHit, reusableState);
@@ -623,11 +717,6 @@ private:
 	}
 
 #ifndef NDEBUG
-	void verifyTrace(const std::vector<TraceItem>& trace, const std::string& sequence, ScoreType score) const
-	{
-		std::string_view view { sequence.data(), sequence.size() };
-		verifyTrace(trace, view, score);
-	}
 	void verifyTrace(const std::vector<TraceItem>& trace, const std::string_view& sequence, ScoreType score) const
 	{
 		size_t start = 0;
@@ -657,7 +746,7 @@ private:
 			assert(newpos.nodeOffset == 0);
 		}
 	}
-	void verifyFixedTrace(const std::vector<TraceItem>& trace, const std::string& sequence, ScoreType score) const
+	void verifyFixedTrace(const std::vector<TraceItem>& trace, const std::string_view& sequence, ScoreType score) const
 	{
 		if (trace.size() == 0) return;
 		assert(trace[0].DPposition.seqPos < sequence.size());
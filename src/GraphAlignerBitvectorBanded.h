@@ -7,6 +7,7 @@
 #include <cmath>
 #include <iostream>
 #include <string_view>
+#include <chrono>
 #include "AlignmentGraph.h"
 #include "NodeSlice.h"
 #include "CommonUtils.h"
@@ -57,6 +58,7 @@ public:
 		assert(slice.slices.back().minScore >= 0);
 		assert(slice.slices.back().minScore <= (ScoreType)sequence.size() + (ScoreType)WordConfiguration<Word>::WordSize * 2);
 
+		auto backtraceStart = std::chrono::steady_clock::now();
 		OnewayTrace result;
 		if (params.preciseClipping)
 		{
@@ -66,6 +68,7 @@ public:
 		{
 			result = BV::getReverseTraceFromTableStartLastRow(params, sequence, slice, reusableState, true);
 		}
+		reusableState.counters.backtraceNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - backtraceStart).count();
 
 		return result;
 	}
@@ -123,6 +126,7 @@ public:
 			return OnewayTrace::TraceFailed();
 		}
 
+		auto backtraceStart = std::chrono::steady_clock::now();
 		OnewayTrace result;
 		if (params.preciseClipping)
 		{
@@ -132,6 +136,7 @@ public:
 		{
 			result = BV::getReverseTraceFromTableStartLastRow(params, alignableSequence, slice, reusableState, true);
 		}
+		reusableState.counters.backtraceNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - backtraceStart).count();
 		for (size_t i = 0; i < result.trace.size(); i++)
 		{
 			result.trace[i].DPposition.seqPos += 1;
@@ -203,7 +208,7 @@ private:
 #endif
 
 	template <bool HasVectorMap, bool PreviousHasVectorMap, typename PriorityQueue>
-	NodeCalculationResult calculateSlice(const std::string_view& sequence, size_t j, NodeSlice<LengthType, ScoreType, Word, HasVectorMap>& currentSlice, const NodeSlice<LengthType, ScoreType, Word, PreviousHasVectorMap>& previousSlice, std::vector<bool>& currentBand, const std::vector<bool>& previousBand, PriorityQueue& calculableQueue, ScoreType previousQuitScore, int bandwidth, ScoreType previousMinScore) const
+	NodeCalculationResult calculateSlice(const std::string_view& sequence, size_t j, NodeSlice<LengthType, ScoreType, Word, HasVectorMap>& currentSlice, const NodeSlice<LengthType, ScoreType, Word, PreviousHasVectorMap>& previousSlice, PagedNodeSet& currentBand, const PagedNodeSet& previousBand, PriorityQueue& calculableQueue, ScoreType previousQuitScore, int bandwidth, ScoreType previousMinScore) const
 	{
 		double averageErrorRate = 0;
 		if (j > 0)
@@ -224,9 +229,9 @@ private:
 		result.maxExactEndposNode = std::numeric_limits<LengthType>::min();
 		result.maxExactEndposScore = std::numeric_limits<ScoreType>::min();
 		result.cellsProcessed = 0;
-#ifdef SLICEVERBOSE
 		result.nodesProcessed = 0;
-#endif
+		result.queuePushes = 0;
+		result.queuePops = 0;
 
 		EqVector EqV = BV::getEqVector(sequence, j);
 
@@ -246,6 +251,7 @@ private:
 				{
 					calculableQueue.insert(node.second.minScore*priorityMismatchPenalty - j - zeroScore, EdgeWithPriority { node.first, node.second.minScore - previousMinScore, startSlice, true });
 				}
+				result.queuePushes++;
 			}
 		}
 		else
@@ -273,6 +279,7 @@ private:
 				{
 					calculableQueue.insert(node.second.minScore*priorityMismatchPenalty - j - zeroScore, EdgeWithPriority { node.first, node.second.minScore - previousMinScore, startSlice, true });
 				}
+				result.queuePushes++;
 			}
 		}
 		assert(calculableQueue.size() > 0);
@@ -288,6 +295,7 @@ private:
 			if (calculableQueue.extraSize(pair.target) == 0)
 			{
 				calculableQueue.pop();
+				result.queuePops++;
 				continue;
 			}
 			auto i = pair.target;
@@ -295,7 +303,7 @@ private:
 			{
 				assert(!currentSlice.hasNode(i));
 				currentSlice.addNode(i);
-				currentBand[i] = true;
+				currentBand.set(i);
 			}
 			assert(currentBand[i]);
 			const std::vector<EdgeWithPriority>* extras;
@@ -345,6 +353,7 @@ private:
 				}
 			}
 			calculableQueue.pop();
+			result.queuePops++;
 			if (!calculableQueue.IsComponentPriorityQueue())
 			{
 				calculableQueue.removeExtras(i);
@@ -382,6 +391,7 @@ private:
 							assert(newEndPriorityScore >= zeroScore);
 							calculableQueue.insert(newEndPriorityScore - zeroScore, EdgeWithPriority { neighbor, newEndMinScore - previousMinScore, newEnd, false });
 						}
+						result.queuePushes++;
 					}
 				}
 			}
@@ -399,9 +409,7 @@ private:
 			assert(result.minScore == currentMinScoreAtEndRow);
 			result.cellsProcessed += nodeCalc.cellsProcessed;
 			assert(nodeCalc.cellsProcessed > 0);
-#ifdef SLICEVERBOSE
 			result.nodesProcessed++;
-#endif
 			if (result.cellsProcessed > params.maxCellsPerSlice) break;
 		}
 
@@ -426,7 +434,7 @@ private:
 	}
 
 	template <typename PriorityQueue>
-	void fillDPSlice(const std::string_view& sequence, DPSlice& slice, const DPSlice& previousSlice, const std::vector<bool>& previousBand, std::vector<bool>& currentBand, PriorityQueue& calculableQueue, int bandwidth) const
+	void fillDPSlice(const std::string_view& sequence, DPSlice& slice, const DPSlice& previousSlice, const PagedNodeSet& previousBand, PagedNodeSet& currentBand, PriorityQueue& calculableQueue, int bandwidth, MemoryArena* arena) const
 	{
 		NodeCalculationResult sliceResult;
 		assert((ScoreType)previousSlice.bandwidth < std::numeric_limits<ScoreType>::max());
@@ -442,7 +450,7 @@ private:
 			{
 				sliceResult = calculateSlice<true, false>(sequence, slice.j, slice.scoresVectorMap, previousSlice.scores, currentBand, previousBand, calculableQueue, previousSlice.minScore + previousSlice.bandwidth, bandwidth, previousSlice.minScore);
 			}
-			slice.scores = slice.scoresVectorMap.getMapSlice();
+			slice.scores = slice.scoresVectorMap.getMapSlice(arena);
 		}
 		else
 		{
@@ -463,8 +471,10 @@ private:
 		assert(slice.minScore >= previousSlice.minScore);
 		slice.correctness = slice.correctness.NextState(slice.minScore - previousSlice.minScore, WordConfiguration<Word>::WordSize);
 		slice.bandwidth = bandwidth;
-#ifdef SLICEVERBOSE
 		slice.nodesProcessed = sliceResult.nodesProcessed;
+		slice.queuePushes = sliceResult.queuePushes;
+		slice.queuePops = sliceResult.queuePops;
+#ifdef SLICEVERBOSE
 		for (auto node : slice.scores)
 		{
 			if (currentBand[node.first])
@@ -476,27 +486,85 @@ private:
 	}
 
 	template <typename PriorityQueue>
-	DPSlice pickMethodAndExtendFill(const std::string_view& sequence, const DPSlice& previous, const std::vector<bool>& previousBand, std::vector<bool>& currentBand, std::vector<typename NodeSlice<LengthType, ScoreType, Word, true>::MapItem>& nodesliceMap, PriorityQueue& calculableQueue, int bandwidth) const
+	DPSlice pickMethodAndExtendFill(const std::string_view& sequence, const DPSlice& previous, const PagedNodeSet& previousBand, PagedNodeSet& currentBand, PagedNodeArray<typename NodeSlice<LengthType, ScoreType, Word, true>::MapItem>& nodesliceMap, PriorityQueue& calculableQueue, int bandwidth, MemoryArena* arena) const
 	{
 		if (!params.lowMemory)
 		{
 			DPSlice bandTest { &nodesliceMap };
 			bandTest.j = previous.j + WordConfiguration<Word>::WordSize;
 			bandTest.correctness = previous.correctness;
-			fillDPSlice(sequence, bandTest, previous, previousBand, currentBand, calculableQueue, bandwidth);
+			fillDPSlice(sequence, bandTest, previous, previousBand, currentBand, calculableQueue, bandwidth, arena);
 			return bandTest;
 		}
 		else
 		{
 			DPSlice bandTest;
-			bandTest.scores.addEmptyNodeMap(previous.scores.size());
+			bandTest.scores.addEmptyNodeMap(previous.scores.size(), arena);
 			bandTest.j = previous.j + WordConfiguration<Word>::WordSize;
 			bandTest.correctness = previous.correctness;
-			fillDPSlice(sequence, bandTest, previous, previousBand, currentBand, calculableQueue, bandwidth);
+			fillDPSlice(sequence, bandTest, previous, previousBand, currentBand, calculableQueue, bandwidth, arena);
 			return bandTest;
 		}
 	}
 
+	void countSlice(const DPSlice& slice, AlignerCounters& counters) const
+	{
+		counters.slices++;
+		counters.cellsProcessed += slice.cellsProcessed;
+		counters.nodesProcessed += slice.nodesProcessed;
+		counters.queuePushes += slice.queuePushes;
+		counters.queuePops += slice.queuePops;
+	}
+
+	//the slices get the same previous slices and bandwidths as when they were first calculated so the scores come out the same
+	void recalculateSlices(const std::string_view& sequence, typename DPTable::SliceVector& slices, size_t start, size_t end, AlignerGraphsizedState& reusableState) const
+	{
+		assert(reusableState.previousBand.count() == 0);
+		assert(reusableState.currentBand.count() == 0);
+		DPSlice lastSlice = slices[start];
+		assert(!lastSlice.scoresVectorMap.hasVectorMapCurrently());
+		for (auto node : lastSlice.scores)
+		{
+			reusableState.previousBand.set(node.first);
+		}
+		for (size_t i = start+1; i < end; i++)
+		{
+#ifndef NDEBUG
+			debugLastRowMinScore = lastSlice.minScore;
+#endif
+			DPSlice newSlice;
+			if (reusableState.componentQueue.valid())
+			{
+				newSlice = pickMethodAndExtendFill(sequence, lastSlice, reusableState.previousBand, reusableState.currentBand, (i % 2 == 0) ? reusableState.evenNodesliceMap : reusableState.oddNodesliceMap, reusableState.componentQueue, slices[i].bandwidth, nullptr);
+			}
+			else
+			{
+				newSlice = pickMethodAndExtendFill(sequence, lastSlice, reusableState.previousBand, reusableState.currentBand, (i % 2 == 0) ? reusableState.evenNodesliceMap : reusableState.oddNodesliceMap, reusableState.calculableQueue, slices[i].bandwidth, nullptr);
+			}
+			countSlice(newSlice, reusableState.counters);
+			reusableState.counters.recalculatedSlices++;
+			assert(newSlice.j == slices[i].j);
+			assert(newSlice.minScore == slices[i].minScore);
+			assert(newSlice.maxExactEndposScore == slices[i].maxExactEndposScore);
+			slices[i].scores = newSlice.scores;
+			for (auto node : lastSlice.scores)
+			{
+				assert(reusableState.previousBand[node.first]);
+				reusableState.previousBand.reset(node.first);
+			}
+			std::swap(reusableState.previousBand, reusableState.currentBand);
+			lastSlice.scoresVectorMap.removeVectorArray();
+			lastSlice = std::move(newSlice);
+		}
+		for (auto node : lastSlice.scores)
+		{
+			assert(reusableState.previousBand[node.first]);
+			reusableState.previousBand.reset(node.first);
+		}
+		lastSlice.scoresVectorMap.removeVectorArray();
+		reusableState.releaseNodeslicePages();
+	}
+
 	DPTable getSlices(const std::string_view& sequence, const DPSlice& initialSlice, size_t numSlices, bool forceGlobal, int Xdropcutoff, AlignerGraphsizedState& reusableState) const
 	{
 		if (Xdropcutoff > 0)
@@ -514,21 +582,27 @@ private:
 	{
 		assert(initialSlice.j == (size_t)-WordConfiguration<Word>::WordSize);
 		assert(initialSlice.j + numSlices * WordConfiguration<Word>::WordSize <= sequence.size() + WordConfiguration<Word>::WordSize);
-		DPTable result;
+		//dropped scores wouldn't return their memory to the arena so a memory limited table uses the heap
+		MemoryArena* sliceArena = (params.maxTraceTableBytes > 0) ? nullptr : &reusableState.arena;
+		DPTable result { sliceArena, params.maxTraceTableBytes };
 		result.slices.reserve(numSlices + 1);
+		result.recalculate = [this, sequence, &reusableState](typename DPTable::SliceVector& slices, size_t start, size_t end)
+		{
+			recalculateSlices(sequence, slices, start, end, reusableState);
+		};
 		size_t cellsProcessed = 0;
 		std::vector<size_t> partOfComponent;
 		{
 			for (auto node : initialSlice.scores)
 			{
-				reusableState.previousBand[node.first] = true;
+				reusableState.previousBand.set(node.first);
 			}
 		}
 #ifndef NDEBUG
 		debugLastRowMinScore = 0;
 #endif
 		DPSlice lastSlice = initialSlice;
-		result.slices.push_back(initialSlice);
+		result.addSlice(DPSlice { initialSlice });
 		assert(lastSlice.correctness.CurrentlyCorrect());
 		DPSlice rampSlice = lastSlice;
 		size_t rampRedoIndex = -1;
@@ -552,12 +626,13 @@ private:
 			DPSlice newSlice;
 			if (reusableState.componentQueue.valid())
 			{
-				newSlice = pickMethodAndExtendFill(sequence, lastSlice, reusableState.previousBand, reusableState.currentBand, (slice % 2 == 0) ? reusableState.evenNodesliceMap : reusableState.oddNodesliceMap, reusableState.componentQueue, bandwidth);
+				newSlice = pickMethodAndExtendFill(sequence, lastSlice, reusableState.previousBand, reusableState.currentBand, (slice % 2 == 0) ? reusableState.evenNodesliceMap : reusableState.oddNodesliceMap, reusableState.componentQueue, bandwidth, sliceArena);
 			}
 			else
 			{
-				newSlice = pickMethodAndExtendFill(sequence, lastSlice, reusableState.previousBand, reusableState.currentBand, (slice % 2 == 0) ? reusableState.evenNodesliceMap : reusableState.oddNodesliceMap, reusableState.calculableQueue, bandwidth);
+				newSlice = pickMethodAndExtendFill(sequence, lastSlice, reusableState.previousBand, reusableState.currentBand, (slice % 2 == 0) ? reusableState.evenNodesliceMap : reusableState.oddNodesliceMap, reusableState.calculableQueue, bandwidth, sliceArena);
 			}
+			countSlice(newSlice, reusableState.counters);
 #ifdef SLICEVERBOSE
 			auto timeEnd = std::chrono::system_clock::now();
 			auto time = std::chrono::duration_cast<std::chrono::milliseconds>(timeEnd - timeStart).count();
@@ -594,12 +669,12 @@ private:
 					for (auto node : lastSlice.scores)
 					{
 						assert(reusableState.previousBand[node.first]);
-						reusableState.previousBand[node.first] = false;
+						reusableState.previousBand.reset(node.first);
 					}
 					for (auto node : newSlice.scores)
 					{
 						assert(reusableState.currentBand[node.first]);
-						reusableState.currentBand[node.first] = false;
+						reusableState.currentBand.reset(node.first);
 					}
 					lastSlice.scoresVectorMap.removeVectorArray();
 					newSlice.scoresVectorMap.removeVectorArray();
@@ -610,28 +685,29 @@ private:
 					for (auto node : newSlice.scores)
 					{
 						assert(reusableState.currentBand[node.first]);
-						reusableState.currentBand[node.first] = false;
+						reusableState.currentBand.reset(node.first);
 					}
 					for (auto node : lastSlice.scores)
 					{
 						assert(reusableState.previousBand[node.first]);
-						reusableState.previousBand[node.first] = false;
+						reusableState.previousBand.reset(node.first);
 					}
 					lastSlice.scoresVectorMap.removeVectorArray();
 					newSlice.scoresVectorMap.removeVectorArray();
 					rampUntil = slice;
+					reusableState.counters.rampRedos++;
 					std::swap(slice, rampRedoIndex);
 					std::swap(lastSlice, rampSlice);
 					for (auto node : lastSlice.scores)
 					{
 						assert(!reusableState.previousBand[node.first]);
-						reusableState.previousBand[node.first] = true;
+						reusableState.previousBand.set(node.first);
 					}
 					if (slice == (size_t)-1)
 					{
-						result.slices.clear();
+						result.clear();
 					}
-					while (result.slices.size() > 1 && result.slices.back().j > slice * WordConfiguration<Word>::WordSize) result.slices.pop_back();
+					while (result.slices.size() > 1 && result.slices.back().j > slice * WordConfiguration<Word>::WordSize) result.removeLastSlice();
 					assert(slice == (size_t)-1 || result.slices.size() == slice+2);
 					assert(result.slices.back().j == lastSlice.j);
 #ifdef SLICEVERBOSE
@@ -648,11 +724,11 @@ private:
 			std::cerr << std::endl;
 #endif
 
-			result.slices.push_back(newSlice.getMapSlice());
+			result.addSlice(newSlice.getMapSlice());
 			for (auto node : lastSlice.scores)
 			{
 				assert(reusableState.previousBand[node.first]);
-				reusableState.previousBand[node.first] = false;
+				reusableState.previousBand.reset(node.first);
 			}
 			assert(newSlice.minScore != std::numeric_limits<ScoreType>::max());
 			assert(newSlice.minScore >= lastSlice.minScore);
@@ -661,7 +737,7 @@ private:
 				for (auto node : newSlice.scores)
 				{
 					assert(reusableState.currentBand[node.first]);
-					reusableState.currentBand[node.first] = false;
+					reusableState.currentBand.reset(node.first);
 				}
 			}
 			else
@@ -677,12 +753,10 @@ private:
 
 #ifdef EXTRACORRECTNESSASSERTIONS
 		assert(reusableState.calculableQueue.size() == 0);
-		for (size_t i = 0; i < reusableState.currentBand.size(); i++)
-		{
-			assert(!reusableState.currentBand[i]);
-			assert(!reusableState.previousBand[i]);
-		}
 #endif
+		assert(reusableState.currentBand.count() == 0);
+		assert(reusableState.previousBand.count() == 0);
+		reusableState.releaseNodeslicePages();
 
 #ifndef NDEBUG
 		if (result.slices.size() > 0)
@@ -705,21 +779,27 @@ private:
 		assert(params.preciseClipping);
 		assert(initialSlice.j == (size_t)-WordConfiguration<Word>::WordSize);
 		assert(initialSlice.j + numSlices * WordConfiguration<Word>::WordSize <= sequence.size() + WordConfiguration<Word>::WordSize);
-		DPTable result;
+		//dropped scores wouldn't return their memory to the arena so a memory limited table uses the heap
+		MemoryArena* sliceArena = (params.maxTraceTableBytes > 0) ? nullptr : &reusableState.arena;
+		DPTable result { sliceArena, params.maxTraceTableBytes };
 		result.slices.reserve(numSlices + 1);
+		result.recalculate = [this, sequence, &reusableState](typename DPTable::SliceVector& slices, size_t start, size_t end)
+		{
+			recalculateSlices(sequence, slices, start, end, reusableState);
+		};
 		size_t cellsProcessed = 0;
 		std::vector<size_t> partOfComponent;
 		{
 			for (auto node : initialSlice.scores)
 			{
-				reusableState.previousBand[node.first] = true;
+				reusableState.previousBand.set(node.first);
 			}
 		}
 #ifndef NDEBUG
 		debugLastRowMinScore = 0;
 #endif
 		DPSlice lastSlice = initialSlice;
-		result.slices.push_back(initialSlice);
+		result.addSlice(DPSlice { initialSlice });
 		ScoreType bestXScore = initialSlice.maxExactEndposScore;
 		assert(bestXScore != std::numeric_limits<ScoreType>::min());
 #ifndef NDEBUG
@@ -741,12 +821,13 @@ private:
 			DPSlice newSlice;
 			if (reusableState.componentQueue.valid())
 			{
-				newSlice = pickMethodAndExtendFill(sequence, lastSlice, reusableState.previousBand, reusableState.currentBand, (slice % 2 == 0) ? reusableState.evenNodesliceMap : reusableState.oddNodesliceMap, reusableState.componentQueue, bandwidth);
+				newSlice = pickMethodAndExtendFill(sequence, lastSlice, reusableState.previousBand, reusableState.currentBand, (slice % 2 == 0) ? reusableState.evenNodesliceMap : reusableState.oddNodesliceMap, reusableState.componentQueue, bandwidth, sliceArena);
 			}
 			else
 			{
-				newSlice = pickMethodAndExtendFill(sequence, lastSlice, reusableState.previousBand, reusableState.currentBand, (slice % 2 == 0) ? reusableState.evenNodesliceMap : reusableState.oddNodesliceMap, reusableState.calculableQueue, bandwidth);
+				newSlice = pickMethodAndExtendFill(sequence, lastSlice, reusableState.previousBand, reusableState.currentBand, (slice % 2 == 0) ? reusableState.evenNodesliceMap : reusableState.oddNodesliceMap, reusableState.calculableQueue, bandwidth, sliceArena);
 			}
+			countSlice(newSlice, reusableState.counters);
 #ifdef SLICEVERBOSE
 			auto timeEnd = std::chrono::system_clock::now();
 			auto time = std::chrono::duration_cast<std::chrono::milliseconds>(timeEnd - timeStart).count();
@@ -778,12 +859,12 @@ private:
 				for (auto node : lastSlice.scores)
 				{
 					assert(reusableState.previousBand[node.first]);
-					reusableState.previousBand[node.first] = false;
+					reusableState.previousBand.reset(node.first);
 				}
 				for (auto node : newSlice.scores)
 				{
 					assert(reusableState.currentBand[node.first]);
-					reusableState.currentBand[node.first] = false;
+					reusableState.currentBand.reset(node.first);
 				}
 				lastSlice.scoresVectorMap.removeVectorArray();
 				newSlice.scoresVectorMap.removeVectorArray();
@@ -794,11 +875,11 @@ private:
 			std::cerr << std::endl;
 #endif
 
-			result.slices.push_back(newSlice.getMapSlice());
+			result.addSlice(newSlice.getMapSlice());
 			for (auto node : lastSlice.scores)
 			{
 				assert(reusableState.previousBand[node.first]);
-				reusableState.previousBand[node.first] = false;
+				reusableState.previousBand.reset(node.first);
 			}
 			assert(newSlice.minScore != std::numeric_limits<ScoreType>::max());
 			assert(newSlice.minScore >= lastSlice.minScore);
@@ -807,7 +888,7 @@ private:
 				for (auto node : newSlice.scores)
 				{
 					assert(reusableState.currentBand[node.first]);
-					reusableState.currentBand[node.first] = false;
+					reusableState.currentBand.reset(node.first);
 				}
 			}
 			else
@@ -823,12 +904,10 @@ private:
 
 #ifdef EXTRACORRECTNESSASSERTIONS
 		assert(reusableState.calculableQueue.size() == 0);
-		for (size_t i = 0; i < reusableState.currentBand.size(); i++)
-		{
-			assert(!reusableState.currentBand[i]);
-			assert(!reusableState.previousBand[i]);
-		}
 #endif
+		assert(reusableState.currentBand.count() == 0);
+		assert(reusableState.previousBand.count() == 0);
+		reusableState.releaseNodeslicePages();
 
 #ifndef NDEBUG
 		if (result.slices.size() > 0)
@@ -2,6 +2,7 @@
 #define GraphAlignerBitvectorCommon_h
 
 #include <algorithm>
+#include <functional>
 #include <string>
 #include <vector>
 #include <cmath>
@@ -34,6 +35,8 @@ private:
 public:
 	using WordSlice = decltype(NodeSlice<LengthType, ScoreType, Word, true>::NodeSliceMapItem::startSlice);
 
+	//match masks of the slice for each character. ambiguous characters are cached per set of bases
+	//so nodes with them don't combine the masks again every time they are calculated
 	class EqVector
 	{
 	public:
@@ -43,16 +46,19 @@ public:
 			masks[1] = BC;
 			masks[2] = BG;
 			masks[3] = BT;
+			for (size_t i = 0; i < 16; i++)
+			{
+				ambiguousMasks[i] = WordConfiguration<Word>::AllZeros;
+				if (i & 1) ambiguousMasks[i] |= A();
+				if (i & 2) ambiguousMasks[i] |= C();
+				if (i & 4) ambiguousMasks[i] |= G();
+				if (i & 8) ambiguousMasks[i] |= T();
+			}
 		}
 		Word getEqI(AlignmentGraph::AmbiguousChunkSequence eq) const
 		{
 			assert((eq.A | eq.C | eq.G | eq.T) & 1);
-			Word result = 0;
-			if (eq.A & 1) result |= A();
-			if (eq.C & 1) result |= C();
-			if (eq.G & 1) result |= G();
-			if (eq.T & 1) result |= T();
-			return result;
+			return ambiguousMasks[(eq.A & 1) | ((eq.C & 1) << 1) | ((eq.G & 1) << 2) | ((eq.T & 1) << 3)];
 		}
 		Word getEqC(char c) const
 		{
@@ -118,6 +124,8 @@ public:
 		}
 		Word masks[4];
 	private:
+		//indexed by bit 0 A, bit 1 C, bit 2 G, bit 3 T
+		Word ambiguousMasks[16];
 		Word A() const
 		{
 			return masks[0];
@@ -150,13 +158,15 @@ public:
 		j(std::numeric_limits<LengthType>::max()),
 		cellsProcessed(0),
 		bandwidth(0),
-		scoresNotValid(false)
+		scoresNotValid(false),
+		nodesProcessed(0),
+		queuePushes(0),
+		queuePops(0)
 #ifdef SLICEVERBOSE
-		,nodesProcessed(0)
 		,numCells(0)
 #endif
 		{}
-		DPSlice(std::vector<typename NodeSlice<LengthType, ScoreType, Word, true>::MapItem>* vectorMap) :
+		DPSlice(PagedNodeArray<typename NodeSlice<LengthType, ScoreType, Word, true>::MapItem>* vectorMap) :
 		minScore(std::numeric_limits<ScoreType>::max()),
 		minScoreNode(std::numeric_limits<LengthType>::max()),
 		minScoreNodeOffset(std::numeric_limits<LengthType>::max()),
@@ -168,9 +178,11 @@ public:
 		j(std::numeric_limits<LengthType>::max()),
 		cellsProcessed(0),
 		bandwidth(0),
-		scoresNotValid(false)
+		scoresNotValid(false),
+		nodesProcessed(0),
+		queuePushes(0),
+		queuePops(0)
 #ifdef SLICEVERBOSE
-		,nodesProcessed(0)
 		,numCells(0)
 #endif
 		{}
@@ -186,8 +198,10 @@ public:
 		size_t cellsProcessed;
 		size_t bandwidth;
 		bool scoresNotValid;
-#ifdef SLICEVERBOSE
 		size_t nodesProcessed;
+		size_t queuePushes;
+		size_t queuePops;
+#ifdef SLICEVERBOSE
 		size_t numCells;
 #endif
 		DPSlice getMapSlice() const
@@ -205,20 +219,110 @@ public:
 			result.cellsProcessed = cellsProcessed;
 			result.bandwidth = bandwidth;
 			result.scoresNotValid = scoresNotValid;
-#ifdef SLICEVERBOSE
 			result.nodesProcessed = nodesProcessed;
+			result.queuePushes = queuePushes;
+			result.queuePops = queuePops;
+#ifdef SLICEVERBOSE
 			result.numCells = numCells;
 #endif
 			return result;
 		}
 	};
+	//with a memory limit, the scores are only kept in every checkpointInterval'th slice once they would grow over the limit
+	//and the others are recalculated from the previous checkpoint when the backtrace needs them. the slice metadata is always kept
 	class DPTable
 	{
 	public:
+		using SliceVector = std::vector<DPSlice, ArenaAllocator<DPSlice>>;
 		DPTable() :
-		slices()
+		slices(),
+		maxStoredBytes(0),
+		checkpointInterval(1),
+		recalculate(),
+		storedBytes(0),
+		recalculatedCheckpoints()
 		{}
-		std::vector<DPSlice> slices;
+		DPTable(MemoryArena* arena, size_t maxStoredBytes) :
+		slices(ArenaAllocator<DPSlice> { arena }),
+		maxStoredBytes(maxStoredBytes),
+		checkpointInterval(1),
+		recalculate(),
+		storedBytes(0),
+		recalculatedCheckpoints()
+		{}
+		void addSlice(DPSlice&& slice)
+		{
+			slices.push_back(std::move(slice));
+			if (maxStoredBytes == 0) return;
+			if ((slices.size()-1) % checkpointInterval != 0)
+			{
+				slices.back().scores.removeNodeMap();
+				return;
+			}
+			storedBytes += scoreBytes(slices.back());
+			while (storedBytes > maxStoredBytes && checkpointInterval < slices.size())
+			{
+				checkpointInterval *= 2;
+				for (size_t i = checkpointInterval / 2; i < slices.size(); i += checkpointInterval)
+				{
+					storedBytes -= scoreBytes(slices[i]);
+					slices[i].scores.removeNodeMap();
+				}
+			}
+		}
+		void removeLastSlice()
+		{
+			if (slices.back().scores.hasNodeMap()) storedBytes -= scoreBytes(slices.back());
+			slices.pop_back();
+		}
+		void clear()
+		{
+			slices.clear();
+			storedBytes = 0;
+		}
+		//makes sure slices index and index-1 have their scores. keeps at most the two blocks between checkpoints recalculated at a time
+		void requireScores(size_t index)
+		{
+			if (checkpointInterval == 1) return;
+			assert(index < slices.size());
+			assert(recalculate);
+			size_t needed[2] { index - index % checkpointInterval, std::numeric_limits<size_t>::max() };
+			if (index % checkpointInterval == 0) needed[0] = std::numeric_limits<size_t>::max();
+			if (index > 0 && (index-1) % checkpointInterval != 0) needed[1] = (index-1) - (index-1) % checkpointInterval;
+			for (size_t i = recalculatedCheckpoints.size()-1; i < recalculatedCheckpoints.size(); i--)
+			{
+				size_t checkpoint = recalculatedCheckpoints[i];
+				if (checkpoint == needed[0] || checkpoint == needed[1]) continue;
+				for (size_t j = checkpoint+1; j < checkpoint + checkpointInterval && j < slices.size(); j++)
+				{
+					slices[j].scores.removeNodeMap();
+				}
+				recalculatedCheckpoints.erase(recalculatedCheckpoints.begin() + i);
+			}
+			for (auto checkpoint : needed)
+			{
+				if (checkpoint == std::numeric_limits<size_t>::max()) continue;
+				if (std::find(recalculatedCheckpoints.begin(), recalculatedCheckpoints.end(), checkpoint) != recalculatedCheckpoints.end()) continue;
+				assert(slices[checkpoint].scores.hasNodeMap());
+				recalculate(slices, checkpoint, std::min(checkpoint + checkpointInterval, slices.size()));
+				recalculatedCheckpoints.push_back(checkpoint);
+			}
+			assert(slices[index].scores.hasNodeMap());
+			assert(index == 0 || slices[index-1].scores.hasNodeMap());
+		}
+		SliceVector slices;
+		//0 for unlimited
+		size_t maxStoredBytes;
+		size_t checkpointInterval;
+		//fills the scores of slices (start, end) from the checkpoint at start
+		std::function<void(SliceVector& slices, size_t start, size_t end)> recalculate;
+	private:
+		static size_t scoreBytes(const DPSlice& slice)
+		{
+			return slice.scores.size() * sizeof(typename NodeSlice<LengthType, ScoreType, Word, false>::MapItem);
+		}
+		size_t storedBytes;
+		std::vector<size_t> recalculatedCheckpoints;
 	};
 	class NodeCalculationResult
 	{
@@ -229,9 +333,9 @@ public:
 		LengthType maxExactEndposNode;
 		ScoreType maxExactEndposScore;
 		size_t cellsProcessed;
-#ifdef SLICEVERBOSE
 		size_t nodesProcessed;
-#endif
+		size_t queuePushes;
+		size_t queuePops;
 	};
 
 
@@ -256,8 +360,8 @@ public:
 		slice.VP = tempMh | ~(Xv | tempPh); //line 17
 		hinP = Ph >> (WordConfiguration<Word>::WordSize-1); //line 13
 		slice.VN = tempPh & Xv; //line 18
-		slice.scoreEnd -= hinN; //line 12
-		slice.scoreEnd += hinP; //line 14
+		slice.scoreEnd -= (ScoreType)hinN; //line 12
+		slice.scoreEnd += (ScoreType)hinP; //line 14
 
 		return std::make_tuple(slice, hinP, hinN);
 	}
@@ -318,7 +422,7 @@ public:
 		return EqV;
 	}
 
-	static OnewayTrace getReverseTraceFromTableExactEndPos(const Params& params, const std::string_view& sequence, const DPTable& slice, AlignerGraphsizedState& reusableState, bool sliceConsistency)
+	static OnewayTrace getReverseTraceFromTableExactEndPos(const Params& params, const std::string_view& sequence, DPTable& slice, AlignerGraphsizedState& reusableState, bool sliceConsistency)
 	{
 		assert(slice.slices.size() > 1);
 		size_t bestIndex = 1;
@@ -333,6 +437,7 @@ public:
 		}
 		auto node = slice.slices[bestIndex].maxExactEndposNode;
 		auto score = slice.slices[bestIndex].maxExactEndposScore;
+		slice.requireScores(bestIndex);
 		typename NodeSlice<LengthType, ScoreType, Word, false>::NodeSliceMapItem previous;
 		if (slice.slices[bestIndex-1].scores.hasNode(node))
 		{
@@ -382,14 +487,14 @@ public:
 		return getReverseTraceFromTable(params, sequence, slice, reusableState, startPos, startScore, sliceConsistency);
 	}
 
-	static OnewayTrace getReverseTraceFromTableStartLastRow(const Params& params, const std::string_view& sequence, const DPTable& slice, AlignerGraphsizedState& reusableState, bool sliceConsistency)
+	static OnewayTrace getReverseTraceFromTableStartLastRow(const Params& params, const std::string_view& sequence, DPTable& slice, AlignerGraphsizedState& reusableState, bool sliceConsistency)
 	{
 		ScoreType startScore = slice.slices.back().minScore;
 		MatrixPosition startPos {slice.slices.back().minScoreNode, slice.slices.back().minScoreNodeOffset, std::min(slice.slices.back().j + WordConfiguration<Word>::WordSize - 1, sequence.size()-1)};
 		return getReverseTraceFromTable(params, sequence, slice, reusableState, startPos, startScore, sliceConsistency);
 	}
 
-	static OnewayTrace getReverseTraceFromTable(const Params& params, const std::string_view& sequence, const DPTable& slice, AlignerGraphsizedState& reusableState, MatrixPosition startPos, ScoreType startScore, bool sliceConsistency)
+	static OnewayTrace getReverseTraceFromTable(const Params& params, const std::string_view& sequence, DPTable& slice, AlignerGraphsizedState& reusableState, MatrixPosition startPos, ScoreType startScore, bool sliceConsistency)
 	{
 		assert(slice.slices.size() > 0);
 		assert(slice.slices.back().minScoreNode != std::numeric_limits<LengthType>::max());
@@ -410,7 +515,11 @@ public:
 			LengthType newNode = result.trace.back().DPposition.node;
 			if (newSlice != currentSlice || newNode != currentNode)
 			{
-				if (newSlice != currentSlice) EqV = getEqVector(sequence, slice.slices[newSlice].j);
+				if (newSlice != currentSlice)
+				{
+					slice.requireScores(newSlice);
+					EqV = getEqVector(sequence, slice.slices[newSlice].j);
+				}
 				currentSlice = newSlice;
 				currentNode = newNode;
 				assert(slice.slices[currentSlice].scores.hasNode(currentNode));
@@ -518,7 +627,7 @@ public:
 				size_t chunk = i / params.graph.SPLIT_NODE_SIZE;
 				size_t offset = i % params.graph.SPLIT_NODE_SIZE;
 				Word mask = ((Word)1) << offset;
-				beforeSliceScores[i] = beforeSliceScores[i-1] + ((node.HP[chunk] & mask) >> offset) - ((node.HN[chunk] & mask) >> offset);
+				beforeSliceScores[i] = beforeSliceScores[i-1] + (ScoreType)((node.HP[chunk] & mask) >> offset) - (ScoreType)((node.HN[chunk] & mask) >> offset);
 			}
 			assert(beforeSliceScores.back() == node.endSlice.scoreEnd);
 			while (beforeSliceScores[result.trace.back().DPposition.nodeOffset] != 0 && result.trace.back().DPposition.nodeOffset > 0 && beforeSliceScores[result.trace.back().DPposition.nodeOffset-1] == beforeSliceScores[result.trace.back().DPposition.nodeOffset] - 1)
@@ -681,12 +790,12 @@ public:
 		ScoreType scoreDiagonal = previousNode.startSlice.scoreEnd;
 		for (size_t i = 1; i <= pos.nodeOffset - 1; i++)
 		{
-			scoreDiagonal += (previousNode.HP[i / WordConfiguration<Word>::WordSize] >> (i % WordConfiguration<Word>::WordSize)) & 1;
-			scoreDiagonal -= (previousNode.HN[i / WordConfiguration<Word>::WordSize] >> (i % WordConfiguration<Word>::WordSize)) & 1;
+			scoreDiagonal += (ScoreType)((previousNode.HP[i / WordConfiguration<Word>::WordSize] >> (i % WordConfiguration<Word>::WordSize)) & 1);
+			scoreDiagonal -= (ScoreType)((previousNode.HN[i / WordConfiguration<Word>::WordSize] >> (i % WordConfiguration<Word>::WordSize)) & 1);
 		}
 		ScoreType scoreUp = scoreDiagonal;
-		scoreUp += (previousNode.HP[(pos.nodeOffset) / WordConfiguration<Word>::WordSize] >> ((pos.nodeOffset) % WordConfiguration<Word>::WordSize)) & 1;
-		scoreUp -= (previousNode.HN[(pos.nodeOffset) / WordConfiguration<Word>::WordSize] >> ((pos.nodeOffset) % WordConfiguration<Word>::WordSize)) & 1;
+		scoreUp += (ScoreType)((previousNode.HP[(pos.nodeOffset) / WordConfiguration<Word>::WordSize] >> ((pos.nodeOffset) % WordConfiguration<Word>::WordSize)) & 1);
+		scoreUp -= (ScoreType)((previousNode.HN[(pos.nodeOffset) / WordConfiguration<Word>::WordSize] >> ((pos.nodeOffset) % WordConfiguration<Word>::WordSize)) & 1);
 		if (previousScoresNotValid || scoresNotValid || scoreHere > quitScore || scoreDiagonal > previousQuitScore || scoreUp > previousQuitScore)
 		{
 			//this location is out of the band so the usual horizontal and vertical score limits don't apply
@@ -855,7 +964,7 @@ public:
 #ifdef NDEBUG
 	__attribute__((always_inline))
 #endif
-	static NodeCalculationResult calculateNodeClipPrecise(const Params& params, size_t i, typename NodeSlice<LengthType, ScoreType, Word, true>::NodeSliceMapItem& slice, const EqVector& EqV, typename NodeSlice<LengthType, ScoreType, Word, true>::NodeSliceMapItem previousSlice, const std::vector<EdgeWithPriority>& incoming, const std::vector<bool>& previousBand, NodeChunkType nodeChunks)
+	static NodeCalculationResult calculateNodeClipPrecise(const Params& params, size_t i, typename NodeSlice<LengthType, ScoreType, Word, true>::NodeSliceMapItem& slice, const EqVector& EqV, typename NodeSlice<LengthType, ScoreType, Word, true>::NodeSliceMapItem previousSlice, const std::vector<EdgeWithPriority>& incoming, const PagedNodeSet& previousBand, NodeChunkType nodeChunks)
 	{
 		return calculateNodeInner<true, true>(params, i, slice, EqV, previousSlice, incoming, [&previousBand](size_t pos) { return previousBand[pos]; }, nodeChunks, [](const WordSlice& slice){});
 	}
@@ -864,7 +973,7 @@ public:
 #ifdef NDEBUG
 	__attribute__((always_inline))
 #endif
-	static NodeCalculationResult calculateNodeClipApprox(const Params& params, size_t i, typename NodeSlice<LengthType, ScoreType, Word, true>::NodeSliceMapItem& slice, const EqVector& EqV, typename NodeSlice<LengthType, ScoreType, Word, true>::NodeSliceMapItem previousSlice, const std::vector<EdgeWithPriority>& incoming, const std::vector<bool>& previousBand, NodeChunkType nodeChunks)
+	static NodeCalculationResult calculateNodeClipApprox(const Params& params, size_t i, typename NodeSlice<LengthType, ScoreType, Word, true>::NodeSliceMapItem& slice, const EqVector& EqV, typename NodeSlice<LengthType, ScoreType, Word, true>::NodeSliceMapItem previousSlice, const std::vector<EdgeWithPriority>& incoming, const PagedNodeSet& previousBand, NodeChunkType nodeChunks)
 	{
 		return calculateNodeInner<false, true>(params, i, slice, EqV, previousSlice, incoming, [&previousBand](size_t pos) { return previousBand[pos]; }, nodeChunks, [](const WordSlice& slice){});
 	}
@@ -1078,8 +1187,8 @@ public:
 					for (; fixoffset < WordConfiguration<Word>::WordSize; fixoffset++)
 					{
 						ScoreType newScoreComparison = scoreComparison;
-						newScoreComparison += (previousSlice.HP[fixchunk] >> fixoffset) & 1;
-						newScoreComparison -= (previousSlice.HN[fixchunk] >> fixoffset) & 1;
+						newScoreComparison += (ScoreType)((previousSlice.HP[fixchunk] >> fixoffset) & 1);
+						newScoreComparison -= (ScoreType)((previousSlice.HN[fixchunk] >> fixoffset) & 1);
 						Word mask = ((Word)1) << fixoffset;
 						assert(scoreBefore <= newScoreComparison);
 						if (scoreBefore < newScoreComparison)
@@ -1114,18 +1223,19 @@ public:
 		if (!previousSlice.exists) forceEq ^= 1;
 		size_t smallChunk = 0;
 		size_t offset = 1;
-		pos = smallChunk * (WordConfiguration<Word>::WordSize / 2) + offset;
+		pos = smallChunk * params.graph.BP_IN_CHUNK + offset;
 		for (; smallChunk < params.graph.CHUNKS_IN_NODE; smallChunk++)
 		{
-			size_t bigChunk = smallChunk / 2;
-			size_t bigChunkOffset = (smallChunk % 2) * (WordConfiguration<Word>::WordSize / 2);
+			//character chunks are always 64 bits but the horizontal score vectors are word sized
+			size_t bigChunk = (smallChunk * params.graph.BP_IN_CHUNK) / WordConfiguration<Word>::WordSize;
+			size_t bigChunkOffset = (smallChunk * params.graph.BP_IN_CHUNK) % WordConfiguration<Word>::WordSize;
 			Word HP = previousSlice.HP[bigChunk] >> bigChunkOffset;
 			Word HN = previousSlice.HN[bigChunk] >> bigChunkOffset;
 			auto charChunk = nodeChunks[smallChunk];
 			HP >>= offset;
 			HN >>= offset;
 			charChunk >>= offset * 2;
-			for (; offset < WordConfiguration<Word>::WordSize / 2 && pos < nodeLength; offset++)
+			for (; offset < params.graph.BP_IN_CHUNK && pos < nodeLength; offset++)
 			{
 				Eq = EqV.getEqI(charChunk & 3);
 				Eq &= forceEq;
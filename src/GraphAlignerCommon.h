@@ -1,13 +1,89 @@
 #ifndef GraphAlignerCommon_h
 #define GraphAlignerCommon_h
 
+#include <string>
 #include <vector>
 #include "AlignmentGraph.h"
 #include "ArrayPriorityQueue.h"
 #include "ComponentPriorityQueue.h"
 #include "NodeSlice.h"
+#include "PagedNodeArray.h"
 #include "WordSlice.h"
 #include "DijkstraQueue.h"
+#include "MemoryArena.h"
+#include "AlignerCounters.h"
+#include "SeedExtensionPool.h"
+
+//traces don't depend on the word size so alignments from all word sizes have the same type
+template <typename ScoreType>
+class GraphAlignerTrace
+{
+public:
+	using MatrixPosition = AlignmentGraph::MatrixPosition;
+	struct TraceItem
+	{
+		TraceItem() :
+		DPposition(),
+		nodeSwitch(false),
+		sequenceCharacter('-'),
+		graphCharacter('-')
+		{}
+		TraceItem(MatrixPosition DPposition, bool nodeSwitch, char sequenceCharacter, char graphCharacter) :
+		DPposition(DPposition),
+		nodeSwitch(nodeSwitch),
+		sequenceCharacter(sequenceCharacter),
+		graphCharacter(graphCharacter)
+		{}
+		TraceItem(MatrixPosition DPposition, bool nodeSwitch, const std::string& seq, const AlignmentGraph& graph) :
+		DPposition(DPposition),
+		nodeSwitch(nodeSwitch),
+		sequenceCharacter(DPposition.seqPos < seq.size() ? seq[DPposition.seqPos] : '-'),
+		graphCharacter(graph.NodeSequences(DPposition.node, DPposition.nodeOffset))
+		{}
+		TraceItem(MatrixPosition DPposition, bool nodeSwitch, const std::string_view& seq, const AlignmentGraph& graph) :
+		DPposition(DPposition),
+		nodeSwitch(nodeSwitch),
+		sequenceCharacter(DPposition.seqPos < seq.size() ? seq[DPposition.seqPos] : '-'),
+		graphCharacter(graph.NodeSequences(DPposition.node, DPposition.nodeOffset))
+		{}
+		MatrixPosition DPposition;
+		bool nodeSwitch;
+		char sequenceCharacter;
+		char graphCharacter;
+	};
+	class OnewayTrace
+	{
+	public:
+		OnewayTrace() :
+		trace(),
+		score(0)
+		{
+		}
+		// force move semantics because copying is very slow and unnecessary
+		OnewayTrace(const OnewayTrace& other) = delete;
+		OnewayTrace(OnewayTrace&& other) = default;
+		OnewayTrace& operator=(const OnewayTrace& other) = delete;
+		OnewayTrace& operator=(OnewayTrace&& other) = default;
+		static OnewayTrace TraceFailed()
+		{
+			OnewayTrace result;
+			result.score = std::numeric_limits<ScoreType>::max();
+			return result;
+		}
+		bool failed() const
+		{
+			return score == std::numeric_limits<ScoreType>::max();
+		}
+		std::vector<TraceItem> trace;
+		ScoreType score;
+	};
+	class Trace
+	{
+	public:
+		OnewayTrace forward;
+		OnewayTrace backward;
+	};
+};
 
 template <typename LengthType, typename ScoreType, typename Word>
 class GraphAlignerCommon
@@ -51,48 +127,65 @@ public:
 	};
 	class AlignerGraphsizedState
 	{
+		//node slice items kept allocated between alignments, per thread
+		static constexpr size_t MaxRetainedNodesliceItems = (size_t)1 << 18;
 	public:
 		AlignerGraphsizedState(const AlignmentGraph& graph, size_t maxBandwidth, bool lowMemory) :
 		componentQueue(),
 		calculableQueue(),
-		evenNodesliceMap(),
-		oddNodesliceMap(),
-		currentBand(),
-		previousBand()
+		evenNodesliceMap(lowMemory ? 0 : graph.NodeSize()),
+		oddNodesliceMap(lowMemory ? 0 : graph.NodeSize()),
+		currentBand(graph.NodeSize()),
+		previousBand(graph.NodeSize()),
+		arena(),
+		reverseSequence(),
+		counters()
 		{
-			if (!lowMemory)
-			{
-				evenNodesliceMap.resize(graph.NodeSize(), {});
-				oddNodesliceMap.resize(graph.NodeSize(), {});
-			}
 			componentQueue.initialize(graph.ComponentSize());
 			calculableQueue.initialize(WordConfiguration<Word>::WordSize * (WordConfiguration<Word>::WordSize + maxBandwidth + 1) + maxBandwidth + 1, graph.NodeSize());
-			currentBand.resize(graph.NodeSize(), false);
-			previousBand.resize(graph.NodeSize(), false);
 		}
+		//only touches the parts of the graph the previous alignments used
 		void clear()
 		{
-			evenNodesliceMap.assign(evenNodesliceMap.size(), {});
-			oddNodesliceMap.assign(oddNodesliceMap.size(), {});
+			evenNodesliceMap.clear();
+			oddNodesliceMap.clear();
 			componentQueue.clear();
 			calculableQueue.clear();
 			dijkstraQueue.clear();
-			currentBand.assign(currentBand.size(), false);
-			previousBand.assign(previousBand.size(), false);
+			currentBand.clear();
+			previousBand.clear();
+			arena.reset();
+			arena.takeAllocatedBytes();
+		}
+		//called between alignments, when no node slice is in use. keeps the pages for the next alignment unless there are too many
+		void releaseNodeslicePages()
+		{
+			if (evenNodesliceMap.allocatedItems() + oddNodesliceMap.allocatedItems() > MaxRetainedNodesliceItems)
+			{
+				evenNodesliceMap.clear();
+				oddNodesliceMap.clear();
+			}
 		}
 		ComponentPriorityQueue<EdgeWithPriority, true> componentQueue;
 		ArrayPriorityQueue<EdgeWithPriority, true> calculableQueue;
 		DijkstraPriorityQueue<EdgeWithPriority> dijkstraQueue;
-		std::vector<typename NodeSlice<LengthType, ScoreType, Word, true>::MapItem> evenNodesliceMap;
-		std::vector<typename NodeSlice<LengthType, ScoreType, Word, true>::MapItem> oddNodesliceMap;
-		std::vector<bool> currentBand;
-		std::vector<bool> previousBand;
+		PagedNodeArray<typename NodeSlice<LengthType, ScoreType, Word, true>::MapItem> evenNodesliceMap;
+		PagedNodeArray<typename NodeSlice<LengthType, ScoreType, Word, true>::MapItem> oddNodesliceMap;
+		PagedNodeSet currentBand;
+		PagedNodeSet previousBand;
+		//DP tables of the current alignment
+		MemoryArena arena;
+		//reverse complement of the current read, kept here so its buffer is reused between reads
+		std::string reverseSequence;
+		//work done by this thread since the owner last took the counters, not reset by clear
+		AlignerCounters counters;
 	};
+	using ExtensionPool = SeedExtensionPool<AlignerGraphsizedState>;
 	using MatrixPosition = AlignmentGraph::MatrixPosition;
 	class Params
 	{
 	public:
-		Params(LengthType initialBandwidth, LengthType rampBandwidth, const AlignmentGraph& graph, size_t maxCellsPerSlice, bool quietMode, bool sloppyOptimizations, bool lowMemory, bool forceGlobal, bool preciseClipping, size_t minSeedClusterSize, double seedExtendDensity, bool nondeterministicOptimizations, double preciseClippingIdentityCutoff, int Xdropcutoff) :
+		Params(LengthType initialBandwidth, LengthType rampBandwidth, const AlignmentGraph& graph, size_t maxCellsPerSlice, bool quietMode, bool sloppyOptimizations, bool lowMemory, bool forceGlobal, bool preciseClipping, size_t minSeedClusterSize, double seedExtendDensity, bool nondeterministicOptimizations, double preciseClippingIdentityCutoff, int Xdropcutoff, size_t maxTraceTableBytes) :
 		initialBandwidth(initialBandwidth),
 		rampBandwidth(rampBandwidth),
 		graph(graph),
@@ -106,7 +199,8 @@ public:
 		seedExtendDensity(seedExtendDensity),
 		nondeterministicOptimizations(nondeterministicOptimizations),
 		XscoreErrorCost(preciseClippingIdentityCutoff / (1.0 - preciseClippingIdentityCutoff) + 1.0),
-		Xdropcutoff(Xdropcutoff)
+		Xdropcutoff(Xdropcutoff),
+		maxTraceTableBytes(maxTraceTableBytes)
 		{
 		}
 		const LengthType initialBandwidth;
@@ -123,70 +217,12 @@ public:
 		const bool nondeterministicOptimizations;
 		const double XscoreErrorCost;
 		const int Xdropcutoff;
+		//0 for unlimited
+		const size_t maxTraceTableBytes;
 	};
-	struct TraceItem
-	{
-		TraceItem() :
-		DPposition(),
-		nodeSwitch(false),
-		sequenceCharacter('-'),
-		graphCharacter('-')
-		{}
-		TraceItem(MatrixPosition DPposition, bool nodeSwitch, char sequenceCharacter, char graphCharacter) :
-		DPposition(DPposition),
-		nodeSwitch(nodeSwitch),
-		sequenceCharacter(sequenceCharacter),
-		graphCharacter(graphCharacter)
-		{}
-		TraceItem(MatrixPosition DPposition, bool nodeSwitch, const std::string& seq, const AlignmentGraph& graph) :
-		DPposition(DPposition),
-		nodeSwitch(nodeSwitch),
-		sequenceCharacter(DPposition.seqPos < seq.size() ? seq[DPposition.seqPos] : '-'),
-		graphCharacter(graph.NodeSequences(DPposition.node, DPposition.nodeOffset))
-		{}
-		TraceItem(MatrixPosition DPposition, bool nodeSwitch, const std::string_view& seq, const AlignmentGraph& graph) :
-		DPposition(DPposition),
-		nodeSwitch(nodeSwitch),
-		sequenceCharacter(DPposition.seqPos < seq.size() ? seq[DPposition.seqPos] : '-'),
-		graphCharacter(graph.NodeSequences(DPposition.node, DPposition.nodeOffset))
-		{}
-		MatrixPosition DPposition;
-		bool nodeSwitch;
-		char sequenceCharacter;
-		char graphCharacter;
-	};
-	class OnewayTrace
-	{
-	public:
-		OnewayTrace() :
-		trace(),
-		score(0)
-		{
-		}
-		// force move semantics because copying is very slow and unnecessary
-		OnewayTrace(const OnewayTrace& other) = delete;
-		OnewayTrace(OnewayTrace&& other) = default;
-		OnewayTrace& operator=(const OnewayTrace& other) = delete;
-		OnewayTrace& operator=(OnewayTrace&& other) = default;
-		static OnewayTrace TraceFailed()
-		{
-			OnewayTrace result;
-			result.score = std::numeric_limits<ScoreType>::max();
-			return result;
-		}
-		bool failed() const
-		{
-			return score == std::numeric_limits<ScoreType>::max();
-		}
-		std::vector<TraceItem> trace;
-		ScoreType score;
-	};
-	class Trace
-	{
-	public:
-		OnewayTrace forward;
-		OnewayTrace backward;
-	};
+	using TraceItem = typename GraphAlignerTrace<ScoreType>::TraceItem;
+	using OnewayTrace = typename GraphAlignerTrace<ScoreType>::OnewayTrace;
+	using Trace = typename GraphAlignerTrace<ScoreType>::Trace;
 #ifdef NDEBUG
 	__attribute__((always_inline))
 #endif
@@ -311,6 +347,7 @@ public:
 		alignment(),
 		trace(),
 		seedGoodness(0),
+		seedChain(std::numeric_limits<size_t>::max()),
 		cellsProcessed(0),
 		elapsedMilliseconds(0),
 		alignmentStart(0),
@@ -321,6 +358,7 @@ public:
 		corrected(),
 		alignment(),
 		trace(),
+		seedChain(std::numeric_limits<size_t>::max()),
 		cellsProcessed(cellsProcessed),
 		elapsedMilliseconds(ms),
 		alignmentStart(0),
@@ -339,10 +377,10 @@ public:
 			return alignmentEnd - alignmentStart;
 		}
 		std::string corrected;
-		std::string GAFline;
 		std::shared_ptr<vg::Alignment> alignment;
 		std::shared_ptr<GraphAlignerCommon<size_t, int32_t, uint64_t>::OnewayTrace> trace;
 		size_t seedGoodness;
+		size_t seedChain;
 		size_t cellsProcessed;
 		size_t elapsedMilliseconds;
 		size_t alignmentStart;
@@ -1,7 +1,10 @@
 #ifndef GraphAlignerGAFAlignment_h
 #define GraphAlignerGAFAlignment_h
 
+#include <charconv>
+#include <cstdio>
 #include <string>
+#include <string_view>
 #include <vector>
 #include "AlignmentGraph.h"
 #include "NodeSlice.h"
@@ -34,17 +37,18 @@ class GraphAlignerGAFAlignment
 	};
 public:
 
-	static std::string traceToAlignment(const std::string& seq_id, const std::string& sequence, const GraphAlignerCommon<size_t, int32_t, uint64_t>::OnewayTrace& tracePair, const Params& params, bool cigarMatchMismatchMerge)
+	//appends the GAF line without the newline to out
+	static void traceToAlignment(const std::string_view& seq_id, const std::string_view& sequence, const GraphAlignerCommon<size_t, int32_t, uint64_t>::OnewayTrace& tracePair, const Params& params, bool cigarMatchMismatchMerge, std::string& out)
 	{
 		auto& trace = tracePair.trace;
-		if (trace.size() == 0) return nullptr;
-		std::stringstream cigar;
-		std::string readName = seq_id;
+		if (trace.size() == 0) return;
+		//the cigar is the last column but is built during the same pass as the node path, so it goes into a reused buffer
+		static thread_local std::string cigar;
+		cigar.clear();
 		size_t readLen = sequence.size();
 		size_t readStart = trace[0].DPposition.seqPos;
 		size_t readEnd = trace.back().DPposition.seqPos+1;
 		bool strand = true;
-		std::stringstream nodePath;
 		size_t nodePathLen = 0;
 		size_t nodePathStart = trace[0].DPposition.nodeOffset;
 		size_t nodePathEnd = 0;
@@ -87,7 +91,17 @@ public:
 			editLength = 1;
 			mismatches += 1;
 		}
-		addPosToString(nodePath, currentPos, params);
+		out.append(seq_id);
+		out += '\t';
+		appendNumber(out, readLen);
+		out += '\t';
+		appendNumber(out, readStart);
+		out += '\t';
+		appendNumber(out, readEnd);
+		out += '\t';
+		out += (strand ? '+' : '-');
+		out += '\t';
+		addPosToString(out, currentPos, params);
 		nodePathLen += params.graph.originalNodeSize.at(currentPos.nodeId);
 		for (size_t pos = 1; pos < trace.size(); pos++)
 		{
@@ -105,7 +119,7 @@ public:
 			{
 				size_t skippedBefore = params.graph.originalNodeSize.at(currentPos.nodeId) - 1 - trace[pos-1].DPposition.nodeOffset;
 				currentPos = newPos;
-				addPosToString(nodePath, currentPos, params);
+				addPosToString(out, currentPos, params);
 				assert(trace[pos].DPposition.nodeOffset < params.graph.originalNodeSize.at(currentPos.nodeId));
 				size_t skippedAfter = trace[pos].DPposition.nodeOffset;
 				nodePathLen += params.graph.originalNodeSize.at(currentPos.nodeId) - (skippedBefore + skippedAfter);
@@ -190,58 +204,87 @@ public:
 
 		nodePathEnd = nodePathLen - (params.graph.originalNodeSize.at(trace.back().DPposition.node) - 1 - trace.back().DPposition.nodeOffset);
 
-		std::stringstream sstr;
-		sstr << readName << "\t" << readLen << "\t" << readStart << "\t" << readEnd << "\t" << (strand ? "+" : "-") << "\t" << nodePath.str() << "\t" << nodePathLen << "\t" << nodePathStart << "\t" << nodePathEnd << "\t" << matches << "\t" << blockLength << "\t" << mappingQuality;
-		sstr << "\t" << "NM:i:" << (mismatches + deletions + insertions);
-		sstr << "\t" << "dv:f:" << 1.0-((double)matches / (double)(matches + mismatches + deletions + insertions));
-		sstr << "\t" << "id:f:" << ((double)matches / (double)(matches + mismatches + deletions + insertions));
-		sstr << "\t" << "cg:Z:" << cigar.str();
-		return sstr.str();
+		out += '\t';
+		appendNumber(out, nodePathLen);
+		out += '\t';
+		appendNumber(out, nodePathStart);
+		out += '\t';
+		appendNumber(out, nodePathEnd);
+		out += '\t';
+		appendNumber(out, matches);
+		out += '\t';
+		appendNumber(out, blockLength);
+		out += '\t';
+		appendNumber(out, mappingQuality);
+		out += "\tNM:i:";
+		appendNumber(out, mismatches + deletions + insertions);
+		out += "\tdv:f:";
+		appendDouble(out, 1.0-((double)matches / (double)(matches + mismatches + deletions + insertions)));
+		out += "\tid:f:";
+		appendDouble(out, ((double)matches / (double)(matches + mismatches + deletions + insertions)));
+		out += "\tcg:Z:";
+		out += cigar;
 	}
 
 private:
 
-	static void addPosToString(std::stringstream& str, MergedNodePos pos, const Params& params)
+	template <typename T>
+	static void appendNumber(std::string& str, T value)
+	{
+		char buf[24];
+		auto result = std::to_chars(buf, buf + sizeof(buf), value);
+		str.append(buf, result.ptr - buf);
+	}
+
+	//same formatting as the default ostream formatting of a double
+	static void appendDouble(std::string& str, double value)
+	{
+		char buf[32];
+		int length = snprintf(buf, sizeof(buf), "%g", value);
+		str.append(buf, length);
+	}
+
+	static void addPosToString(std::string& str, MergedNodePos pos, const Params& params)
 	{
 		if (pos.reverse)
 		{
-			str << "<";
+			str += '<';
 		}
 		else
 		{
-			str << ">";
+			str += '>';
 		}
-		std::string nodeName = params.graph.originalNodeName.at(pos.nodeId);
+		const std::string& nodeName = params.graph.originalNodeName.at(pos.nodeId);
 		if (nodeName == "")
 		{
-			str << pos.nodeId/2;
+			appendNumber(str, pos.nodeId/2);
 		}
 		else
 		{
-			str << nodeName;
+			str += nodeName;
 		}
 	}
 
-	static void addCigarItem(std::stringstream& str, size_t editLength, EditType type)
+	static void addCigarItem(std::string& str, size_t editLength, EditType type)
 	{
 		if (editLength == 0) return;
-		str << editLength;
+		appendNumber(str, editLength);
 		switch(type)
 		{
 			case MatchOrMismatch:
-				str << "M";
+				str += 'M';
 				break;
 			case Match:
-				str << "=";
+				str += '=';
 				break;
 			case Mismatch:
-				str << "X";
+				str += 'X';
 				break;
 			case Insertion:
-				str << "I";
+				str += 'I';
 				break;
 			case Deletion:
-				str << "D";
+				str += 'D';
 				break;
 			case Empty:
 			default:
@@ -2,6 +2,7 @@
 #define GraphAlignerVGAlignment_h
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include "AlignmentGraph.h"
 #include "vg.pb.h"
@@ -34,14 +35,14 @@ class GraphAlignerVGAlignment
 	};
 public:
 
-	static std::shared_ptr<vg::Alignment> traceToAlignment(const std::string& seq_id, const std::string& sequence, ScoreType score, const std::vector<TraceItem>& trace, size_t cellsProcessed, bool reverse)
+	static std::shared_ptr<vg::Alignment> traceToAlignment(const std::string_view& seq_id, const std::string_view& sequence, ScoreType score, const std::vector<TraceItem>& trace, size_t cellsProcessed, bool reverse)
 	{
 		if (trace.size() == 0) return nullptr;
 		vg::Alignment* aln = new vg::Alignment;
 		std::shared_ptr<vg::Alignment> result { aln };
-		result->set_name(seq_id);
+		result->set_name(std::string { seq_id });
 		result->set_score(score);
-		result->set_sequence(sequence);
+		result->set_sequence(std::string { sequence });
 		auto path = new vg::Path;
 		result->set_allocated_path(path);
 		MergedNodePos currentPos;
@@ -5,51 +5,83 @@
 #include "GraphAligner.h"
 #include "ThreadReadAssertion.h"
 
-AlignmentResult AlignOneWay(const AlignmentGraph& graph, const std::string& seq_id, const std::string& sequence, size_t initialBandwidth, size_t rampBandwidth, bool quietMode, GraphAlignerCommon<size_t, int32_t, uint64_t>::AlignerGraphsizedState& reusableState, bool lowMemory, bool forceGlobal, bool preciseClipping, bool nondeterministicOptimizations, double preciseClippingIdentityCutoff, int Xdropcutoff, size_t DPRestartStride)
+template <typename Word>
+AlignmentResult AlignOneWayWithWord(const AlignmentGraph& graph, const std::string_view& seq_id, const std::string_view& sequence, size_t initialBandwidth, size_t rampBandwidth, bool quietMode, typename GraphAlignerCommon<size_t, int32_t, Word>::AlignerGraphsizedState& reusableState, bool lowMemory, bool forceGlobal, bool preciseClipping, bool nondeterministicOptimizations, double preciseClippingIdentityCutoff, int Xdropcutoff, size_t maxTraceMemory, size_t DPRestartStride)
 {
-	GraphAlignerCommon<size_t, int32_t, uint64_t>::Params params {initialBandwidth, rampBandwidth, graph, std::numeric_limits<size_t>::max(), quietMode, false, lowMemory, forceGlobal, preciseClipping, 1, 0, nondeterministicOptimizations, preciseClippingIdentityCutoff, Xdropcutoff};
-	GraphAligner<size_t, int32_t, uint64_t> aligner {params};
+	typename GraphAlignerCommon<size_t, int32_t, Word>::Params params {initialBandwidth, rampBandwidth, graph, std::numeric_limits<size_t>::max(), quietMode, false, lowMemory, forceGlobal, preciseClipping, 1, 0, nondeterministicOptimizations, preciseClippingIdentityCutoff, Xdropcutoff, maxTraceMemory};
+	GraphAligner<size_t, int32_t, Word> aligner {params};
 	return aligner.AlignOneWay(seq_id, sequence, reusableState, DPRestartStride);
 }
 
-AlignmentResult AlignOneWayDijkstra(const AlignmentGraph& graph, const std::string& seq_id, const std::string& sequence, bool quietMode, GraphAlignerCommon<size_t, int32_t, uint64_t>::AlignerGraphsizedState& reusableState, bool forceGlobal, bool preciseClipping)
+template <typename Word>
+AlignmentResult AlignOneWayWithWord(const AlignmentGraph& graph, const std::string_view& seq_id, const std::string_view& sequence, size_t initialBandwidth, size_t rampBandwidth, size_t maxCellsPerSlice, bool quietMode, bool sloppyOptimizations, const std::vector<SeedHit>& seedHits, typename GraphAlignerCommon<size_t, int32_t, Word>::AlignerGraphsizedState& reusableState, bool lowMemory, bool forceGlobal, bool preciseClipping, size_t minClusterSize, double seedExtendDensity, bool nondeterministicOptimizations, double preciseClippingIdentityCutoff, int Xdropcutoff, size_t maxTraceMemory, typename GraphAlignerCommon<size_t, int32_t, Word>::ExtensionPool* extensionPool)
+{
+	typename GraphAlignerCommon<size_t, int32_t, Word>::Params params {initialBandwidth, rampBandwidth, graph, maxCellsPerSlice, quietMode, sloppyOptimizations, lowMemory, forceGlobal, preciseClipping, minClusterSize, seedExtendDensity, nondeterministicOptimizations, preciseClippingIdentityCutoff, Xdropcutoff, maxTraceMemory};
+	GraphAligner<size_t, int32_t, Word> aligner {params};
+	return aligner.AlignOneWay(seq_id, sequence, seedHits, reusableState, extensionPool);
+}
+
+AlignmentResult AlignOneWay(const AlignmentGraph& graph, const std::string_view& seq_id, const std::string_view& sequence, size_t initialBandwidth, size_t rampBandwidth, bool quietMode, GraphAlignerCommon<size_t, int32_t, uint64_t>::AlignerGraphsizedState& reusableState, bool lowMemory, bool forceGlobal, bool preciseClipping, bool nondeterministicOptimizations, double preciseClippingIdentityCutoff, int Xdropcutoff, size_t maxTraceMemory, size_t DPRestartStride)
+{
+	return AlignOneWayWithWord<uint64_t>(graph, seq_id, sequence, initialBandwidth, rampBandwidth, quietMode, reusableState, lowMemory, forceGlobal, preciseClipping, nondeterministicOptimizations, preciseClippingIdentityCutoff, Xdropcutoff, maxTraceMemory, DPRestartStride);
+}
+
+AlignmentResult AlignOneWay(const AlignmentGraph& graph, const std::string_view& seq_id, const std::string_view& sequence, size_t initialBandwidth, size_t rampBandwidth, bool quietMode, GraphAlignerCommon<size_t, int32_t, __uint128_t>::AlignerGraphsizedState& reusableState, bool lowMemory, bool forceGlobal, bool preciseClipping, bool nondeterministicOptimizations, double preciseClippingIdentityCutoff, int Xdropcutoff, size_t maxTraceMemory, size_t DPRestartStride)
+{
+	return AlignOneWayWithWord<__uint128_t>(graph, seq_id, sequence, initialBandwidth, rampBandwidth, quietMode, reusableState, lowMemory, forceGlobal, preciseClipping, nondeterministicOptimizations, preciseClippingIdentityCutoff, Xdropcutoff, maxTraceMemory, DPRestartStride);
+}
+
+AlignmentResult AlignOneWay(const AlignmentGraph& graph, const std::string_view& seq_id, const std::string_view& sequence, size_t initialBandwidth, size_t rampBandwidth, bool quietMode, GraphAlignerCommon<size_t, int32_t, Word256>::AlignerGraphsizedState& reusableState, bool lowMemory, bool forceGlobal, bool preciseClipping, bool nondeterministicOptimizations, double preciseClippingIdentityCutoff, int Xdropcutoff, size_t maxTraceMemory, size_t DPRestartStride)
 {
-	GraphAlignerCommon<size_t, int32_t, uint64_t>::Params params {1, 1, graph, std::numeric_limits<size_t>::max(), quietMode, false, true, forceGlobal, preciseClipping, 1, 0, false, .5, 0};
+	return AlignOneWayWithWord<Word256>(graph, seq_id, sequence, initialBandwidth, rampBandwidth, quietMode, reusableState, lowMemory, forceGlobal, preciseClipping, nondeterministicOptimizations, preciseClippingIdentityCutoff, Xdropcutoff, maxTraceMemory, DPRestartStride);
+}
+
+AlignmentResult AlignOneWayDijkstra(const AlignmentGraph& graph, const std::string_view& seq_id, const std::string_view& sequence, bool quietMode, GraphAlignerCommon<size_t, int32_t, uint64_t>::AlignerGraphsizedState& reusableState, bool forceGlobal, bool preciseClipping)
+{
+	GraphAlignerCommon<size_t, int32_t, uint64_t>::Params params {1, 1, graph, std::numeric_limits<size_t>::max(), quietMode, false, true, forceGlobal, preciseClipping, 1, 0, false, .5, 0, 0};
 	GraphAligner<size_t, int32_t, uint64_t> aligner {params};
 	return aligner.AlignOneWayDijkstra(seq_id, sequence, reusableState);
 }
 
-AlignmentResult AlignOneWay(const AlignmentGraph& graph, const std::string& seq_id, const std::string& sequence, size_t initialBandwidth, size_t rampBandwidth, size_t maxCellsPerSlice, bool quietMode, bool sloppyOptimizations, const std::vector<SeedHit>& seedHits, GraphAlignerCommon<size_t, int32_t, uint64_t>::AlignerGraphsizedState& reusableState, bool lowMemory, bool forceGlobal, bool preciseClipping, size_t minClusterSize, double seedExtendDensity, bool nondeterministicOptimizations, double preciseClippingIdentityCutoff, int Xdropcutoff)
+AlignmentResult AlignOneWay(const AlignmentGraph& graph, const std::string_view& seq_id, const std::string_view& sequence, size_t initialBandwidth, size_t rampBandwidth, size_t maxCellsPerSlice, bool quietMode, bool sloppyOptimizations, const std::vector<SeedHit>& seedHits, GraphAlignerCommon<size_t, int32_t, uint64_t>::AlignerGraphsizedState& reusableState, bool lowMemory, bool forceGlobal, bool preciseClipping, size_t minClusterSize, double seedExtendDensity, bool nondeterministicOptimizations, double preciseClippingIdentityCutoff, int Xdropcutoff, size_t maxTraceMemory, GraphAlignerCommon<size_t, int32_t, uint64_t>::ExtensionPool* extensionPool)
 {
-	GraphAlignerCommon<size_t, int32_t, uint64_t>::Params params {initialBandwidth, rampBandwidth, graph, maxCellsPerSlice, quietMode, sloppyOptimizations, lowMemory, forceGlobal, preciseClipping, minClusterSize, seedExtendDensity, nondeterministicOptimizations, preciseClippingIdentityCutoff, Xdropcutoff};
-	GraphAligner<size_t, int32_t, uint64_t> aligner {params};
-	return aligner.AlignOneWay(seq_id, sequence, seedHits, reusableState);
+	return AlignOneWayWithWord<uint64_t>(graph, seq_id, sequence, initialBandwidth, rampBandwidth, maxCellsPerSlice, quietMode, sloppyOptimizations, seedHits, reusableState, lowMemory, forceGlobal, preciseClipping, minClusterSize, seedExtendDensity, nondeterministicOptimizations, preciseClippingIdentityCutoff, Xdropcutoff, maxTraceMemory, extensionPool);
+}
+
+AlignmentResult AlignOneWay(const AlignmentGraph& graph, const std::string_view& seq_id, const std::string_view& sequence, size_t initialBandwidth, size_t rampBandwidth, size_t maxCellsPerSlice, bool quietMode, bool sloppyOptimizations, const std::vector<SeedHit>& seedHits, GraphAlignerCommon<size_t, int32_t, __uint128_t>::AlignerGraphsizedState& reusableState, bool lowMemory, bool forceGlobal, bool preciseClipping, size_t minClusterSize, double seedExtendDensity, bool nondeterministicOptimizations, double preciseClippingIdentityCutoff, int Xdropcutoff, size_t maxTraceMemory, GraphAlignerCommon<size_t, int32_t, __uint128_t>::ExtensionPool* extensionPool)
+{
+	return AlignOneWayWithWord<__uint128_t>(graph, seq_id, sequence, initialBandwidth, rampBandwidth, maxCellsPerSlice, quietMode, sloppyOptimizations, seedHits, reusableState, lowMemory, forceGlobal, preciseClipping, minClusterSize, seedExtendDensity, nondeterministicOptimizations, preciseClippingIdentityCutoff, Xdropcutoff, maxTraceMemory, extensionPool);
+}
+
+AlignmentResult AlignOneWay(const AlignmentGraph& graph, const std::string_view& seq_id, const std::string_view& sequence, size_t initialBandwidth, size_t rampBandwidth, size_t maxCellsPerSlice, bool quietMode, bool sloppyOptimizations, const std::vector<SeedHit>& seedHits, GraphAlignerCommon<size_t, int32_t, Word256>::AlignerGraphsizedState& reusableState, bool lowMemory, bool forceGlobal, bool preciseClipping, size_t minClusterSize, double seedExtendDensity, bool nondeterministicOptimizations, double preciseClippingIdentityCutoff, int Xdropcutoff, size_t maxTraceMemory, GraphAlignerCommon<size_t, int32_t, Word256>::ExtensionPool* extensionPool)
+{
+	return AlignOneWayWithWord<Word256>(graph, seq_id, sequence, initialBandwidth, rampBandwidth, maxCellsPerSlice, quietMode, sloppyOptimizations, seedHits, reusableState, lowMemory, forceGlobal, preciseClipping, minClusterSize, seedExtendDensity, nondeterministicOptimizations, preciseClippingIdentityCutoff, Xdropcutoff, maxTraceMemory, extensionPool);
 }
 
-void AddAlignment(const std::string& seq_id, const std::string& sequence, AlignmentResult::AlignmentItem& alignment)
+void AddAlignment(const std::string_view& seq_id, const std::string_view& sequence, AlignmentResult::AlignmentItem& alignment)
 {
-	GraphAlignerCommon<size_t, int32_t, uint64_t>::Params params {1, 1, AlignmentGraph::DummyGraph(), 1, true, true, true, false, false, 1, 0, false, .5, 0};
+	GraphAlignerCommon<size_t, int32_t, uint64_t>::Params params {1, 1, AlignmentGraph::DummyGraph(), 1, true, true, true, false, false, 1, 0, false, .5, 0, 0};
 	GraphAligner<size_t, int32_t, uint64_t> aligner {params};
 	aligner.AddAlignment(seq_id, sequence, alignment);
 }
 
-void AddGAFLine(const AlignmentGraph& graph, const std::string& seq_id, const std::string& sequence, AlignmentResult::AlignmentItem& alignment, bool cigarMatchMismatchMerge)
+void AddGAFLine(const AlignmentGraph& graph, const std::string_view& seq_id, const std::string_view& sequence, const AlignmentResult::AlignmentItem& alignment, bool cigarMatchMismatchMerge, std::string& out)
 {
-	GraphAlignerCommon<size_t, int32_t, uint64_t>::Params params {1, 1, graph, 1, true, true, true, false, false, 1, 0, false, .5, 0};
+	GraphAlignerCommon<size_t, int32_t, uint64_t>::Params params {1, 1, graph, 1, true, true, true, false, false, 1, 0, false, .5, 0, 0};
 	GraphAligner<size_t, int32_t, uint64_t> aligner {params};
-	aligner.AddGAFLine(seq_id, sequence, alignment, cigarMatchMismatchMerge);
+	aligner.AddGAFLine(seq_id, sequence, alignment, cigarMatchMismatchMerge, out);
 }
 
 void AddCorrected(AlignmentResult::AlignmentItem& alignment)
 {
-	GraphAlignerCommon<size_t, int32_t, uint64_t>::Params params {1, 1, AlignmentGraph::DummyGraph(), 1, true, true, true, false, false, 1, 0, false, .5, 0};
+	GraphAlignerCommon<size_t, int32_t, uint64_t>::Params params {1, 1, AlignmentGraph::DummyGraph(), 1, true, true, true, false, false, 1, 0, false, .5, 0, 0};
 	GraphAligner<size_t, int32_t, uint64_t> aligner {params};
 	aligner.AddCorrected(alignment);
 }
 
 void OrderSeeds(const AlignmentGraph& graph, std::vector<SeedHit>& seedHits)
 {
-	GraphAlignerCommon<size_t, int32_t, uint64_t>::Params params {1, 1, graph, 1, true, true, true, false, false, 1, 0, false, .5, 0};
+	GraphAlignerCommon<size_t, int32_t, uint64_t>::Params params {1, 1, graph, 1, true, true, true, false, false, 1, 0, false, .5, 0, 0};
 	GraphAligner<size_t, int32_t, uint64_t> aligner {params};
 	aligner.orderSeedsByChaining(seedHits);
 }
@@ -4,6 +4,7 @@
 #define GraphAlignerWrapper_h
 
 #include <tuple>
+#include <string_view>
 #include "vg.pb.h"
 #include "GraphAlignerCommon.h"
 #include "AlignmentGraph.h"
@@ -21,7 +22,8 @@ public:
 	alignmentGraphNodeOffset(std::numeric_limits<size_t>::max()),
 	rawSeedGoodness(rawSeedGoodness),
 	seedGoodness(0),
-	seedClusterSize(0)
+	seedClusterSize(0),
+	seedChain(std::numeric_limits<size_t>::max())
 	{
 	}
 	int nodeID;
@@ -34,14 +36,20 @@ public:
 	size_t rawSeedGoodness;
 	size_t seedGoodness;
 	size_t seedClusterSize;
+	//rank of the colinear chain the seed is in, best first
+	size_t seedChain;
 };
 
-AlignmentResult AlignOneWay(const AlignmentGraph& graph, const std::string& seq_id, const std::string& sequence, size_t initialBandwidth, size_t rampBandwidth, bool quietMode, GraphAlignerCommon<size_t, int32_t, uint64_t>::AlignerGraphsizedState& reusableState, bool lowMemory, bool forceGlobal, bool preciseClipping, bool nondeterministicOptimizations, double preciseClippingIdentityCutoff, int Xdropcutoff, size_t DPRestartStride);
-AlignmentResult AlignOneWayDijkstra(const AlignmentGraph& graph, const std::string& seq_id, const std::string& sequence, bool quietMode, GraphAlignerCommon<size_t, int32_t, uint64_t>::AlignerGraphsizedState& reusableState, bool forceGlobal, bool preciseClipping);
-AlignmentResult AlignOneWay(const AlignmentGraph& graph, const std::string& seq_id, const std::string& sequence, size_t initialBandwidth, size_t rampBandwidth, size_t maxCellsPerSlice, bool quietMode, bool sloppyOptimizations, const std::vector<SeedHit>& seedHits, GraphAlignerCommon<size_t, int32_t, uint64_t>::AlignerGraphsizedState& reusableState, bool lowMemory, bool forceGlobal, bool preciseClipping, size_t minClusterSize, double seedExtendDensity, bool nondeterministicOptimizations, double preciseClippingIdentityCutoff, int Xdropcutoff);
+AlignmentResult AlignOneWay(const AlignmentGraph& graph, const std::string_view& seq_id, const std::string_view& sequence, size_t initialBandwidth, size_t rampBandwidth, bool quietMode, GraphAlignerCommon<size_t, int32_t, uint64_t>::AlignerGraphsizedState& reusableState, bool lowMemory, bool forceGlobal, bool preciseClipping, bool nondeterministicOptimizations, double preciseClippingIdentityCutoff, int Xdropcutoff, size_t maxTraceMemory, size_t DPRestartStride);
+AlignmentResult AlignOneWay(const AlignmentGraph& graph, const std::string_view& seq_id, const std::string_view& sequence, size_t initialBandwidth, size_t rampBandwidth, bool quietMode, GraphAlignerCommon<size_t, int32_t, __uint128_t>::AlignerGraphsizedState& reusableState, bool lowMemory, bool forceGlobal, bool preciseClipping, bool nondeterministicOptimizations, double preciseClippingIdentityCutoff, int Xdropcutoff, size_t maxTraceMemory, size_t DPRestartStride);
+AlignmentResult AlignOneWay(const AlignmentGraph& graph, const std::string_view& seq_id, const std::string_view& sequence, size_t initialBandwidth, size_t rampBandwidth, bool quietMode, GraphAlignerCommon<size_t, int32_t, Word256>::AlignerGraphsizedState& reusableState, bool lowMemory, bool forceGlobal, bool preciseClipping, bool nondeterministicOptimizations, double preciseClippingIdentityCutoff, int Xdropcutoff, size_t maxTraceMemory, size_t DPRestartStride);
+AlignmentResult AlignOneWayDijkstra(const AlignmentGraph& graph, const std::string_view& seq_id, const std::string_view& sequence, bool quietMode, GraphAlignerCommon<size_t, int32_t, uint64_t>::AlignerGraphsizedState& reusableState, bool forceGlobal, bool preciseClipping);
+AlignmentResult AlignOneWay(const AlignmentGraph& graph, const std::string_view& seq_id, const std::string_view& sequence, size_t initialBandwidth, size_t rampBandwidth, size_t maxCellsPerSlice, bool quietMode, bool sloppyOptimizations, const std::vector<SeedHit>& seedHits, GraphAlignerCommon<size_t, int32_t, uint64_t>::AlignerGraphsizedState& reusableState, bool lowMemory, bool forceGlobal, bool preciseClipping, size_t minClusterSize, double seedExtendDensity, bool nondeterministicOptimizations, double preciseClippingIdentityCutoff, int Xdropcutoff, size_t maxTraceMemory, GraphAlignerCommon<size_t, int32_t, uint64_t>::ExtensionPool* extensionPool = nullptr);
+AlignmentResult AlignOneWay(const AlignmentGraph& graph, const std::string_view& seq_id, const std::string_view& sequence, size_t initialBandwidth, size_t rampBandwidth, size_t maxCellsPerSlice, bool quietMode, bool sloppyOptimizations, const std::vector<SeedHit>& seedHits, GraphAlignerCommon<size_t, int32_t, __uint128_t>::AlignerGraphsizedState& reusableState, bool lowMemory, bool forceGlobal, bool preciseClipping, size_t minClusterSize, double seedExtendDensity, bool nondeterministicOptimizations, double preciseClippingIdentityCutoff, int Xdropcutoff, size_t maxTraceMemory, GraphAlignerCommon<size_t, int32_t, __uint128_t>::ExtensionPool* extensionPool = nullptr);
+AlignmentResult AlignOneWay(const AlignmentGraph& graph, const std::string_view& seq_id, const std::string_view& sequence, size_t initialBandwidth, size_t rampBandwidth, size_t maxCellsPerSlice, bool quietMode, bool sloppyOptimizations, const std::vector<SeedHit>& seedHits, GraphAlignerCommon<size_t, int32_t, Word256>::AlignerGraphsizedState& reusableState, bool lowMemory, bool forceGlobal, bool preciseClipping, size_t minClusterSize, double seedExtendDensity, bool nondeterministicOptimizations, double preciseClippingIdentityCutoff, int Xdropcutoff, size_t maxTraceMemory, GraphAlignerCommon<size_t, int32_t, Word256>::ExtensionPool* extensionPool = nullptr);
 
-void AddAlignment(const std::string& seq_id, const std::string& sequence, AlignmentResult::AlignmentItem& alignment);
-void AddGAFLine(const AlignmentGraph& graph, const std::string& seq_id, const std::string& sequence, AlignmentResult::AlignmentItem& alignment, bool cigarMatchMismatchMerge);
+void AddAlignment(const std::string_view& seq_id, const std::string_view& sequence, AlignmentResult::AlignmentItem& alignment);
+void AddGAFLine(const AlignmentGraph& graph, const std::string_view& seq_id, const std::string_view& sequence, const AlignmentResult::AlignmentItem& alignment, bool cigarMatchMismatchMerge, std::string& out);
 void AddCorrected(AlignmentResult::AlignmentItem& alignment);
 void OrderSeeds(const AlignmentGraph& graph, std::vector<SeedHit>& seedHits);
 
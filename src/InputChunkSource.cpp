@@ -0,0 +1,359 @@
+#include <cassert>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+#include "BlockingQueue.h"
+#include "InputChunkSource.h"
+
+const size_t InputChunkSize = 1024 * 1024;
+//bgzf blocks decompress to at most 64kb so a job is around one chunk
+const size_t BgzfBlocksPerJob = 16;
+//ID1 ID2 CM FLG MTIME XFL OS XLEN
+const size_t GzipFixedHeaderSize = 12;
+//CRC32 ISIZE
+const size_t GzipTrailerSize = 8;
+
+uint16_t readLittleEndian16(const unsigned char* pos)
+{
+	return (uint16_t)pos[0] | ((uint16_t)pos[1] << 8);
+}
+
+uint32_t readLittleEndian32(const unsigned char* pos)
+{
+	return (uint32_t)pos[0] | ((uint32_t)pos[1] << 8) | ((uint32_t)pos[2] << 16) | ((uint32_t)pos[3] << 24);
+}
+
+bool isGzipHeader(const unsigned char* header, size_t size)
+{
+	return size >= 3 && header[0] == 0x1f && header[1] == 0x8b && header[2] == 8;
+}
+
+//returns the total size of the bgzf block starting with this header, or 0 if it isn't a bgzf block
+//extra is the FEXTRA field following the fixed header
+size_t bgzfBlockSize(const unsigned char* header, const unsigned char* extra, size_t extraSize)
+{
+	if ((header[3] & 4) == 0) return 0;
+	size_t pos = 0;
+	while (pos + 4 <= extraSize)
+	{
+		size_t subfieldSize = readLittleEndian16(extra + pos + 2);
+		if (extra[pos] == 'B' && extra[pos+1] == 'C' && subfieldSize == 2 && pos + 6 <= extraSize)
+		{
+			return (size_t)readLittleEndian16(extra + pos + 4) + 1;
+		}
+		pos += 4 + subfieldSize;
+	}
+	return 0;
+}
+
+class PlainChunkSource : public InputChunkSource
+{
+public:
+	PlainChunkSource(std::ifstream&& file) :
+	file(std::move(file))
+	{
+	}
+	bool next(std::string& chunk) override
+	{
+		chunk.resize(InputChunkSize);
+		file.read(&chunk[0], InputChunkSize);
+		chunk.resize(file.gcount());
+		return chunk.size() > 0;
+	}
+private:
+	std::ifstream file;
+};
+
+//inflates in a separate thread so decompression overlaps with parsing
+class GzipChunkSource : public InputChunkSource
+{
+public:
+	GzipChunkSource(std::ifstream&& file, const std::string& filename) :
+	file(std::move(file)),
+	filename(filename),
+	chunks(4),
+	buffers(4),
+	error()
+	{
+		inflater = std::thread { [this]() { inflateFile(); } };
+	}
+	~GzipChunkSource()
+	{
+		chunks.close();
+		buffers.close();
+		inflater.join();
+	}
+	bool next(std::string& chunk) override
+	{
+		std::string result;
+		if (!chunks.pop(result))
+		{
+			if (error) std::rethrow_exception(error);
+			return false;
+		}
+		std::swap(chunk, result);
+		buffers.tryPush(result);
+		return true;
+	}
+private:
+	void inflateFile()
+	{
+		z_stream stream;
+		memset(&stream, 0, sizeof(stream));
+		//32 for automatic gzip or zlib header detection
+		if (inflateInit2(&stream, 15 + 32) != Z_OK)
+		{
+			error = std::make_exception_ptr(std::runtime_error { "Could not initialize zlib" });
+			chunks.close();
+			return;
+		}
+		std::string input;
+		input.resize(InputChunkSize);
+		std::string output;
+		size_t outputUsed = 0;
+		try
+		{
+			bool inMember = false;
+			bool consumerDone = false;
+			newOutputBuffer(output, outputUsed);
+			while (true)
+			{
+				if (stream.avail_in == 0)
+				{
+					file.read(&input[0], input.size());
+					stream.next_in = (unsigned char*)&input[0];
+					stream.avail_in = file.gcount();
+					if (stream.avail_in == 0)
+					{
+						if (inMember) throw std::runtime_error { "Truncated gzip file " + filename };
+						break;
+					}
+				}
+				inMember = true;
+				stream.next_out = (unsigned char*)&output[outputUsed];
+				stream.avail_out = output.size() - outputUsed;
+				int result = inflate(&stream, Z_NO_FLUSH);
+				outputUsed = output.size() - stream.avail_out;
+				if (result == Z_STREAM_END)
+				{
+					//concatenated gzip members are read as one stream
+					inflateReset(&stream);
+					inMember = false;
+				}
+				else if (result != Z_OK && result != Z_BUF_ERROR)
+				{
+					throw std::runtime_error { "Corrupted gzip file " + filename };
+				}
+				if (outputUsed == output.size())
+				{
+					if (!chunks.push(output))
+					{
+						consumerDone = true;
+						break;
+					}
+					newOutputBuffer(output, outputUsed);
+				}
+			}
+			if (!consumerDone && outputUsed > 0)
+			{
+				output.resize(outputUsed);
+				chunks.push(output);
+			}
+		}
+		catch (...)
+		{
+			error = std::current_exception();
+		}
+		inflateEnd(&stream);
+		chunks.close();
+	}
+	void newOutputBuffer(std::string& output, size_t& outputUsed)
+	{
+		if (!buffers.tryPop(output)) output.clear();
+		output.resize(InputChunkSize);
+		outputUsed = 0;
+	}
+	std::ifstream file;
+	std::string filename;
+	BlockingQueue<std::string> chunks;
+	BlockingQueue<std::string> buffers;
+	std::exception_ptr error;
+	std::thread inflater;
+};
+
+//bgzf files are a series of independent gzip blocks with their sizes in the headers,
+//so one thread splits the file into blocks and the decompression runs in parallel
+//results are handed out in file order through futures
+class BgzfChunkSource : public InputChunkSource
+{
+	struct Job
+	{
+		std::string compressed;
+		std::vector<size_t> blockStarts;
+		std::promise<std::string> result;
+	};
+public:
+	BgzfChunkSource(std::ifstream&& file, const std::string& filename, size_t decompressionThreads) :
+	file(std::move(file)),
+	filename(filename),
+	jobs(decompressionThreads * 2),
+	results(decompressionThreads * 4),
+	error()
+	{
+		assert(decompressionThreads >= 1);
+		splitter = std::thread { [this]() { splitBlocks(); } };
+		for (size_t i = 0; i < decompressionThreads; i++)
+		{
+			decompressors.emplace_back([this]() { decompressBlocks(); });
+		}
+	}
+	~BgzfChunkSource()
+	{
+		results.close();
+		jobs.close();
+		splitter.join();
+		for (auto& thread : decompressors) thread.join();
+	}
+	bool next(std::string& chunk) override
+	{
+		std::future<std::string> result;
+		if (!results.pop(result))
+		{
+			if (error) std::rethrow_exception(error);
+			return false;
+		}
+		chunk = result.get();
+		return true;
+	}
+private:
+	void splitBlocks()
+	{
+		try
+		{
+			std::unique_ptr<Job> job;
+			unsigned char header[GzipFixedHeaderSize];
+			std::string extra;
+			while (true)
+			{
+				file.read((char*)header, GzipFixedHeaderSize);
+				if (file.gcount() == 0) break;
+				if ((size_t)file.gcount() < GzipFixedHeaderSize || !isGzipHeader(header, GzipFixedHeaderSize)) throw std::runtime_error { "Corrupted bgzf file " + filename };
+				size_t extraSize = readLittleEndian16(header + 10);
+				extra.resize(extraSize);
+				file.read(&extra[0], extraSize);
+				if ((size_t)file.gcount() < extraSize) throw std::runtime_error { "Truncated bgzf file " + filename };
+				size_t blockSize = bgzfBlockSize(header, (const unsigned char*)extra.data(), extraSize);
+				if (blockSize < GzipFixedHeaderSize + extraSize + GzipTrailerSize) throw std::runtime_error { "Corrupted bgzf file " + filename };
+				if (job == nullptr) job = std::make_unique<Job>();
+				size_t blockStart = job->compressed.size();
+				job->blockStarts.push_back(blockStart);
+				job->compressed.append((const char*)header, GzipFixedHeaderSize);
+				job->compressed += extra;
+				size_t rest = blockSize - GzipFixedHeaderSize - extraSize;
+				job->compressed.resize(blockStart + blockSize);
+				file.read(&job->compressed[blockStart + GzipFixedHeaderSize + extraSize], rest);
+				if ((size_t)file.gcount() < rest) throw std::runtime_error { "Truncated bgzf file " + filename };
+				if (job->blockStarts.size() == BgzfBlocksPerJob)
+				{
+					if (!submit(job)) return;
+					job = nullptr;
+				}
+			}
+			if (job != nullptr) submit(job);
+		}
+		catch (...)
+		{
+			error = std::current_exception();
+		}
+		jobs.close();
+		results.close();
+	}
+	bool submit(std::unique_ptr<Job>& job)
+	{
+		//the result slot is reserved first so the number of chunks in flight is bounded by the results queue
+		std::future<std::string> result = job->result.get_future();
+		if (!results.push(result)) return false;
+		return jobs.push(job);
+	}
+	void decompressBlocks()
+	{
+		z_stream stream;
+		memset(&stream, 0, sizeof(stream));
+		bool initialized = inflateInit2(&stream, -15) == Z_OK;
+		std::unique_ptr<Job> job;
+		while (jobs.pop(job))
+		{
+			try
+			{
+				if (!initialized) throw std::runtime_error { "Could not initialize zlib" };
+				job->result.set_value(decompressJob(stream, *job));
+			}
+			catch (...)
+			{
+				job->result.set_exception(std::current_exception());
+			}
+		}
+		if (initialized) inflateEnd(&stream);
+	}
+	std::string decompressJob(z_stream& stream, const Job& job)
+	{
+		std::string result;
+		for (size_t i = 0; i < job.blockStarts.size(); i++)
+		{
+			size_t blockStart = job.blockStarts[i];
+			size_t blockEnd = i+1 < job.blockStarts.size() ? job.blockStarts[i+1] : job.compressed.size();
+			const unsigned char* block = (const unsigned char*)job.compressed.data() + blockStart;
+			size_t dataStart = GzipFixedHeaderSize + readLittleEndian16(block + 10);
+			size_t dataEnd = blockEnd - blockStart - GzipTrailerSize;
+			uint32_t expectedCrc = readLittleEndian32(block + dataEnd);
+			size_t uncompressedSize = readLittleEndian32(block + dataEnd + 4);
+			size_t outputStart = result.size();
+			result.resize(outputStart + uncompressedSize);
+			inflateReset(&stream);
+			stream.next_in = (unsigned char*)block + dataStart;
+			stream.avail_in = dataEnd - dataStart;
+			stream.next_out = (unsigned char*)&result[outputStart];
+			stream.avail_out = uncompressedSize;
+			int status = inflate(&stream, Z_FINISH);
+			if (status != Z_STREAM_END || stream.avail_out != 0) throw std::runtime_error { "Corrupted bgzf file " + filename };
+			if (crc32(0, (const unsigned char*)result.data() + outputStart, uncompressedSize) != expectedCrc) throw std::runtime_error { "Checksum mismatch in bgzf file " + filename };
+		}
+		return result;
+	}
+	std::ifstream file;
+	std::string filename;
+	BlockingQueue<std::unique_ptr<Job>> jobs;
+	BlockingQueue<std::future<std::string>> results;
+	std::exception_ptr error;
+	std::thread splitter;
+	std::vector<std::thread> decompressors;
+};
+
+std::unique_ptr<InputChunkSource> InputChunkSource::Open(const std::string& filename, size_t decompressionThreads)
+{
+	std::ifstream file { filename, std::ios::binary };
+	unsigned char header[GzipFixedHeaderSize];
+	file.read((char*)header, GzipFixedHeaderSize);
+	size_t headerSize = file.gcount();
+	std::string extra;
+	if (headerSize == GzipFixedHeaderSize && isGzipHeader(header, headerSize) && (header[3] & 4))
+	{
+		extra.resize(readLittleEndian16(header + 10));
+		file.read(&extra[0], extra.size());
+		extra.resize(file.gcount());
+	}
+	file.clear();
+	file.seekg(0);
+	if (!isGzipHeader(header, headerSize)) return std::make_unique<PlainChunkSource>(std::move(file));
+	if (decompressionThreads >= 2 && bgzfBlockSize(header, (const unsigned char*)extra.data(), extra.size()) > 0)
+	{
+		return std::make_unique<BgzfChunkSource>(std::move(file), filename, decompressionThreads);
+	}
+	//bgzf is also valid multi-member gzip, so with one thread it is read like any gzip
+	return std::make_unique<GzipChunkSource>(std::move(file), filename);
+}
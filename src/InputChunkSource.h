@@ -0,0 +1,20 @@
+#ifndef InputChunkSource_h
+#define InputChunkSource_h
+
+#include <memory>
+#include <string>
+
+//reads a possibly compressed file as a sequence of decompressed chunks in file order
+//chunks end at arbitrary positions, the consumer has to handle records split over chunks
+class InputChunkSource
+{
+public:
+	virtual ~InputChunkSource() = default;
+	//swaps the next chunk into chunk and takes the old buffer for reuse. returns false at the end of the file
+	virtual bool next(std::string& chunk) = 0;
+	//detects gzip and bgzf from the contents, not the file name
+	//bgzf blocks are decompressed in parallel with decompressionThreads threads, plain gzip is inflated in one thread ahead of the consumer
+	static std::unique_ptr<InputChunkSource> Open(const std::string& filename, size_t decompressionThreads);
+};
+
+#endif
@@ -0,0 +1,82 @@
+#include <immintrin.h>
+#include "KmerHashKernel.h"
+
+namespace KmerHashKernel
+{
+	typedef void(*KernelFunction)(size_t, const uint64_t*, uint64_t*);
+
+	void hashKmersScalar(size_t count, const uint64_t* kmers, uint64_t* hashes)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			hashes[i] = Hash(kmers[i]);
+		}
+	}
+
+	__attribute__((target("avx2")))
+	void hashKmersAVX2(size_t count, const uint64_t* kmers, uint64_t* hashes)
+	{
+		const __m256i ones = _mm256_set1_epi64x(-1);
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m256i key = _mm256_loadu_si256((const __m256i*)(kmers + i));
+			key = _mm256_add_epi64(_mm256_xor_si256(key, ones), _mm256_slli_epi64(key, 21));
+			key = _mm256_xor_si256(key, _mm256_srli_epi64(key, 24));
+			key = _mm256_add_epi64(_mm256_add_epi64(key, _mm256_slli_epi64(key, 3)), _mm256_slli_epi64(key, 8));
+			key = _mm256_xor_si256(key, _mm256_srli_epi64(key, 14));
+			key = _mm256_add_epi64(_mm256_add_epi64(key, _mm256_slli_epi64(key, 2)), _mm256_slli_epi64(key, 4));
+			key = _mm256_xor_si256(key, _mm256_srli_epi64(key, 28));
+			key = _mm256_add_epi64(key, _mm256_slli_epi64(key, 31));
+			_mm256_storeu_si256((__m256i*)(hashes + i), key);
+		}
+		hashKmersScalar(count - i, kmers + i, hashes + i);
+	}
+
+	__attribute__((target("avx512f")))
+	void hashKmersAVX512(size_t count, const uint64_t* kmers, uint64_t* hashes)
+	{
+		//unmasked shift intrinsics trigger -Wmaybe-uninitialized in gcc's headers, use zero-masked shifts instead
+		const __m512i ones = _mm512_set1_epi64(-1);
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m512i key = _mm512_loadu_si512(kmers + i);
+			key = _mm512_add_epi64(_mm512_xor_si512(key, ones), _mm512_maskz_slli_epi64(0xFF, key, 21));
+			key = _mm512_xor_si512(key, _mm512_maskz_srli_epi64(0xFF, key, 24));
+			key = _mm512_add_epi64(_mm512_add_epi64(key, _mm512_maskz_slli_epi64(0xFF, key, 3)), _mm512_maskz_slli_epi64(0xFF, key, 8));
+			key = _mm512_xor_si512(key, _mm512_maskz_srli_epi64(0xFF, key, 14));
+			key = _mm512_add_epi64(_mm512_add_epi64(key, _mm512_maskz_slli_epi64(0xFF, key, 2)), _mm512_maskz_slli_epi64(0xFF, key, 4));
+			key = _mm512_xor_si512(key, _mm512_maskz_srli_epi64(0xFF, key, 28));
+			key = _mm512_add_epi64(key, _mm512_maskz_slli_epi64(0xFF, key, 31));
+			_mm512_storeu_si512(hashes + i, key);
+		}
+		hashKmersAVX2(count - i, kmers + i, hashes + i);
+	}
+
+	struct Implementation
+	{
+		KernelFunction function;
+		const char* name;
+	};
+
+	Implementation pickImplementation()
+	{
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx512f")) return Implementation { hashKmersAVX512, "AVX-512" };
+		if (__builtin_cpu_supports("avx2")) return Implementation { hashKmersAVX2, "AVX2" };
+		return Implementation { hashKmersScalar, "scalar" };
+	}
+
+	const Implementation selected = pickImplementation();
+
+	void HashKmers(size_t count, const uint64_t* kmers, uint64_t* hashes)
+	{
+		selected.function(count, kmers, hashes);
+	}
+
+	const char* SelectedImplementation()
+	{
+		return selected.name;
+	}
+}
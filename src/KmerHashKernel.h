@@ -0,0 +1,28 @@
+#ifndef KmerHashKernel_h
+#define KmerHashKernel_h
+
+#include <cstdint>
+#include <cstddef>
+
+//the hash which orders k-mers for minimizers and syncmers and spreads them to the index buckets
+//HashKmers uses AVX-512 or AVX2 if the CPU supports them, otherwise a scalar loop
+namespace KmerHashKernel
+{
+	// https://naml.us/post/inverse-of-a-hash-function/
+	inline uint64_t Hash(uint64_t key)
+	{
+		key = (~key) + (key << 21); // key = (key << 21) - key - 1;
+		key = key ^ (key >> 24);
+		key = (key + (key << 3)) + (key << 8); // key * 265
+		key = key ^ (key >> 14);
+		key = (key + (key << 2)) + (key << 4); // key * 21
+		key = key ^ (key >> 28);
+		key = key + (key << 31);
+		return key;
+	}
+	//hashes[i] = Hash(kmers[i]) for i < count
+	void HashKmers(size_t count, const uint64_t* kmers, uint64_t* hashes);
+	const char* SelectedImplementation();
+}
+
+#endif
@@ -0,0 +1,259 @@
+#ifndef KmerIterators_h
+#define KmerIterators_h
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "KmerHashKernel.h"
+
+//k-mers of a sequence packed two bits per base, A=0 C=1 G=2 T=3. the iterators call callback(position of the last base, kmer)
+//and skip k-mers with other characters than ACGT
+
+const uint8_t InvalidCharCode = 4;
+
+inline std::array<uint8_t, 256> getCharCodes()
+{
+	std::array<uint8_t, 256> result;
+	result.fill(InvalidCharCode);
+	result['a'] = 0;
+	result['A'] = 0;
+	result['c'] = 1;
+	result['C'] = 1;
+	result['g'] = 2;
+	result['G'] = 2;
+	result['t'] = 3;
+	result['T'] = 3;
+	return result;
+}
+
+inline const std::array<uint8_t, 256> charCode = getCharCodes();
+
+//how many k-mers are hashed at once
+const size_t KmerHashBlockSize = 64;
+
+//calls callback(pos, kmer, hash) for every k-mer and reset() at every invalid character. the k-mers are collected into blocks
+//which are hashed by the vectorized kernel before they are passed on, so a block ends at an invalid character
+template <typename ResetF, typename CallbackF>
+void iterateHashedKmers(const std::string_view& str, size_t kmerLength, ResetF reset, CallbackF callback)
+{
+	assert(kmerLength * 2 <= sizeof(size_t) * 8);
+	const size_t mask = ~(0xFFFFFFFFFFFFFFFF << (kmerLength * 2));
+	std::array<uint64_t, KmerHashBlockSize> kmers;
+	std::array<uint64_t, KmerHashBlockSize> hashes;
+	size_t blockStart = 0;
+	size_t blockSize = 0;
+	auto flush = [&kmers, &hashes, &blockStart, &blockSize, &callback]()
+	{
+		KmerHashKernel::HashKmers(blockSize, kmers.data(), hashes.data());
+		for (size_t i = 0; i < blockSize; i++)
+		{
+			callback(blockStart + i, kmers[i], hashes[i]);
+		}
+		blockSize = 0;
+	};
+	size_t kmer = 0;
+	size_t validLength = 0;
+	for (size_t i = 0; i < str.size(); i++)
+	{
+		uint8_t code = charCode[(unsigned char)str[i]];
+		if (code == InvalidCharCode)
+		{
+			if (blockSize > 0) flush();
+			validLength = 0;
+			reset();
+			continue;
+		}
+		kmer = ((kmer << 2) | code) & mask;
+		validLength += 1;
+		if (validLength < kmerLength) continue;
+		if (blockSize == 0) blockStart = i;
+		kmers[blockSize] = kmer;
+		blockSize += 1;
+		if (blockSize == KmerHashBlockSize) flush();
+	}
+	if (blockSize > 0) flush();
+}
+
+//monotone queue of the k-mers which can still be the smallest of a window, in a ring buffer of a fixed size. hashes are nondecreasing from front to back
+class MinimumWindow
+{
+public:
+	struct Item
+	{
+		size_t pos;
+		size_t kmer;
+		uint64_t hash;
+	};
+	MinimumWindow(size_t maxSize) :
+	items(),
+	mask(0),
+	frontIndex(0),
+	backIndex(0)
+	{
+		size_t capacity = 1;
+		while (capacity < maxSize) capacity *= 2;
+		items.resize(capacity);
+		mask = capacity - 1;
+	}
+	void clear()
+	{
+		frontIndex = 0;
+		backIndex = 0;
+	}
+	size_t size() const
+	{
+		return backIndex - frontIndex;
+	}
+	const Item& operator[](size_t index) const
+	{
+		return items[(frontIndex + index) & mask];
+	}
+	const Item& front() const
+	{
+		return items[frontIndex & mask];
+	}
+	const Item& back() const
+	{
+		return items[(backIndex - 1) & mask];
+	}
+	void popFront()
+	{
+		frontIndex += 1;
+	}
+	//removes the k-mers with a bigger hash which can't be the smallest anymore
+	void push(size_t pos, size_t kmer, uint64_t hash)
+	{
+		while (backIndex > frontIndex && items[(backIndex - 1) & mask].hash > hash) backIndex -= 1;
+		assert(backIndex - frontIndex <= mask);
+		items[backIndex & mask] = Item { pos, kmer, hash };
+		backIndex += 1;
+	}
+private:
+	std::vector<Item> items;
+	size_t mask;
+	size_t frontIndex;
+	size_t backIndex;
+};
+
+//every k-mer of the string, but a k-mer repeated in low complexity sequence only once per window
+template <typename CallbackF>
+void iterateKmers(const std::string_view& str, size_t kmerLength, size_t windowSize, CallbackF callback)
+{
+	const size_t realWindow = windowSize - kmerLength + 1;
+	assert(kmerLength * 2 <= sizeof(size_t) * 8);
+	const size_t mask = ~(0xFFFFFFFFFFFFFFFF << (kmerLength * 2));
+	size_t kmer = 0;
+	size_t validLength = 0;
+	size_t lastKmer = 0;
+	size_t lastPos = 0;
+	for (size_t i = 0; i < str.size(); i++)
+	{
+		uint8_t code = charCode[(unsigned char)str[i]];
+		if (code == InvalidCharCode)
+		{
+			validLength = 0;
+			continue;
+		}
+		kmer = ((kmer << 2) | code) & mask;
+		validLength += 1;
+		if (validLength < kmerLength) continue;
+		if (validLength == kmerLength || lastKmer != kmer || lastPos <= i - realWindow)
+		{
+			callback(i, kmer);
+			lastKmer = kmer;
+			lastPos = i;
+		}
+	}
+}
+
+//window minimizers. the first window of a stretch without invalid characters is one k-mer longer than the rest
+template <typename CallbackF>
+void iterateMinimizersReal(const std::string_view& str, size_t minimizerLength, size_t windowSize, CallbackF callback)
+{
+	assert(minimizerLength * 2 <= sizeof(size_t) * 8);
+	assert(minimizerLength <= windowSize);
+	const size_t realWindow = windowSize - minimizerLength + 1;
+	MinimumWindow window { realWindow + 1 };
+	size_t kmersInRun = 0;
+	auto callMinimums = [&window, &callback]()
+	{
+		for (size_t i = 0; i < window.size() && window[i].hash == window.front().hash; i++)
+		{
+			callback(window[i].pos, window[i].kmer);
+		}
+	};
+	iterateHashedKmers(str, minimizerLength, [&window, &kmersInRun]()
+	{
+		window.clear();
+		kmersInRun = 0;
+	}, [&window, &kmersInRun, &callMinimums, &callback, realWindow](size_t pos, size_t kmer, uint64_t hashed)
+	{
+		kmersInRun += 1;
+		if (kmersInRun <= realWindow + 1)
+		{
+			window.push(pos, kmer, hashed);
+			if (kmersInRun == realWindow + 1) callMinimums();
+			return;
+		}
+		uint64_t oldMinimum = window.front().hash;
+		bool frontPopped = false;
+		while (window.size() > 0 && window.front().pos <= pos - realWindow)
+		{
+			frontPopped = true;
+			window.popFront();
+		}
+		if (frontPopped)
+		{
+			while (window.size() >= 2 && window[0].hash == window[1].hash) window.popFront();
+		}
+		window.push(pos, kmer, hashed);
+		if (window.front().hash != oldMinimum)
+		{
+			callMinimums();
+		}
+		else if (window.back().hash == window.front().hash)
+		{
+			callback(window.back().pos, window.back().kmer);
+		}
+	});
+}
+
+//closed syncmers, k-mers whose smallest s-mer is the first or the last one. whether a k-mer is picked doesn't depend
+//on the sequence around it, so an indel next to a k-mer doesn't change whether it's picked in the read and the graph
+template <typename CallbackF>
+void iterateSyncmers(const std::string_view& str, size_t kmerLength, size_t smerLength, CallbackF callback)
+{
+	assert(kmerLength * 2 <= sizeof(size_t) * 8);
+	assert(smerLength > 0);
+	assert(smerLength < kmerLength);
+	const size_t kmerMask = ~(0xFFFFFFFFFFFFFFFF << (kmerLength * 2));
+	const size_t smersPerKmer = kmerLength - smerLength + 1;
+	//hashes of the s-mers of the current k-mer by end position modulo smersPerKmer
+	std::vector<uint64_t> smerHashes;
+	smerHashes.resize(smersPerKmer, 0);
+	//the s-mers which can still be the smallest
+	MinimumWindow window { smersPerKmer + 1 };
+	size_t kmer = 0;
+	size_t smersInRun = 0;
+	iterateHashedKmers(str, smerLength, [&window, &smersInRun]()
+	{
+		window.clear();
+		smersInRun = 0;
+	}, [&window, &smerHashes, &kmer, &smersInRun, &callback, smersPerKmer, kmerMask](size_t i, size_t smer, uint64_t hashed)
+	{
+		//the first s-mer has the first bases of the k-mer, after that each s-mer adds one base
+		kmer = (smersInRun == 0) ? smer : (((kmer << 2) | (smer & 3)) & kmerMask);
+		smersInRun += 1;
+		smerHashes[i % smersPerKmer] = hashed;
+		window.push(i, 0, hashed);
+		if (smersInRun < smersPerKmer) return;
+		while (window.front().pos + smersPerKmer <= i) window.popFront();
+		uint64_t minimum = window.front().hash;
+		//the first s-mer of the k-mer ends at i - smersPerKmer + 1
+		if (hashed == minimum || smerHashes[(i + 1) % smersPerKmer] == minimum) callback(i, kmer);
+	});
+}
+
+#endif
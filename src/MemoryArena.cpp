@@ -0,0 +1,58 @@
+#include <algorithm>
+#include "MemoryArena.h"
+
+//size of the first chunk, later ones double up to the max
+const size_t MinArenaChunkSize = 1024 * 1024;
+const size_t MaxArenaChunkSize = 64 * 1024 * 1024;
+//chunks beyond this are freed on reset so one huge alignment doesn't keep its memory for the rest of the run
+const size_t MaxRetainedArenaBytes = 256 * 1024 * 1024;
+
+MemoryArena::MemoryArena() :
+chunks(),
+currentChunk(0),
+used(0),
+allocatedBytes(0)
+{
+}
+
+void MemoryArena::reset()
+{
+	size_t retained = 0;
+	size_t keep = 0;
+	while (keep < chunks.size() && retained + chunks[keep].size <= MaxRetainedArenaBytes)
+	{
+		retained += chunks[keep].size;
+		keep++;
+	}
+	if (keep < chunks.size()) chunks.resize(keep);
+	currentChunk = 0;
+	used = 0;
+}
+
+size_t MemoryArena::takeAllocatedBytes()
+{
+	size_t result = allocatedBytes;
+	allocatedBytes = 0;
+	return result;
+}
+
+void* MemoryArena::allocateSlow(size_t bytes, size_t alignment)
+{
+	//the rest of the current chunk is wasted until the next reset
+	if (currentChunk < chunks.size()) currentChunk++;
+	used = 0;
+	size_t needed = bytes + alignment;
+	while (currentChunk < chunks.size() && chunks[currentChunk].size < needed) currentChunk++;
+	if (currentChunk == chunks.size())
+	{
+		size_t size = MinArenaChunkSize;
+		if (chunks.size() > 0) size = std::min(MaxArenaChunkSize, chunks.back().size * 2);
+		size = std::max(size, needed);
+		chunks.push_back(Chunk { std::unique_ptr<char[]> { new char[size] }, size });
+	}
+	uintptr_t start = (uintptr_t)chunks[currentChunk].data.get();
+	uintptr_t aligned = (start + alignment - 1) & ~(uintptr_t)(alignment - 1);
+	used = (aligned - start) + bytes;
+	assert(used <= chunks[currentChunk].size);
+	return (void*)aligned;
+}
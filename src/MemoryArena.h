@@ -0,0 +1,96 @@
+#ifndef MemoryArena_h
+#define MemoryArena_h
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+//bump allocator for the DP tables of an alignment. deallocation does nothing and reset rewinds to the start,
+//so the tables are freed at once instead of one map per slice. chunks are kept for the next alignment
+class MemoryArena
+{
+	struct Chunk
+	{
+		std::unique_ptr<char[]> data;
+		size_t size;
+	};
+public:
+	MemoryArena();
+	MemoryArena(const MemoryArena& other) = delete;
+	MemoryArena& operator=(const MemoryArena& other) = delete;
+	void* allocate(size_t bytes, size_t alignment)
+	{
+		allocatedBytes += bytes;
+		if (currentChunk < chunks.size())
+		{
+			uintptr_t start = (uintptr_t)(chunks[currentChunk].data.get() + used);
+			uintptr_t aligned = (start + alignment - 1) & ~(uintptr_t)(alignment - 1);
+			if (aligned + bytes <= (uintptr_t)(chunks[currentChunk].data.get() + chunks[currentChunk].size))
+			{
+				used += (aligned - start) + bytes;
+				return (void*)aligned;
+			}
+		}
+		return allocateSlow(bytes, alignment);
+	}
+	//everything allocated from the arena must be dead
+	void reset();
+	//bytes requested since the previous call
+	size_t takeAllocatedBytes();
+private:
+	void* allocateSlow(size_t bytes, size_t alignment);
+	std::vector<Chunk> chunks;
+	size_t currentChunk;
+	size_t used;
+	size_t allocatedBytes;
+};
+
+//falls back to the heap without an arena
+template <typename T>
+class ArenaAllocator
+{
+public:
+	using value_type = T;
+	using propagate_on_container_copy_assignment = std::true_type;
+	using propagate_on_container_move_assignment = std::true_type;
+	using propagate_on_container_swap = std::true_type;
+	ArenaAllocator() :
+	arena(nullptr)
+	{
+	}
+	ArenaAllocator(MemoryArena* arena) :
+	arena(arena)
+	{
+	}
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other) :
+	arena(other.arena)
+	{
+	}
+	T* allocate(size_t n)
+	{
+		if (arena == nullptr) return std::allocator<T>{}.allocate(n);
+		return (T*)arena->allocate(n * sizeof(T), alignof(T));
+	}
+	void deallocate(T* ptr, size_t n)
+	{
+		if (arena == nullptr) std::allocator<T>{}.deallocate(ptr, n);
+	}
+	template <typename U>
+	bool operator==(const ArenaAllocator<U>& other) const
+	{
+		return arena == other.arena;
+	}
+	template <typename U>
+	bool operator!=(const ArenaAllocator<U>& other) const
+	{
+		return arena != other.arena;
+	}
+	MemoryArena* arena;
+};
+
+#endif
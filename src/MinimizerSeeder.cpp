@@ -1,10 +1,16 @@
+#include <array>
 #include <queue>
 #include <thread>
 #include <cmath>
+#include <fstream>
+#include <cstdio>
+#include <cerrno>
 #include <concurrentqueue.h>
 #include "CommonUtils.h"
 #include "MinimizerSeeder.h"
+#include "KmerIterators.h"
 
+//the k-mer iterators use the table in KmerIterators.h, these are for FusionFinder and the reference minimizers below
 size_t charToInt(char c)
 {
 	switch(c)
@@ -41,153 +47,9 @@ std::vector<bool> getValidChars()
 	return result;
 }
 
-// https://naml.us/post/inverse-of-a-hash-function/
-uint64_t hash(uint64_t key) {
-	key = (~key) + (key << 21); // key = (key << 21) - key - 1;
-	key = key ^ (key >> 24);
-	key = (key + (key << 3)) + (key << 8); // key * 265
-	key = key ^ (key >> 14);
-	key = (key + (key << 2)) + (key << 4); // key * 21
-	key = key ^ (key >> 28);
-	key = key + (key << 31);
-	return key;
-}
-
 std::vector<bool> validChar = getValidChars();
 
 
-template <typename CallbackF>
-void iterateKmers(const std::string& str, size_t kmerLength, size_t windowSize, CallbackF callback)
-{
-	const size_t realWindow = windowSize - kmerLength + 1;
-	assert(kmerLength * 2 <= sizeof(size_t) * 8);
-	if (str.size() < kmerLength) return;
-	const size_t mask = ~(0xFFFFFFFFFFFFFFFF << (kmerLength * 2));
-	assert(mask == pow(4, kmerLength)-1);
-	size_t offset = 0;
-start:
-	while (offset < str.size() && !validChar[str[offset]]) offset++;
-	if (offset + kmerLength > str.size()) return;
-	size_t kmer = 0;
-	for (size_t i = 0; i < kmerLength; i++)
-	{
-		if (!validChar[str[offset+i]])
-		{
-			offset += i;
-			goto start;
-		}
-		kmer <<= 2;
-		kmer |= charToInt(str[offset+i]);
-	}
-	callback(offset + kmerLength-1, kmer);
-	size_t lastKmer = kmer;
-	size_t lastPos = offset + kmerLength-1;
-	for (size_t i = kmerLength; offset+i < str.size(); i++)
-	{
-		if (!validChar[str[offset+i]])
-		{
-			offset += i;
-			goto start;
-		}
-		kmer <<= 2;
-		kmer &= mask;
-		kmer |= charToInt(str[offset + i]);
-		if (lastKmer != kmer || lastPos <= offset + i - realWindow)
-		{
-			callback(offset + i, kmer);
-			lastKmer = kmer;
-			lastPos = offset + i;
-		}
-	}
-}
-
-template <typename CallbackF>
-void iterateMinimizersReal(const std::string& str, size_t minimizerLength, size_t windowSize, CallbackF callback)
-{
-	assert(minimizerLength * 2 <= sizeof(size_t) * 8);
-	assert(minimizerLength <= windowSize);
-	if (str.size() < minimizerLength) return;
-	const size_t realWindow = windowSize - minimizerLength + 1;
-	const size_t mask = ~(0xFFFFFFFFFFFFFFFF << (minimizerLength * 2));
-	assert(mask == pow(4, minimizerLength)-1);
-	size_t offset = 0;
-	std::deque<std::tuple<size_t, size_t, size_t>> window;
-start:
-	while (offset < str.size() && !validChar[str[offset]]) offset++;
-	if (offset + windowSize > str.size()) return;
-	size_t kmer = 0;
-	for (size_t i = 0; i < minimizerLength; i++)
-	{
-		if (!validChar[str[offset+i]])
-		{
-			offset += i;
-			goto start;
-		}
-		kmer <<= 2;
-		kmer |= charToInt(str[offset+i]);
-	}
-	window.clear();
-	window.emplace_back(offset+minimizerLength-1, kmer, hash(kmer));
-	for (size_t i = minimizerLength; i < minimizerLength + realWindow; i++)
-	{
-		if (!validChar[str[offset + i]])
-		{
-			offset += i;
-			goto start;
-		}
-		kmer <<= 2;
-		kmer &= mask;
-		kmer |= charToInt(str[offset + i]);
-		auto hashed = hash(kmer);
-		while (!window.empty() && std::get<2>(window.back()) > hashed) window.pop_back();
-		window.emplace_back(offset+i, kmer, hashed);
-	}
-	auto iter = window.begin();
-	while (iter != window.end() && std::get<2>(*iter) == std::get<2>(window.front()))
-	{
-		callback(std::get<0>(*iter), std::get<1>(*iter));
-		++iter;
-	}
-	for (size_t i = minimizerLength + realWindow; offset+i < str.size(); i++)
-	{
-		if (!validChar[str[offset+i]])
-		{
-			offset += i;
-			goto start;
-		}
-		kmer <<= 2;
-		kmer &= mask;
-		kmer |= charToInt(str[offset + i]);
-		auto hashed = hash(kmer);
-		size_t oldMinimum = std::get<2>(window.front());
-		bool frontPopped = false;
-		while (!window.empty() && std::get<0>(window.front()) <= offset + i - realWindow)
-		{
-			frontPopped = true;
-			window.pop_front();
-		}
-		if (frontPopped)
-		{
-			while (window.size() >= 2 && std::get<2>(window.front()) == std::get<2>(*(window.begin()+1))) window.pop_front();
-		}
-		while (!window.empty() && std::get<2>(window.back()) > hashed) window.pop_back();
-		window.emplace_back(offset+i, kmer, hashed);
-		if (std::get<2>(window.front()) != oldMinimum)
-		{
-			auto iter = window.begin();
-			while (iter != window.end() && std::get<2>(*iter) == std::get<2>(window.front()))
-			{
-				callback(std::get<0>(*iter), std::get<1>(*iter));
-				++iter;
-			}
-		}
-		else if (std::get<2>(window.back()) == std::get<2>(window.front()))
-		{
-			callback(std::get<0>(window.back()), std::get<1>(window.back()));
-		}
-	}
-}
-
 #ifndef EXTRACORRECTNESSASSERTIONS
 
 template <typename CallbackF>
@@ -212,7 +74,7 @@ void iterateMinimizersSimple(const std::string& str, size_t minimizerLength, siz
 				kmer <<= 2;
 				kmer |= charToInt(str[j]);
 			}
-			windowMinimum = std::min(windowMinimum, hash(kmer));
+			windowMinimum = std::min(windowMinimum, KmerHashKernel::Hash(kmer));
 		}
 		for (size_t i = minimizerLength-1; i < str.size(); i++)
 		{
@@ -222,7 +84,7 @@ void iterateMinimizersSimple(const std::string& str, size_t minimizerLength, siz
 				kmer <<= 2;
 				kmer |= charToInt(str[j]);
 			}
-			if (hash(kmer) == windowMinimum) callback(i, kmer);
+			if (KmerHashKernel::Hash(kmer) == windowMinimum) callback(i, kmer);
 		}
 		return;
 	}
@@ -240,7 +102,7 @@ void iterateMinimizersSimple(const std::string& str, size_t minimizerLength, siz
 			kmer[i] <<= 2;
 			kmer[i] |= charToInt(str[j]);
 		}
-		kmerHash[i] = hash(kmer[i]);
+		kmerHash[i] = KmerHashKernel::Hash(kmer[i]);
 	}
 	for (size_t i = windowSize-1; i < str.size(); i++)
 	{
@@ -283,21 +145,234 @@ void iterateMinimizers(const std::string& str, size_t minimizerLength, size_t wi
 
 #endif
 
-MinimizerSeeder::MinimizerSeeder(const AlignmentGraph& graph, size_t minimizerLength, size_t windowSize, size_t numThreads, double keepLeastFrequentFraction) :
+//how many k-mers getSeeds looks up before checking them in the index
+const size_t LookupBatchSize = 16;
+
+//in tangled parts of the graph the number of paths into a node start grows exponentially with the window size, so stop after this many
+const size_t MaxNodeStartWalks = 256;
+
+//sampled k-mers of the paths which enter the split node from another node, calls callback(split node, offset, kmer) with the position of
+//the last base of the k-mer. the paths reach windowSize-1 bases (minimizerLength-1 for syncmers) into the in-neighbors and into the node,
+//so every window which crosses the start of the node is on one of them. k-mers may be reported more than once
+template <typename CallbackF>
+void MinimizerSeeder::iterateNodeStartKmers(size_t node, CallbackF callback) const
+{
+	const size_t contextLength = (syncmerLength > 0 ? minimizerLength : windowSize) - 1;
+	//the rest of the original node doesn't branch
+	std::string forward;
+	std::vector<std::pair<size_t, size_t>> forwardPositions;
+	int nodeId = graph.nodeIDs[node];
+	size_t originalNodeSize = graph.originalNodeSize.at(nodeId);
+	for (size_t pos = graph.nodeOffset[node]; pos < originalNodeSize && forward.size() < contextLength;)
+	{
+		size_t splitNode = graph.GetUnitigNode(nodeId, pos);
+		for (size_t offset = pos - graph.nodeOffset[splitNode]; offset < graph.NodeLength(splitNode) && forward.size() < contextLength; offset++)
+		{
+			forward.push_back(graph.NodeSequences(splitNode, offset));
+			forwardPositions.emplace_back(splitNode, offset);
+		}
+		pos = graph.nodeOffset[splitNode] + graph.NodeLength(splitNode);
+	}
+	//the path backwards from the node start, last base first
+	std::string backward;
+	std::vector<std::pair<size_t, size_t>> backwardPositions;
+	std::string sequence;
+	std::vector<std::pair<size_t, size_t>> positions;
+	//depth first over the in-neighbors, with the length of the path before the node
+	std::vector<std::pair<size_t, size_t>> stack;
+	for (auto neighbor : graph.inNeighbors[node]) stack.emplace_back(neighbor, 0);
+	size_t walks = 0;
+	while (stack.size() > 0 && walks < MaxNodeStartWalks)
+	{
+		size_t current = stack.back().first;
+		backward.resize(stack.back().second);
+		backwardPositions.resize(stack.back().second);
+		stack.pop_back();
+		for (size_t offset = graph.NodeLength(current); offset > 0 && backward.size() < contextLength; offset--)
+		{
+			backward.push_back(graph.NodeSequences(current, offset-1));
+			backwardPositions.emplace_back(current, offset-1);
+		}
+		if (backward.size() < contextLength && graph.inNeighbors[current].size() > 0)
+		{
+			for (auto neighbor : graph.inNeighbors[current]) stack.emplace_back(neighbor, backward.size());
+			continue;
+		}
+		walks += 1;
+		sequence.assign(backward.rbegin(), backward.rend());
+		sequence += forward;
+		positions.assign(backwardPositions.rbegin(), backwardPositions.rend());
+		positions.insert(positions.end(), forwardPositions.begin(), forwardPositions.end());
+		auto report = [&positions, &callback](size_t pos, size_t kmer)
+		{
+			callback(positions[pos].first, positions[pos].second, kmer);
+		};
+		if (syncmerLength > 0)
+		{
+			iterateSyncmers(sequence, minimizerLength, syncmerLength, report);
+		}
+		else
+		{
+			iterateMinimizers(sequence, minimizerLength, windowSize, report);
+		}
+	}
+}
+
+MinimizerSeeder::MinimizerSeeder(const AlignmentGraph& graph, size_t minimizerLength, size_t windowSize, size_t syncmerLength, size_t numThreads, size_t numBuckets, double keepLeastFrequentFraction, const std::string& indexFile) :
 graph(graph),
 buckets(),
 minimizerLength(minimizerLength),
 windowSize(windowSize),
+syncmerLength(syncmerLength),
 maxCount(0)
 {
 	assert(minimizerLength * 2 <= sizeof(size_t) * 8);
-	assert(minimizerLength <= windowSize);
-	initMinimizers(numThreads);
+	assert(syncmerLength > 0 || minimizerLength <= windowSize);
+	assert(syncmerLength < minimizerLength);
+	if (indexFile.size() > 0 && loadFrom(indexFile, keepLeastFrequentFraction)) return;
+	initMinimizers(numThreads, numBuckets);
 	initMaxCount(keepLeastFrequentFraction);
+	if (indexFile.size() > 0) saveTo(indexFile, keepLeastFrequentFraction);
+}
+
+const uint64_t MinimizerIndexMagic = 0x47414D494E494458;
+// increment when the layout of the index file changes
+const uint64_t MinimizerIndexVersion = 4;
+
+template <typename T>
+void writeValue(std::ostream& file, T value)
+{
+	file.write((const char*)&value, sizeof(T));
 }
 
-void MinimizerSeeder::initMinimizers(size_t numThreads)
+template <typename T>
+T readValue(std::istream& file)
 {
+	T result {};
+	file.read((char*)&result, sizeof(T));
+	return result;
+}
+
+uint64_t MinimizerSeeder::graphChecksum() const
+{
+	// positions refer to split node indices so the index is only valid for the exact same split graph
+	uint64_t result = KmerHashKernel::Hash(graph.NodeSize());
+	auto add = [&result](uint64_t value) { result = KmerHashKernel::Hash(result ^ value); };
+	for (size_t i = 0; i < graph.NodeSize(); i++)
+	{
+		add(graph.nodeIDs[i]);
+		add(graph.nodeOffset[i]);
+		add(graph.NodeLength(i));
+		add(graph.outNeighbors[i].size());
+		for (auto neighbor : graph.outNeighbors[i]) add(neighbor);
+		for (size_t j = 0; j < graph.NodeLength(i); j++) add(graph.NodeSequences(i, j));
+	}
+	return result;
+}
+
+void MinimizerSeeder::saveTo(const std::string& indexFile, double keepLeastFrequentFraction) const
+{
+	// concurrent jobs may share the index file, so write it elsewhere and move it into place once complete
+	std::string tempFile = CommonUtils::TemporaryFileName(indexFile);
+	std::ofstream file { tempFile, std::ios::binary };
+	if (!file.good())
+	{
+		std::cerr << "Warning: could not write minimizer index to " << tempFile << std::endl;
+		return;
+	}
+	writeValue<uint64_t>(file, MinimizerIndexMagic);
+	writeValue<uint64_t>(file, MinimizerIndexVersion);
+	writeValue<uint64_t>(file, minimizerLength);
+	writeValue<uint64_t>(file, windowSize);
+	writeValue<uint64_t>(file, syncmerLength);
+	writeValue<uint64_t>(file, graphChecksum());
+	writeValue<double>(file, keepLeastFrequentFraction);
+	writeValue<uint64_t>(file, maxCount);
+	writeValue<uint64_t>(file, buckets.size());
+	for (size_t i = 0; i < buckets.size(); i++)
+	{
+		buckets[i].locator->save(file);
+		buckets[i].kmerCheck.serialize(file);
+		buckets[i].startPos.serialize(file);
+		buckets[i].positions.serialize(file);
+	}
+	file.close();
+	if (file.fail())
+	{
+		std::cerr << "Warning: could not write minimizer index to " << tempFile << std::endl;
+		std::remove(tempFile.c_str());
+		return;
+	}
+	if (std::rename(tempFile.c_str(), indexFile.c_str()) != 0)
+	{
+		std::cerr << "Warning: could not move minimizer index from " << tempFile << " to " << indexFile << std::endl;
+		std::remove(tempFile.c_str());
+	}
+}
+
+bool MinimizerSeeder::loadFrom(const std::string& indexFile, double keepLeastFrequentFraction)
+{
+	std::ifstream file { indexFile, std::ios::binary };
+	if (!file.good())
+	{
+		// a missing file is the normal first run, anything else is worth mentioning
+		if (errno != ENOENT) std::cerr << "Warning: could not open minimizer index " << indexFile << ", rebuilding it" << std::endl;
+		return false;
+	}
+	uint64_t magic = readValue<uint64_t>(file);
+	uint64_t version = readValue<uint64_t>(file);
+	if (!file.good() || magic != MinimizerIndexMagic || version != MinimizerIndexVersion)
+	{
+		std::cerr << "Warning: " << indexFile << " is not a compatible minimizer index, rebuilding it" << std::endl;
+		return false;
+	}
+	uint64_t fileMinimizerLength = readValue<uint64_t>(file);
+	uint64_t fileWindowSize = readValue<uint64_t>(file);
+	uint64_t fileSyncmerLength = readValue<uint64_t>(file);
+	uint64_t fileChecksum = readValue<uint64_t>(file);
+	double fileKeepFraction = readValue<double>(file);
+	uint64_t fileMaxCount = readValue<uint64_t>(file);
+	uint64_t numBuckets = readValue<uint64_t>(file);
+	if (!file.good() || numBuckets == 0 || (numBuckets & (numBuckets - 1)) != 0)
+	{
+		std::cerr << "Warning: " << indexFile << " is not a compatible minimizer index, rebuilding it" << std::endl;
+		return false;
+	}
+	if (fileMinimizerLength != minimizerLength || fileWindowSize != windowSize || fileSyncmerLength != syncmerLength)
+	{
+		std::cerr << "Warning: minimizer index " << indexFile << " was built with different minimizer length, window size or syncmer length, rebuilding it" << std::endl;
+		return false;
+	}
+	if (fileChecksum != graphChecksum())
+	{
+		std::cerr << "Warning: minimizer index " << indexFile << " was built from a different graph, rebuilding it" << std::endl;
+		return false;
+	}
+	buckets.resize(numBuckets);
+	for (size_t i = 0; i < numBuckets; i++)
+	{
+		buckets[i].locator = new KmerBucket::boophf_t;
+		buckets[i].locator->load(file);
+		buckets[i].kmerCheck.load(file);
+		buckets[i].startPos.load(file);
+		buckets[i].positions.load(file);
+	}
+	if (!file.good())
+	{
+		std::cerr << "Warning: minimizer index " << indexFile << " is truncated, rebuilding it" << std::endl;
+		buckets.clear();
+		return false;
+	}
+	maxCount = fileMaxCount;
+	// the frequency cutoff is cheap to recompute so the index can be reused with a different --seeds-minimizer-ignore-frequent
+	if (fileKeepFraction != keepLeastFrequentFraction) initMaxCount(keepLeastFrequentFraction);
+	return true;
+}
+
+void MinimizerSeeder::initMinimizers(size_t numThreads, size_t numBuckets)
+{
+	assert(numBuckets > 0);
+	assert((numBuckets & (numBuckets - 1)) == 0);
 	size_t positionSize = log2(graph.nodeIDs.size()) + 1;
 	assert(positionSize + 6 < 64);
 	assert(minimizerLength * 2 < 64);
@@ -306,21 +381,26 @@ void MinimizerSeeder::initMinimizers(size_t numThreads)
 	std::vector<std::thread> threads;
 	std::vector<sdsl::int_vector<0>> kmerPerBucket;
 	std::vector<sdsl::int_vector<0>> positionPerBucket;
+	std::vector<size_t> vecPosPerBucket;
+	std::vector<std::mutex> bucketMutex(numBuckets);
 	std::vector<moodycamel::ConcurrentQueue<std::pair<uint64_t, uint64_t>>> positionDistributor;
-	kmerPerBucket.resize(numThreads);
-	positionPerBucket.resize(numThreads);
-	positionDistributor.resize(numThreads);
-	buckets.resize(numThreads);
-	std::atomic<size_t> threadsDone;
-	threadsDone = 0;
-	for (size_t i = 0; i < numThreads; i++)
+	kmerPerBucket.resize(numBuckets);
+	positionPerBucket.resize(numBuckets);
+	vecPosPerBucket.resize(numBuckets, 0);
+	positionDistributor.resize(numBuckets);
+	buckets.resize(numBuckets);
+	for (size_t i = 0; i < numBuckets; i++)
 	{
 		kmerPerBucket[i].width(minimizerLength * 2);
+		kmerPerBucket[i].resize(10);
 		positionPerBucket[i].width(positionSize + 6);
+		positionPerBucket[i].resize(10);
 		buckets[i].positions.width(positionSize + 6);
 	}
 
 	std::unordered_map<size_t, size_t> nodeMinimizerStart;
+	// split nodes entered from other nodes, the k-mers crossing into them aren't in either node's sequence
+	std::vector<size_t> nodeStarts;
 	for (size_t i = 0; i < graph.NodeSize(); i++)
 	{
 		nodeMinimizerStart[graph.nodeIDs[i]] = std::max(nodeMinimizerStart[graph.nodeIDs[i]], (size_t)0);
@@ -336,16 +416,66 @@ void MinimizerSeeder::initMinimizers(size_t numThreads)
 		if (skipStart)
 		{
 			nodeMinimizerStart[graph.nodeIDs[i]] = std::max(nodeMinimizerStart[graph.nodeIDs[i]], graph.nodeOffset[i]);
+			nodeStarts.push_back(i);
 		}
 	}
+	std::atomic<size_t> nextNodeStart;
+	nextNodeStart = 0;
+
+	// caller must hold bucketMutex[bucket]
+	auto drainBucket = [this, &positionDistributor, &kmerPerBucket, &positionPerBucket, &vecPosPerBucket](size_t bucket)
+	{
+		std::pair<uint64_t, uint64_t> readThis;
+		size_t& vecPos = vecPosPerBucket[bucket];
+		while (positionDistributor[bucket].try_dequeue(readThis))
+		{
+			assert(readThis.first < ((uint64_t)1) << (kmerPerBucket[bucket].width()));
+			assert(readThis.second < ((uint64_t)1) << (positionPerBucket[bucket].width()));
+			assert(getBucket(readThis.first) == bucket);
+			if (vecPos == kmerPerBucket[bucket].size())
+			{
+				kmerPerBucket[bucket].resize(kmerPerBucket[bucket].size() * 2);
+				positionPerBucket[bucket].resize(kmerPerBucket[bucket].size());
+			}
+			kmerPerBucket[bucket][vecPos] = readThis.first;
+			positionPerBucket[bucket][vecPos] = readThis.second;
+			vecPos += 1;
+		}
+	};
 
+	// first collect the minimizers of all nodes and then the minimizers crossing into the node starts into the buckets
+	// whichever thread happens to be free packs the queued minimizers into the bucket vectors so the queues stay short
 	for (size_t thread = 0; thread < numThreads; thread++)
 	{
-		threads.emplace_back([this, &nodeMinimizerStart, &positionDistributor, &threadsDone, &kmerPerBucket, &positionPerBucket, thread, numThreads, &nodeMutex, &nodeIter, positionSize](){
-			size_t vecPos = 0;
-			kmerPerBucket[thread].resize(10);
-			positionPerBucket[thread].resize(10);
-			std::pair<uint64_t, uint64_t> readThis;
+		threads.emplace_back([this, &nodeMinimizerStart, &nodeStarts, &nextNodeStart, &positionDistributor, &bucketMutex, &drainBucket, thread, numBuckets, &nodeMutex, &nodeIter, positionSize](){
+			const size_t drainInterval = 256;
+			size_t sinceDrain = 0;
+			size_t drainNext = thread % numBuckets;
+			auto tryDrainNext = [&bucketMutex, &drainBucket, &drainNext, numBuckets]()
+			{
+				std::unique_lock<std::mutex> lock { bucketMutex[drainNext], std::try_to_lock };
+				if (lock.owns_lock()) drainBucket(drainNext);
+				drainNext = (drainNext + 1) & (numBuckets - 1);
+			};
+			auto addPosition = [this, &nodeMinimizerStart, &positionDistributor, &sinceDrain, &tryDrainNext, drainInterval, positionSize](size_t splitNode, size_t remainingOffset, size_t kmer)
+			{
+				if (graph.nodeOffset[splitNode] + remainingOffset < nodeMinimizerStart.at(graph.nodeIDs[splitNode])) return;
+				assert(splitNode < (size_t)1 << positionSize);
+				assert(remainingOffset < 64);
+				std::pair<uint64_t, uint64_t> storeThis;
+				storeThis.first = kmer;
+				size_t bucket = getBucket(kmer);
+				storeThis.second = splitNode;
+				storeThis.second <<= 6;
+				storeThis.second += remainingOffset;
+				positionDistributor[bucket].enqueue(storeThis);
+				sinceDrain += 1;
+				if (sinceDrain == drainInterval)
+				{
+					sinceDrain = 0;
+					tryDrainNext();
+				}
+			};
 			while (true)
 			{
 				auto iter = graph.nodeLookup.end();
@@ -356,7 +486,6 @@ void MinimizerSeeder::initMinimizers(size_t numThreads)
 				}
 				if (iter == graph.nodeLookup.end()) break;
 				int nodeId = iter->first;
-				int firstNode = iter->second[0];
 				std::string sequence;
 				sequence.resize(graph.originalNodeSize.at(nodeId));
 				for (size_t pos = 0; pos < sequence.size(); pos++)
@@ -364,122 +493,122 @@ void MinimizerSeeder::initMinimizers(size_t numThreads)
 					size_t nodeidHere = graph.GetUnitigNode(nodeId, pos);
 					sequence[pos] = graph.NodeSequences(nodeidHere, pos - graph.nodeOffset[nodeidHere]);
 				}
-				iterateMinimizers(sequence, minimizerLength, windowSize, [this, &nodeMinimizerStart, &positionDistributor, &kmerPerBucket, &positionPerBucket, &vecPos, positionSize, thread, nodeId](size_t pos, size_t kmer)
+				auto addKmer = [this, &nodeMinimizerStart, &addPosition, nodeId](size_t pos, size_t kmer)
 				{
 					if (pos < nodeMinimizerStart.at(nodeId)) return;
 					size_t splitNode = graph.GetUnitigNode(nodeId, pos);
-					assert(splitNode < (size_t)1 << positionSize);
-					size_t remainingOffset = pos - graph.nodeOffset[splitNode];
-					assert(remainingOffset < 64);
-					std::pair<uint64_t, uint64_t> readThis;
-					while (positionDistributor[thread].try_dequeue(readThis))
-					{
-						assert(readThis.first < ((uint64_t)1) << (kmerPerBucket[thread].width()));
-						assert(readThis.second < ((uint64_t)1) << (positionPerBucket[thread].width()));
-						assert(getBucket(readThis.first) == thread);
-						if (vecPos == kmerPerBucket[thread].size())
-						{
-							kmerPerBucket[thread].resize(kmerPerBucket[thread].size() * 2);
-							positionPerBucket[thread].resize(kmerPerBucket[thread].size() * 2);
-						}
-						kmerPerBucket[thread][vecPos] = readThis.first;
-						positionPerBucket[thread][vecPos] = readThis.second;
-						vecPos += 1;
-					}
-					std::pair<uint64_t, uint64_t> storeThis;
-					storeThis.first = kmer;
-					size_t bucket = getBucket(kmer);
-					storeThis.second = splitNode;
-					storeThis.second <<= 6;
-					storeThis.second += remainingOffset;
-					positionDistributor[bucket].enqueue(storeThis);
-				});
-			}
-			threadsDone += 1;
-			while (threadsDone < numThreads)
-			{
-				std::this_thread::sleep_for(std::chrono::milliseconds(10));
-				while (positionDistributor[thread].try_dequeue(readThis))
+					addPosition(splitNode, pos - graph.nodeOffset[splitNode], kmer);
+				};
+				if (syncmerLength > 0)
 				{
-					assert(readThis.first < ((uint64_t)1) << (kmerPerBucket[thread].width()));
-					assert(readThis.second < ((uint64_t)1) << (positionPerBucket[thread].width()));
-					assert(getBucket(readThis.first) == thread);
-					if (vecPos == kmerPerBucket[thread].size())
-					{
-						kmerPerBucket[thread].resize(kmerPerBucket[thread].size() * 2);
-						positionPerBucket[thread].resize(kmerPerBucket[thread].size() * 2);
-					}
-					kmerPerBucket[thread][vecPos] = readThis.first;
-					positionPerBucket[thread][vecPos] = readThis.second;
-					vecPos += 1;
+					iterateSyncmers(sequence, minimizerLength, syncmerLength, addKmer);
 				}
+				else
+				{
+					iterateMinimizers(sequence, minimizerLength, windowSize, addKmer);
+				}
+				tryDrainNext();
 			}
-			while (positionDistributor[thread].try_dequeue(readThis))
+			// the paths into a node start share most of their k-mers, so drop the repeats before queuing them
+			std::vector<std::tuple<size_t, size_t, size_t>> nodeStartKmers;
+			while (true)
 			{
-				assert(readThis.first < ((uint64_t)1) << (kmerPerBucket[thread].width()));
-				assert(readThis.second < ((uint64_t)1) << (positionPerBucket[thread].width()));
-				assert(getBucket(readThis.first) == thread);
-				if (vecPos == kmerPerBucket[thread].size())
+				size_t index = nextNodeStart++;
+				if (index >= nodeStarts.size()) break;
+				nodeStartKmers.clear();
+				iterateNodeStartKmers(nodeStarts[index], [&nodeStartKmers](size_t splitNode, size_t offset, size_t kmer)
 				{
-					kmerPerBucket[thread].resize(kmerPerBucket[thread].size() * 2);
-					positionPerBucket[thread].resize(kmerPerBucket[thread].size() * 2);
+					nodeStartKmers.emplace_back(splitNode, offset, kmer);
+				});
+				std::sort(nodeStartKmers.begin(), nodeStartKmers.end());
+				nodeStartKmers.erase(std::unique(nodeStartKmers.begin(), nodeStartKmers.end()), nodeStartKmers.end());
+				for (auto t : nodeStartKmers)
+				{
+					addPosition(std::get<0>(t), std::get<1>(t), std::get<2>(t));
 				}
-				kmerPerBucket[thread][vecPos] = readThis.first;
-				positionPerBucket[thread][vecPos] = readThis.second;
-				vecPos += 1;
+				tryDrainNext();
 			}
-			kmerPerBucket[thread].resize(vecPos);
-			positionPerBucket[thread].resize(vecPos);
+		});
+	}
+
+	for (size_t i = 0; i < threads.size(); i++)
+	{
+		threads[i].join();
+	}
+	threads.clear();
+
+	// then build the buckets, threads grab the next unbuilt bucket until none are left
+	std::atomic<size_t> nextBucket;
+	nextBucket = 0;
+	for (size_t thread = 0; thread < numThreads; thread++)
+	{
+		threads.emplace_back([this, &nextBucket, &bucketMutex, &drainBucket, &kmerPerBucket, &positionPerBucket, &vecPosPerBucket, numBuckets](){
+			while (true)
 			{
-				std::vector<uint64_t> locatorKeys;
+				size_t bucket = nextBucket++;
+				if (bucket >= numBuckets) break;
 				{
-					sdsl::int_vector<0> sortedKmers;
-					sortedKmers = kmerPerBucket[thread];
-					std::sort(sortedKmers.begin(), sortedKmers.end(), [positionSize](uint64_t left, uint64_t right) { return left < right; });
-					size_t current = std::numeric_limits<size_t>::max();
-					for (uint64_t kmer : sortedKmers)
+					std::lock_guard<std::mutex> guard { bucketMutex[bucket] };
+					drainBucket(bucket);
+				}
+				{
+					std::vector<uint64_t> locatorKeys;
 					{
-						assert(getBucket(kmer) == thread);
-						if (kmer == current)
+						// the paths into node starts find the same k-mer at the same position many times, keep it once
+						std::vector<std::pair<uint64_t, uint64_t>> sortedHits;
+						sortedHits.reserve(vecPosPerBucket[bucket]);
+						for (size_t i = 0; i < vecPosPerBucket[bucket]; i++)
 						{
-							continue;
+							sortedHits.emplace_back(kmerPerBucket[bucket][i], positionPerBucket[bucket][i]);
+						}
+						std::sort(sortedHits.begin(), sortedHits.end());
+						sortedHits.erase(std::unique(sortedHits.begin(), sortedHits.end()), sortedHits.end());
+						kmerPerBucket[bucket].resize(sortedHits.size());
+						positionPerBucket[bucket].resize(sortedHits.size());
+						for (size_t i = 0; i < sortedHits.size(); i++)
+						{
+							assert(getBucket(sortedHits[i].first) == bucket);
+							kmerPerBucket[bucket][i] = sortedHits[i].first;
+							positionPerBucket[bucket][i] = sortedHits[i].second;
+							if (locatorKeys.size() == 0 || locatorKeys.back() != sortedHits[i].first) locatorKeys.push_back(sortedHits[i].first);
 						}
-						current = kmer;
-						locatorKeys.push_back(current);
 					}
+					buckets[bucket].locator = new boomphf::mphf<uint64_t,KmerBucket::hasher_t>(locatorKeys.size(), locatorKeys, 1, 2, true, false);
 				}
-				buckets[thread].locator = new boomphf::mphf<uint64_t,KmerBucket::hasher_t>(locatorKeys.size(), locatorKeys, 1, 2, true, false);
-			}
-			buckets[thread].startPos.width(log2(kmerPerBucket[thread].size())+1);
-			buckets[thread].startPos.resize(buckets[thread].locator->nbKeys() + 1);
-			buckets[thread].kmerCheck.width(minimizerLength * 2);
-			buckets[thread].kmerCheck.resize(buckets[thread].locator->nbKeys());
-			sdsl::util::set_to_value(buckets[thread].startPos, 0);
-			for (size_t i = 0; i < kmerPerBucket[thread].size(); i++)
-			{
-				uint64_t kmer = kmerPerBucket[thread][i];
-				size_t index = buckets[thread].locator->lookup(kmer);
-				buckets[thread].startPos[index] += 1;
-				buckets[thread].kmerCheck[index] = kmer;
-			}
-			if (buckets[thread].startPos.size() > 0)
-			{
-				for (size_t i = 1; i < buckets[thread].startPos.size(); i++)
+				buckets[bucket].startPos.width(log2(kmerPerBucket[bucket].size())+1);
+				buckets[bucket].startPos.resize(buckets[bucket].locator->nbKeys() + 1);
+				buckets[bucket].kmerCheck.width(minimizerLength * 2);
+				buckets[bucket].kmerCheck.resize(buckets[bucket].locator->nbKeys());
+				sdsl::util::set_to_value(buckets[bucket].startPos, 0);
+				for (size_t i = 0; i < kmerPerBucket[bucket].size(); i++)
 				{
-					buckets[thread].startPos[i] += buckets[thread].startPos[i-1];
+					uint64_t kmer = kmerPerBucket[bucket][i];
+					size_t index = buckets[bucket].locator->lookup(kmer);
+					buckets[bucket].startPos[index] += 1;
+					buckets[bucket].kmerCheck[index] = kmer;
 				}
-				assert(buckets[thread].startPos[buckets[thread].startPos.size()-1] == kmerPerBucket[thread].size());
-				buckets[thread].positions.resize(kmerPerBucket[thread].size());
-				for (size_t i = 0; i < kmerPerBucket[thread].size(); i++)
+				if (buckets[bucket].startPos.size() > 0)
 				{
-					size_t kmer = kmerPerBucket[thread][i];
-					size_t index = buckets[thread].locator->lookup(kmer);
-					assert(buckets[thread].startPos[index] > 0);
-					buckets[thread].startPos[index] -= 1;
-					size_t pos = buckets[thread].startPos[index];
-					uint64_t insert = positionPerBucket[thread][i];
-					buckets[thread].positions[pos] = insert;
-				};
+					for (size_t i = 1; i < buckets[bucket].startPos.size(); i++)
+					{
+						buckets[bucket].startPos[i] += buckets[bucket].startPos[i-1];
+					}
+					assert(buckets[bucket].startPos[buckets[bucket].startPos.size()-1] == kmerPerBucket[bucket].size());
+					buckets[bucket].positions.resize(kmerPerBucket[bucket].size());
+					for (size_t i = 0; i < kmerPerBucket[bucket].size(); i++)
+					{
+						size_t kmer = kmerPerBucket[bucket][i];
+						size_t index = buckets[bucket].locator->lookup(kmer);
+						assert(buckets[bucket].startPos[index] > 0);
+						buckets[bucket].startPos[index] -= 1;
+						size_t pos = buckets[bucket].startPos[index];
+						uint64_t insert = positionPerBucket[bucket][i];
+						buckets[bucket].positions[pos] = insert;
+					};
+				}
+				// free the build buffers as soon as the bucket is done
+				kmerPerBucket[bucket] = sdsl::int_vector<0>{};
+				positionPerBucket[bucket] = sdsl::int_vector<0>{};
 			}
 		});
 	}
@@ -519,23 +648,72 @@ void MinimizerSeeder::addMinimizers(std::vector<SeedHit>& result, std::vector<st
 	}
 }
 
-std::vector<SeedHit> MinimizerSeeder::getSeeds(const std::string& sequence, double density) const
+void prefetchIntVector(const sdsl::int_vector<0>& vec, size_t index)
 {
+	__builtin_prefetch(vec.data() + ((index * vec.width()) >> 6));
+}
+
+std::vector<SeedHit> MinimizerSeeder::getSeeds(const std::string_view& sequence, double density) const
+{
+	std::vector<std::pair<size_t, size_t>> readKmers;
+	if (syncmerLength > 0)
+	{
+		//only syncmers are in the index, and syncmers in the read are syncmers in the graph too
+		size_t lastKmer = std::numeric_limits<size_t>::max();
+		size_t lastPos = 0;
+		iterateSyncmers(sequence, minimizerLength, syncmerLength, [this, &readKmers, &lastKmer, &lastPos](size_t pos, size_t kmer)
+		{
+			//low complexity sequence repeats the same syncmer at every position
+			if (kmer == lastKmer && pos < lastPos + minimizerLength - syncmerLength + 1) return;
+			lastKmer = kmer;
+			lastPos = pos;
+			readKmers.emplace_back(pos, kmer);
+		});
+	}
+	else
+	{
+		//the minimizers of the graph depend on the graph around them, so look up every k-mer of the read
+		iterateKmers(sequence, minimizerLength, windowSize, [&readKmers](size_t pos, size_t kmer) { readKmers.emplace_back(pos, kmer); });
+	}
+	//the kmer check and start positions of a k-mer are random accesses into the index which depend on its hash function lookup.
+	//the k-mers don't depend on each other, so look up and prefetch LookupBatchSize k-mers ahead of the ones being checked
 	std::vector<std::tuple<size_t, size_t, size_t, size_t>> matchIndices;
-	iterateKmers(sequence, minimizerLength, windowSize, [this, &matchIndices](size_t pos, size_t kmer)
-	{
-		size_t bucket = getBucket(kmer);
-		assert(bucket < buckets.size());
-		size_t index = buckets[bucket].locator->lookup(kmer);
-		if (index == ULLONG_MAX) return;
-		assert(index < buckets[bucket].kmerCheck.size());
-		if (buckets[bucket].kmerCheck[(size_t)index] != kmer) return;
-		size_t start = getStart(bucket, index);
-		size_t end = getStart(bucket, index+1);
-		size_t count = end - start;
-		if (count >= maxCount) return;
-		matchIndices.emplace_back(pos, bucket, start, count);
-	});
+	std::array<std::pair<size_t, size_t>, LookupBatchSize> lookedUp;
+	for (size_t i = 0; i < readKmers.size() + LookupBatchSize; i++)
+	{
+		//k-mer i - LookupBatchSize is checked before k-mer i takes its slot
+		if (i >= LookupBatchSize)
+		{
+			size_t checked = i - LookupBatchSize;
+			if (checked >= readKmers.size()) break;
+			size_t bucket = lookedUp[checked % LookupBatchSize].first;
+			size_t index = lookedUp[checked % LookupBatchSize].second;
+			if (index != ULLONG_MAX)
+			{
+				assert(index < buckets[bucket].kmerCheck.size());
+				size_t start = getStart(bucket, index);
+				size_t count = getStart(bucket, index+1) - start;
+				if (buckets[bucket].kmerCheck[(size_t)index] == readKmers[checked].second && count < maxCount)
+				{
+					matchIndices.emplace_back(readKmers[checked].first, bucket, start, count);
+				}
+			}
+		}
+		if (i < readKmers.size())
+		{
+			size_t kmer = readKmers[i].second;
+			size_t bucket = getBucket(kmer);
+			assert(bucket < buckets.size());
+			size_t index = buckets[bucket].locator->lookup(kmer);
+			lookedUp[i % LookupBatchSize] = std::make_pair(bucket, index);
+			if (index != ULLONG_MAX)
+			{
+				prefetchIntVector(buckets[bucket].kmerCheck, index);
+				prefetchIntVector(buckets[bucket].startPos, index);
+				prefetchIntVector(buckets[bucket].startPos, index+1);
+			}
+		}
+	}
 	std::vector<SeedHit> result;
 	size_t maxHits = sequence.size() * density;
 	if (density == -1) maxHits = std::numeric_limits<size_t>::max();
@@ -579,9 +757,11 @@ size_t MinimizerSeeder::getStart(size_t bucket, size_t index) const
 	return buckets[bucket].startPos[index];
 }
 
-size_t MinimizerSeeder::getBucket(size_t hash) const
+size_t MinimizerSeeder::getBucket(size_t kmer) const
 {
-	return hash % buckets.size();
+	assert((buckets.size() & (buckets.size() - 1)) == 0);
+	// low bits of the raw kmer are the last bases which are not evenly distributed, so use the hash instead
+	return KmerHashKernel::Hash(kmer) & (buckets.size() - 1);
 }
 
 MinimizerSeeder::KmerBucket::KmerBucket() :
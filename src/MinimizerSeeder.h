@@ -4,6 +4,7 @@
 #include <random>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <sdsl/int_vector.hpp>
 #include <sdsl/select_support_mcl.hpp>
 #include <ParallelBB.h>
@@ -29,20 +30,27 @@ class MinimizerSeeder
 		sdsl::int_vector<0> positions;
 	};
 public:
-	MinimizerSeeder(const AlignmentGraph& graph, size_t minimizerLength, size_t windowSize, size_t numThreads, double keepLeastFrequentFraction);
-	std::vector<SeedHit> getSeeds(const std::string& sequence, double density) const;
+	//syncmerLength 0 samples window minimizers, otherwise closed syncmers with s-mers of syncmerLength and windowSize isn't used
+	MinimizerSeeder(const AlignmentGraph& graph, size_t minimizerLength, size_t windowSize, size_t syncmerLength, size_t numThreads, size_t numBuckets, double keepLeastFrequentFraction, const std::string& indexFile);
+	std::vector<SeedHit> getSeeds(const std::string_view& sequence, double density) const;
 	bool canSeed() const;
 private:
 	void addMinimizers(std::vector<SeedHit>& result, std::vector<std::tuple<size_t, size_t, size_t, size_t>>& matchIndices, size_t maxCount) const;
 	size_t getStart(size_t bucket, size_t index) const;
-	size_t getBucket(size_t hash) const;
+	size_t getBucket(size_t kmer) const;
 	SeedHit matchToSeedHit(int nodeId, size_t nodeOffset, size_t seqPos, int count) const;
-	void initMinimizers(size_t numThreads);
+	template <typename CallbackF>
+	void iterateNodeStartKmers(size_t node, CallbackF callback) const;
+	void initMinimizers(size_t numThreads, size_t numBuckets);
 	void initMaxCount(double keepLeastFrequentFraction);
+	uint64_t graphChecksum() const;
+	void saveTo(const std::string& indexFile, double keepLeastFrequentFraction) const;
+	bool loadFrom(const std::string& indexFile, double keepLeastFrequentFraction);
 	const AlignmentGraph& graph;
 	std::vector<KmerBucket> buckets;
 	size_t minimizerLength;
 	size_t windowSize;
+	size_t syncmerLength;
 	size_t maxCount;
 };
 
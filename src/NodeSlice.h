@@ -8,21 +8,24 @@
 #include <type_traits>
 #include <phmap.h>
 #include "AlignmentGraph.h"
+#include "MemoryArena.h"
+#include "PagedNodeArray.h"
 #include "ThreadReadAssertion.h"
 #include "WordSlice.h"
 
 
+//minScore and exists are placed in the tail padding of the word slices, so with 64 bit words an item is one cache line instead of 80 bytes
 template <typename LengthType, typename ScoreType, typename Word>
 struct NodeSliceMapItemStruct
 {
 	static constexpr size_t NUM_CHUNKS = (AlignmentGraph::SPLIT_NODE_SIZE + WordConfiguration<Word>::WordSize - 1) / WordConfiguration<Word>::WordSize;
 	NodeSliceMapItemStruct() :
 	startSlice(),
+	minScore(0),
 	endSlice(),
 	exists(false),
 	HP(),
-	HN(),
-	minScore(0)
+	HN()
 #ifdef SLICEVERBOSE
 	,firstSlicesCalcedWhenCalced(std::numeric_limits<size_t>::max())
 	,slicesCalcedWhenCalced(std::numeric_limits<size_t>::max())
@@ -34,24 +37,28 @@ struct NodeSliceMapItemStruct
 			HN[i] = 0;
 		}
 	}
-	WordSlice<LengthType, ScoreType, Word> startSlice;
-	WordSlice<LengthType, ScoreType, Word> endSlice;
+	[[no_unique_address]] WordSlice<LengthType, ScoreType, Word> startSlice;
+	ScoreType minScore;
+	[[no_unique_address]] WordSlice<LengthType, ScoreType, Word> endSlice;
 	bool exists;
 	Word HP[NUM_CHUNKS];
 	Word HN[NUM_CHUNKS];
-	ScoreType minScore;
 #ifdef SLICEVERBOSE
 	size_t firstSlicesCalcedWhenCalced;
 	size_t slicesCalcedWhenCalced;
 #endif
 };
 
+#ifndef SLICEVERBOSE
+static_assert(sizeof(NodeSliceMapItemStruct<size_t, int32_t, uint64_t>) == 64);
+#endif
+
 template <typename LengthType, typename ScoreType, typename Word, bool UseVectorMap>
 class NodeSlice
 {
 public:
 	using NodeSliceMapItem = NodeSliceMapItemStruct<LengthType, ScoreType, Word>;
-	using MapType = phmap::flat_hash_map<size_t, NodeSliceMapItem>;
+	using MapType = phmap::flat_hash_map<size_t, NodeSliceMapItem, phmap::Hash<size_t>, phmap::EqualTo<size_t>, ArenaAllocator<std::pair<const size_t, NodeSliceMapItem>>>;
 	using MapItem = NodeSliceMapItem;
 	class NodeSliceIterator : std::iterator<std::forward_iterator_tag, std::pair<size_t, MapItem>>
 	{
@@ -193,23 +200,25 @@ public:
 	{
 	}
 	template <bool HasVectorMap = UseVectorMap>
-	NodeSlice(typename std::enable_if<HasVectorMap, std::vector<NodeSliceMapItem>*>::type vectorMap) :
+	NodeSlice(typename std::enable_if<HasVectorMap, PagedNodeArray<NodeSliceMapItem>*>::type vectorMap) :
 	vectorMap(vectorMap),
 	nodes(nullptr)
 	{
 	}
-	void addEmptyNodeMap(size_t size)
+	//the map is allocated from the arena if there is one
+	void addEmptyNodeMap(size_t size, MemoryArena* arena = nullptr)
 	{
 		assert(nodes == nullptr);
-		nodes = std::make_shared<MapType>();
+		ArenaAllocator<typename MapType::value_type> allocator { arena };
+		nodes = std::allocate_shared<MapType>(ArenaAllocator<MapType> { allocator }, allocator);
 		nodes->reserve(size);
 	}
 	template <bool HasVectorMap = UseVectorMap>
-	typename std::enable_if<HasVectorMap, NodeSlice<LengthType, ScoreType, Word, false>>::type getMapSlice() const
+	typename std::enable_if<HasVectorMap, NodeSlice<LengthType, ScoreType, Word, false>>::type getMapSlice(MemoryArena* arena) const
 	{
 		assert(vectorMap != nullptr);
 		NodeSlice<LengthType, ScoreType, Word, false> result;
-		result.addEmptyNodeMap(activeVectorMapIndices.size());
+		result.addEmptyNodeMap(activeVectorMapIndices.size(), arena);
 		for (auto index : activeVectorMapIndices)
 		{
 			assert((*vectorMap)[index].exists);
@@ -322,7 +331,8 @@ public:
 		{
 			if (item.second.exists) newActiveMapItems.push_back(item);
 		}
-		nodes = std::make_shared<MapType>();
+		auto allocator = nodes->get_allocator();
+		nodes = std::allocate_shared<MapType>(ArenaAllocator<MapType> { allocator }, allocator);
 		nodes->resize(newActiveMapItems.size());
 		for (auto item : newActiveMapItems)
 		{
@@ -406,6 +416,15 @@ public:
 	{
 		return vectorMap != nullptr;
 	}
+	bool hasNodeMap() const
+	{
+		return nodes != nullptr;
+	}
+	//copies of the slice share the map, it is freed when the last one removes it
+	void removeNodeMap()
+	{
+		nodes.reset();
+	}
 private:
 	template <bool HasVectorMap = UseVectorMap>
 	typename std::enable_if<HasVectorMap>::type clearVectorMap()
@@ -417,7 +436,7 @@ private:
 		}
 		activeVectorMapIndices.clear();
 	}
-	std::vector<NodeSliceMapItem>* vectorMap;
+	PagedNodeArray<NodeSliceMapItem>* vectorMap;
 	std::vector<size_t> activeVectorMapIndices;
 	std::shared_ptr<MapType> nodes;
 	friend class NodeSliceIterator;
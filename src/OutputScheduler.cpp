@@ -0,0 +1,345 @@
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "OutputScheduler.h"
+#include "ThreadReadAssertion.h"
+
+//blocks are handed to the writer once they have this much output
+const size_t OutputBlockSize = 1024 * 1024;
+//written blocks each thread keeps for reuse, the rest are freed
+const size_t MaxFreeOutputBlocks = 4;
+//blocks waiting for the writer per worker thread before the workers have to wait
+const size_t QueuedBlocksPerProducer = 4;
+const size_t MaxBlocksPerWrite = 64;
+//sequence numbers per worker thread that can be ahead of the next one to be written in ordered mode.
+//the window only has to cover the threads' spread in progress, a slow read stalls the others once it is full.
+//has to be larger than the read scheduler's lookahead, otherwise the workers can wait for a batch nobody has picked up
+const size_t ReorderWindowPerProducer = 8;
+
+void writeParts(const std::string& filename, int fd, std::vector<iovec>& parts)
+{
+	size_t first = 0;
+	while (first < parts.size())
+	{
+		ssize_t written = writev(fd, parts.data() + first, std::min(parts.size() - first, (size_t)IOV_MAX));
+		if (written < 0)
+		{
+			if (errno == EINTR) continue;
+			throw std::runtime_error { "Could not write to " + filename + ": " + strerror(errno) };
+		}
+		size_t left = written;
+		while (first < parts.size() && left >= parts[first].iov_len)
+		{
+			left -= parts[first].iov_len;
+			first++;
+		}
+		if (left > 0)
+		{
+			parts[first].iov_base = (char*)parts[first].iov_base + left;
+			parts[first].iov_len -= left;
+		}
+	}
+}
+
+OutputScheduler::OutputScheduler(size_t producers, bool ordered) :
+streams(),
+freeLists(),
+parts(),
+queue(std::max((size_t)1, producers) * QueuedBlocksPerProducer),
+ordered(ordered),
+reorderWindow(std::max((size_t)1, producers) * ReorderWindowPerProducer),
+reorderBuffer(),
+nextSequence(0),
+writerFailed(false),
+windowMutex(),
+windowMoved(),
+started(false),
+finished(false),
+error(),
+writer()
+{
+	for (size_t i = 0; i < producers; i++)
+	{
+		freeLists.emplace_back(std::make_unique<FreeList>());
+	}
+	if (ordered) reorderBuffer.resize(reorderWindow);
+}
+
+OutputScheduler::~OutputScheduler()
+{
+	if (!finished)
+	{
+		queue.close();
+		if (writer.joinable()) writer.join();
+		for (auto& stream : streams) ::close(stream.fd);
+	}
+	for (auto& unit : reorderBuffer)
+	{
+		for (const auto& block : unit) delete block.data;
+	}
+	for (auto& list : freeLists)
+	{
+		for (auto block : list->blocks) delete block;
+	}
+}
+
+size_t OutputScheduler::addStream(const std::string& filename, const std::string& emptyContent)
+{
+	assert(!started);
+	int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (fd == -1) throw std::runtime_error { "Could not open output file " + filename + ": " + strerror(errno) };
+	streams.push_back(Stream { filename, fd, emptyContent, false });
+	return streams.size()-1;
+}
+
+void OutputScheduler::start()
+{
+	assert(!started);
+	started = true;
+	writer = std::thread { [this]() { writeBlocks(); } };
+}
+
+void OutputScheduler::write(size_t producer, size_t stream, std::string* block)
+{
+	assert(producer < freeLists.size());
+	assert(stream < streams.size());
+	assert(!ordered);
+	Block item { producer, stream, block, 0 };
+	//the queue is only closed early if writing failed, and finish reports that
+	if (!queue.push(item)) returnBlock(item);
+}
+
+void OutputScheduler::writeOrdered(size_t producer, size_t sequence, size_t stream, std::string* block)
+{
+	assert(producer < freeLists.size());
+	assert(stream < streams.size());
+	assert(ordered);
+	{
+		std::unique_lock<std::mutex> lock { windowMutex };
+		windowMoved.wait(lock, [this, sequence]() { return writerFailed || sequence < nextSequence + reorderWindow; });
+	}
+	Block item { producer, stream, block, sequence };
+	if (!queue.push(item)) returnBlock(item);
+}
+
+std::string* OutputScheduler::getBlock(size_t producer)
+{
+	assert(producer < freeLists.size());
+	FreeList& list = *freeLists[producer];
+	std::lock_guard<std::mutex> lock { list.mutex };
+	if (list.blocks.size() == 0) return new std::string;
+	std::string* result = list.blocks.back();
+	list.blocks.pop_back();
+	result->clear();
+	return result;
+}
+
+void OutputScheduler::finish()
+{
+	if (finished) return;
+	finished = true;
+	queue.close();
+	if (writer.joinable()) writer.join();
+	for (auto& stream : streams)
+	{
+		try
+		{
+			if (!error && !stream.wroteAny && stream.emptyContent.size() > 0)
+			{
+				std::vector<iovec> parts { iovec { (void*)stream.emptyContent.data(), stream.emptyContent.size() } };
+				writeParts(stream.filename, stream.fd, parts);
+			}
+		}
+		catch (...)
+		{
+			error = std::current_exception();
+		}
+		::close(stream.fd);
+	}
+	if (error) std::rethrow_exception(error);
+}
+
+void OutputScheduler::writeBlocks()
+{
+	assertSetNoRead("Writer");
+	std::vector<Block> batch;
+	std::vector<Block> ready;
+	try
+	{
+		while (queue.popBatch(batch, MaxBlocksPerWrite))
+		{
+			if (ordered)
+			{
+				takeInOrder(batch, ready);
+				std::swap(batch, ready);
+				ready.clear();
+			}
+			//one writev per file, blocks of the same file stay in the order they were sent
+			for (size_t i = 0; i < streams.size(); i++)
+			{
+				writeStream(i, batch);
+			}
+			for (const auto& block : batch) returnBlock(block);
+			batch.clear();
+		}
+	}
+	catch (...)
+	{
+		error = std::current_exception();
+		queue.close();
+		{
+			std::lock_guard<std::mutex> lock { windowMutex };
+			writerFailed = true;
+		}
+		windowMoved.notify_all();
+		for (const auto& block : batch) returnBlock(block);
+		for (const auto& block : ready) returnBlock(block);
+		for (auto& unit : reorderBuffer)
+		{
+			for (const auto& block : unit) returnBlock(block);
+			unit.clear();
+		}
+		Block block;
+		while (queue.tryPop(block)) returnBlock(block);
+	}
+}
+
+//moves the blocks into the reorder window, and the sequence numbers which are complete and next in line into ready
+void OutputScheduler::takeInOrder(const std::vector<Block>& blocks, std::vector<Block>& ready)
+{
+	for (const auto& block : blocks)
+	{
+		assert(block.sequence >= nextSequence && block.sequence < nextSequence + reorderWindow);
+		reorderBuffer[block.sequence % reorderWindow].push_back(block);
+	}
+	//only this thread changes nextSequence
+	size_t next = nextSequence;
+	while (streams.size() > 0 && reorderBuffer[next % reorderWindow].size() == streams.size())
+	{
+		auto& unit = reorderBuffer[next % reorderWindow];
+		ready.insert(ready.end(), unit.begin(), unit.end());
+		unit.clear();
+		next += 1;
+	}
+	if (next == nextSequence) return;
+	{
+		std::lock_guard<std::mutex> lock { windowMutex };
+		nextSequence = next;
+	}
+	windowMoved.notify_all();
+}
+
+void OutputScheduler::writeStream(size_t streamIndex, const std::vector<Block>& blocks)
+{
+	parts.clear();
+	for (const auto& block : blocks)
+	{
+		if (block.stream != streamIndex) continue;
+		parts.push_back(iovec { (void*)block.data->data(), block.data->size() });
+	}
+	if (parts.size() == 0) return;
+	writeParts(streams[streamIndex].filename, streams[streamIndex].fd, parts);
+	streams[streamIndex].wroteAny = true;
+}
+
+void OutputScheduler::returnBlock(const Block& block)
+{
+	FreeList& list = *freeLists[block.producer];
+	{
+		std::lock_guard<std::mutex> lock { list.mutex };
+		if (list.blocks.size() < MaxFreeOutputBlocks)
+		{
+			list.blocks.push_back(block.data);
+			return;
+		}
+	}
+	delete block.data;
+}
+
+OutputBlockWriter::OutputBlockWriter(OutputScheduler& scheduler, size_t producer, size_t stream, bool compressed) :
+scheduler(scheduler),
+producer(producer),
+stream(stream),
+content(),
+compressed(compressed),
+zstream()
+{
+	if (compressed)
+	{
+		memset(&zstream, 0, sizeof(zstream));
+		//16 for a gzip header instead of zlib
+		if (deflateInit2(&zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) throw std::runtime_error { "Could not initialize zlib" };
+	}
+}
+
+OutputBlockWriter::~OutputBlockWriter()
+{
+	if (compressed) deflateEnd(&zstream);
+}
+
+std::string& OutputBlockWriter::buffer()
+{
+	return content;
+}
+
+void OutputBlockWriter::rollback(size_t size)
+{
+	assert(size <= content.size());
+	content.resize(size);
+}
+
+void OutputBlockWriter::flushIfFull()
+{
+	if (content.size() >= OutputBlockSize) flush();
+}
+
+void OutputBlockWriter::flush()
+{
+	if (content.size() == 0) return;
+	assert(stream != OutputScheduler::NoStream);
+	scheduler.write(producer, stream, takeBlock());
+}
+
+void OutputBlockWriter::flushOrdered(size_t sequence)
+{
+	if (stream == OutputScheduler::NoStream)
+	{
+		assert(content.size() == 0);
+		return;
+	}
+	scheduler.writeOrdered(producer, sequence, stream, takeBlock());
+}
+
+std::string* OutputBlockWriter::takeBlock()
+{
+	std::string* block = scheduler.getBlock(producer);
+	if (content.size() == 0) return block;
+	if (compressed)
+	{
+		compress(*block);
+	}
+	else
+	{
+		std::swap(*block, content);
+	}
+	content.clear();
+	return block;
+}
+
+void OutputBlockWriter::compress(std::string& block)
+{
+	deflateReset(&zstream);
+	block.resize(deflateBound(&zstream, content.size()));
+	zstream.next_in = (unsigned char*)content.data();
+	zstream.avail_in = content.size();
+	zstream.next_out = (unsigned char*)&block[0];
+	zstream.avail_out = block.size();
+	int result = deflate(&zstream, Z_FINISH);
+	if (result != Z_STREAM_END) throw std::runtime_error { "Compressing output failed" };
+	block.resize(zstream.total_out);
+}
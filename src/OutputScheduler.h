@@ -0,0 +1,110 @@
+#ifndef OutputScheduler_h
+#define OutputScheduler_h
+
+#include <exception>
+#include <limits>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/uio.h>
+#include <zlib.h>
+#include "BlockingQueue.h"
+
+//writes the output of all worker threads to all output files from one thread
+//workers hand over filled blocks, and the writer sleeps on a condition variable until there are some
+//the blocks are written with writev and then given back to the free list of the thread that sent them
+//in ordered mode the blocks are numbered and held in a reorder window until all earlier blocks have been written
+class OutputScheduler
+{
+	struct Block
+	{
+		size_t producer;
+		size_t stream;
+		std::string* data;
+		size_t sequence;
+	};
+	struct FreeList
+	{
+		std::mutex mutex;
+		std::vector<std::string*> blocks;
+	};
+	struct Stream
+	{
+		std::string filename;
+		int fd;
+		std::string emptyContent;
+		bool wroteAny;
+	};
+public:
+	static constexpr size_t NoStream = std::numeric_limits<size_t>::max();
+	OutputScheduler(size_t producers, bool ordered);
+	~OutputScheduler();
+	OutputScheduler(const OutputScheduler& other) = delete;
+	OutputScheduler& operator=(const OutputScheduler& other) = delete;
+	//opens the file, must be called before start. emptyContent is written if the stream gets no output
+	size_t addStream(const std::string& filename, const std::string& emptyContent);
+	void start();
+	//takes ownership of the block. blocks while the writer is behind
+	void write(size_t producer, size_t stream, std::string* block);
+	//ordered mode only. every stream gets exactly one block, possibly empty, for each sequence number starting from 0
+	//blocks while the sequence number is too far ahead of the next one to be written
+	void writeOrdered(size_t producer, size_t sequence, size_t stream, std::string* block);
+	//an empty block from the producer's free list, or a new one
+	std::string* getBlock(size_t producer);
+	//writes the remaining blocks and closes the files. rethrows write errors
+	void finish();
+private:
+	void writeBlocks();
+	void takeInOrder(const std::vector<Block>& blocks, std::vector<Block>& ready);
+	void writeStream(size_t streamIndex, const std::vector<Block>& blocks);
+	void returnBlock(const Block& block);
+	std::vector<Stream> streams;
+	std::vector<std::unique_ptr<FreeList>> freeLists;
+	std::vector<iovec> parts;
+	BlockingQueue<Block> queue;
+	bool ordered;
+	size_t reorderWindow;
+	std::vector<std::vector<Block>> reorderBuffer;
+	size_t nextSequence;
+	bool writerFailed;
+	std::mutex windowMutex;
+	std::condition_variable windowMoved;
+	bool started;
+	bool finished;
+	std::exception_ptr error;
+	std::thread writer;
+};
+
+//collects one thread's output for one stream and hands it to the scheduler in blocks
+//with compression, each block is one gzip member from a deflate stream kept for the whole run.
+//concatenated members are a valid gzip file, and the compression stays in the worker threads
+class OutputBlockWriter
+{
+public:
+	OutputBlockWriter(OutputScheduler& scheduler, size_t producer, size_t stream, bool compressed);
+	~OutputBlockWriter();
+	OutputBlockWriter(const OutputBlockWriter& other) = delete;
+	OutputBlockWriter& operator=(const OutputBlockWriter& other) = delete;
+	//the uncompressed output of the current block. callers append to it
+	std::string& buffer();
+	//drops output after size, for reads whose output failed halfway
+	void rollback(size_t size);
+	void flushIfFull();
+	void flush();
+	//sends the current block to the ordered scheduler even if it is empty
+	void flushOrdered(size_t sequence);
+private:
+	std::string* takeBlock();
+	void compress(std::string& block);
+	OutputScheduler& scheduler;
+	size_t producer;
+	size_t stream;
+	std::string content;
+	bool compressed;
+	z_stream zstream;
+};
+
+#endif
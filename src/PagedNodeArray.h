@@ -0,0 +1,138 @@
+#ifndef PagedNodeArray_h
+#define PagedNodeArray_h
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+//per node items for the whole graph, allocated in pages when a node in the page is first used
+//memory and clearing scale with the part of the graph the alignments touched instead of the graph size
+template <typename T>
+class PagedNodeArray
+{
+	static constexpr size_t PageBits = 10;
+	static constexpr size_t PageSize = (size_t)1 << PageBits;
+public:
+	PagedNodeArray() :
+	pages(),
+	usedPages(),
+	numItems(0)
+	{
+	}
+	PagedNodeArray(size_t size) :
+	pages((size + PageSize - 1) / PageSize),
+	usedPages(),
+	numItems(size)
+	{
+	}
+	size_t size() const
+	{
+		return numItems;
+	}
+	T& operator[](size_t index)
+	{
+		assert(index < numItems);
+		auto& page = pages[index >> PageBits];
+		if (page == nullptr) allocatePage(index >> PageBits);
+		return page[index & (PageSize - 1)];
+	}
+	size_t allocatedItems() const
+	{
+		return usedPages.size() * PageSize;
+	}
+	//frees the pages, items are default constructed again when they are next used
+	void clear()
+	{
+		for (auto page : usedPages) pages[page].reset();
+		usedPages.clear();
+	}
+private:
+	void allocatePage(size_t page)
+	{
+		pages[page] = std::make_unique<T[]>(PageSize);
+		usedPages.push_back(page);
+	}
+	std::vector<std::unique_ptr<T[]>> pages;
+	std::vector<size_t> usedPages;
+	size_t numItems;
+};
+
+//set of nodes with the bits allocated in pages like PagedNodeArray
+class PagedNodeSet
+{
+	static constexpr size_t PageBits = 12;
+	static constexpr size_t PageSize = (size_t)1 << PageBits;
+	static constexpr size_t WordsPerPage = PageSize / 64;
+public:
+	PagedNodeSet() :
+	pages(),
+	usedPages(),
+	numItems(0),
+	numSet(0)
+	{
+	}
+	PagedNodeSet(size_t size) :
+	pages((size + PageSize - 1) / PageSize),
+	usedPages(),
+	numItems(size),
+	numSet(0)
+	{
+	}
+	size_t size() const
+	{
+		return numItems;
+	}
+	size_t count() const
+	{
+		return numSet;
+	}
+	bool operator[](size_t index) const
+	{
+		assert(index < numItems);
+		const uint64_t* page = pages[index >> PageBits].get();
+		if (page == nullptr) return false;
+		return (page[(index & (PageSize - 1)) / 64] >> (index % 64)) & 1;
+	}
+	void set(size_t index)
+	{
+		assert(index < numItems);
+		auto& page = pages[index >> PageBits];
+		if (page == nullptr) allocatePage(index >> PageBits);
+		uint64_t& word = page[(index & (PageSize - 1)) / 64];
+		uint64_t bit = (uint64_t)1 << (index % 64);
+		if (word & bit) return;
+		word |= bit;
+		numSet += 1;
+	}
+	void reset(size_t index)
+	{
+		assert(index < numItems);
+		uint64_t* page = pages[index >> PageBits].get();
+		if (page == nullptr) return;
+		uint64_t& word = page[(index & (PageSize - 1)) / 64];
+		uint64_t bit = (uint64_t)1 << (index % 64);
+		if (!(word & bit)) return;
+		word &= ~bit;
+		numSet -= 1;
+	}
+	//unsets every node but keeps the pages, they are small
+	void clear()
+	{
+		for (auto page : usedPages) memset(pages[page].get(), 0, WordsPerPage * sizeof(uint64_t));
+		numSet = 0;
+	}
+private:
+	void allocatePage(size_t page)
+	{
+		pages[page] = std::make_unique<uint64_t[]>(WordsPerPage);
+		usedPages.push_back(page);
+	}
+	std::vector<std::unique_ptr<uint64_t[]>> pages;
+	std::vector<size_t> usedPages;
+	size_t numItems;
+	size_t numSet;
+};
+
+#endif
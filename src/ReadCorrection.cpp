@@ -35,7 +35,7 @@ size_t getLongestOverlap(const std::string& left, const std::string& right, size
 	return 0;
 }
 
-std::string getCorrected(const std::string& raw, const std::vector<Correction>& corrections, size_t maxOverlap)
+std::string getCorrected(const std::string_view& raw, const std::vector<Correction>& corrections, size_t maxOverlap)
 {
 	std::string result;
 	size_t currentEnd = 0;
@@ -49,7 +49,7 @@ std::string getCorrected(const std::string& raw, const std::vector<Correction>&
 		}
 		else if (corrections[i].startIndex > currentEnd)
 		{
-			result += toLower(raw.substr(currentEnd, corrections[i].startIndex - currentEnd));
+			result += toLower(std::string { raw.substr(currentEnd, corrections[i].startIndex - currentEnd) });
 			result += toUpper(corrections[i].corrected);
 		}
 		else
@@ -59,6 +59,6 @@ std::string getCorrected(const std::string& raw, const std::vector<Correction>&
 		}
 		currentEnd = corrections[i].endIndex;
 	}
-	if (currentEnd < raw.size()) result += toLower(raw.substr(currentEnd));
+	if (currentEnd < raw.size()) result += toLower(std::string { raw.substr(currentEnd) });
 	return result;
 }
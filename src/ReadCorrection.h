@@ -2,6 +2,7 @@
 #define ReadCorrection_h
 
 #include <string>
+#include <string_view>
 #include <vector>
 
 struct Correction
@@ -11,6 +12,6 @@ struct Correction
 	std::string corrected;
 };
 
-std::string getCorrected(const std::string& raw, const std::vector<Correction>& corrections, size_t maxOverlap);
+std::string getCorrected(const std::string_view& raw, const std::vector<Correction>& corrections, size_t maxOverlap);
 
 #endif
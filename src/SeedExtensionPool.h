@@ -0,0 +1,158 @@
+#ifndef SeedExtensionPool_h
+#define SeedExtensionPool_h
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include "ThreadReadAssertion.h"
+
+//lets worker threads which have run out of reads help the others with the seed extensions of their reads
+//a helper lends its thread and its graph sized state, so the pool needs no extra threads or memory
+//tasks are only queued while helpers are idle, and the submitter runs a task itself if no helper has started it by the time the result is needed
+template <typename State>
+class SeedExtensionPool
+{
+public:
+	class Task
+	{
+		enum Status
+		{
+			Queued,
+			Running,
+			Cancelled
+		};
+	public:
+		Task(std::function<void(State&)>&& work) :
+		work(std::move(work)),
+		status(Queued),
+		done(false),
+		error()
+		{
+		}
+		//runs the work with state unless a helper has already started it, in which case waits for it. rethrows exceptions from the work
+		void runOrWait(State& state)
+		{
+			if (tryStart())
+			{
+				run(state);
+			}
+			else
+			{
+				waitDone();
+			}
+			if (error) std::rethrow_exception(error);
+		}
+		//for results which aren't needed. returns false if the work is already running
+		bool tryCancel()
+		{
+			int expected = Queued;
+			return status.compare_exchange_strong(expected, Cancelled);
+		}
+		//the work might still use the data it refers to until this returns
+		void cancelOrWait()
+		{
+			if (tryCancel()) return;
+			waitDone();
+		}
+	private:
+		bool tryStart()
+		{
+			int expected = Queued;
+			return status.compare_exchange_strong(expected, Running);
+		}
+		void run(State& state)
+		{
+			try
+			{
+				work(state);
+			}
+			catch (...)
+			{
+				error = std::current_exception();
+				state.clear();
+			}
+			{
+				std::lock_guard<std::mutex> lock { mutex };
+				done = true;
+			}
+			finished.notify_all();
+		}
+		void waitDone()
+		{
+			std::unique_lock<std::mutex> lock { mutex };
+			finished.wait(lock, [this]() { return done; });
+		}
+		std::function<void(State&)> work;
+		std::atomic<int> status;
+		std::mutex mutex;
+		std::condition_variable finished;
+		bool done;
+		std::exception_ptr error;
+		friend class SeedExtensionPool;
+	};
+	SeedExtensionPool(size_t workers) :
+	workers(workers),
+	helpers(0),
+	idleHelpers(0),
+	closed(false)
+	{
+	}
+	SeedExtensionPool(const SeedExtensionPool& other) = delete;
+	SeedExtensionPool& operator=(const SeedExtensionPool& other) = delete;
+	//called by a worker when it has no more reads. runs other workers' tasks and returns once every worker has called this
+	void help(State& state)
+	{
+		assertSetNoRead("Seed extension helper");
+		std::unique_lock<std::mutex> lock { mutex };
+		helpers += 1;
+		assert(helpers <= workers);
+		if (helpers == workers)
+		{
+			closed = true;
+			taskAvailable.notify_all();
+		}
+		while (true)
+		{
+			idleHelpers += 1;
+			taskAvailable.wait(lock, [this]() { return closed || tasks.size() > 0; });
+			idleHelpers -= 1;
+			if (tasks.size() == 0) break;
+			std::shared_ptr<Task> task = std::move(tasks.front());
+			tasks.pop_front();
+			lock.unlock();
+			if (task->tryStart()) task->run(state);
+			assertSetNoRead("Seed extension helper");
+			lock.lock();
+		}
+	}
+	//queues the task if a helper is idle to pick it up
+	bool trySubmit(const std::shared_ptr<Task>& task)
+	{
+		{
+			std::lock_guard<std::mutex> lock { mutex };
+			if (closed || idleHelpers <= tasks.size()) return false;
+			tasks.push_back(task);
+		}
+		taskAvailable.notify_one();
+		return true;
+	}
+	bool hasIdleHelpers() const
+	{
+		return idleHelpers > 0;
+	}
+private:
+	size_t workers;
+	size_t helpers;
+	std::atomic<size_t> idleHelpers;
+	bool closed;
+	std::deque<std::shared_ptr<Task>> tasks;
+	std::mutex mutex;
+	std::condition_variable taskAvailable;
+};
+
+#endif
@@ -0,0 +1,57 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include "ColinearChaining.h"
+
+//hand made anchor sets with known chains. exits with 1 if any of them chains differently
+
+using ColinearChaining::Anchor;
+using ColinearChaining::Chain;
+
+size_t failures = 0;
+
+void check(const std::string& name, const std::vector<Anchor>& anchors, const std::vector<std::vector<size_t>>& expectedChains, const std::vector<size_t>& expectedScores)
+{
+	auto chains = ColinearChaining::chainAnchors(anchors);
+	bool ok = chains.size() == expectedChains.size();
+	for (size_t i = 0; ok && i < chains.size(); i++)
+	{
+		if (chains[i].anchors != expectedChains[i]) ok = false;
+		if (chains[i].score != expectedScores[i]) ok = false;
+	}
+	std::cout << (ok ? "ok     " : "FAILED ") << name << std::endl;
+	if (ok) return;
+	failures += 1;
+	for (const auto& chain : chains)
+	{
+		std::cout << "  score " << chain.score << " anchors";
+		for (auto anchor : chain.anchors) std::cout << " " << anchor;
+		std::cout << std::endl;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	//graph, read, length
+	check("colinear", { { 115, 114, 15 }, { 215, 214, 15 }, { 315, 314, 15 } }, { { 0, 1, 2 } }, { 45 });
+	check("input order", { { 315, 314, 15 }, { 115, 114, 15 }, { 215, 214, 15 } }, { { 1, 2, 0 } }, { 45 });
+	//overlapping in the read, a diagonal change of 7 but backwards in the graph
+	check("backwards in graph", { { 1000, 100, 30 }, { 995, 102, 30 } }, { { 0 }, { 1 } }, { 30, 30 });
+	//the higher diagonal is forward in the graph, gap costs 10
+	check("higher diagonal", { { 1110, 100, 15 }, { 2000, 1000, 15 } }, { { 0, 1 } }, { 20 });
+	check("lower diagonal", { { 1090, 100, 15 }, { 2000, 1000, 15 } }, { { 0, 1 } }, { 20 });
+	//overlapping anchors only add the bases past the previous end
+	check("overlap", { { 119, 119, 20 }, { 124, 124, 20 } }, { { 0, 1 } }, { 25 });
+	//the overlapping anchors cover 25 bases, the distant one adds 20 for a gap of 3
+	check("overlap then gap", { { 119, 119, 20 }, { 124, 124, 20 }, { 227, 224, 20 } }, { { 0, 1, 2 } }, { 42 });
+	//a diagonal jump over the limit starts a new chain
+	check("diagonal limit", { { 115, 114, 15 }, { 815, 214, 15 }, { 915, 314, 15 } }, { { 1, 2 }, { 0 } }, { 30, 15 });
+	//anchors at the same read position aren't chained
+	check("same read position", { { 115, 114, 15 }, { 130, 114, 15 } }, { { 0 }, { 1 } }, { 15, 15 });
+	if (failures > 0)
+	{
+		std::cout << failures << " failed" << std::endl;
+		return 1;
+	}
+	return 0;
+}
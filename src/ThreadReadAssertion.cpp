@@ -18,9 +18,9 @@ namespace ThreadReadAssertion
 		std::cerr << msg.str() << std::endl;
 		std::abort();
 	}
-	void setRead(const std::string& readName)
+	void setRead(std::string_view readName)
 	{
-		currentRead = std::string_view(readName.data(), readName.size());
+		currentRead = readName;
 	}
 	void setSeed(int nodeID, bool reverse, size_t seqPos, size_t matchLen, size_t nodeOffset)
 	{
@@ -2,13 +2,14 @@
 #define ThreadReadAssertion_h
 
 #include <string>
+#include <string_view>
 
 namespace ThreadReadAssertion
 {
 	class AssertionFailure
 	{
 	};
-	void setRead(const std::string& readName);
+	void setRead(std::string_view readName);
 	void setSeed(int nodeID, bool reverse, size_t seqPos, size_t matchLen, size_t nodeOffset);
 	void assertFailed(const char* expression, const char* file, int line);
 	void signal(int signal);
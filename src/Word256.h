@@ -0,0 +1,147 @@
+#ifndef Word256_h
+#define Word256_h
+
+#include <cstdint>
+#include <type_traits>
+
+//256-bit unsigned integer for the bit-parallel DP, four 64-bit lanes with lane 0 as the least significant
+//bitwise operations are lane-wise so the compiler can keep them in AVX2 registers,
+//addition and shifts carry between the lanes
+class alignas(32) Word256
+{
+public:
+	Word256() = default;
+	constexpr Word256(uint64_t value) :
+	lanes { value, 0, 0, 0 }
+	{}
+	constexpr Word256(uint64_t lane0, uint64_t lane1, uint64_t lane2, uint64_t lane3) :
+	lanes { lane0, lane1, lane2, lane3 }
+	{}
+	explicit constexpr operator bool() const
+	{
+		return (lanes[0] | lanes[1] | lanes[2] | lanes[3]) != 0;
+	}
+	//truncating conversion like the builtin integer types
+	template <typename T, typename = typename std::enable_if<std::is_integral<T>::value>::type>
+	explicit constexpr operator T() const
+	{
+		return (T)lanes[0];
+	}
+	friend constexpr Word256 operator&(const Word256& left, const Word256& right)
+	{
+		return Word256 { left.lanes[0] & right.lanes[0], left.lanes[1] & right.lanes[1], left.lanes[2] & right.lanes[2], left.lanes[3] & right.lanes[3] };
+	}
+	friend constexpr Word256 operator|(const Word256& left, const Word256& right)
+	{
+		return Word256 { left.lanes[0] | right.lanes[0], left.lanes[1] | right.lanes[1], left.lanes[2] | right.lanes[2], left.lanes[3] | right.lanes[3] };
+	}
+	friend constexpr Word256 operator^(const Word256& left, const Word256& right)
+	{
+		return Word256 { left.lanes[0] ^ right.lanes[0], left.lanes[1] ^ right.lanes[1], left.lanes[2] ^ right.lanes[2], left.lanes[3] ^ right.lanes[3] };
+	}
+	constexpr Word256 operator~() const
+	{
+		return Word256 { ~lanes[0], ~lanes[1], ~lanes[2], ~lanes[3] };
+	}
+	friend Word256 operator+(const Word256& left, const Word256& right)
+	{
+		return addWithCarry(left, right, 0);
+	}
+	friend Word256 operator-(const Word256& left, const Word256& right)
+	{
+		//two's complement: a - b = a + ~b + 1
+		return addWithCarry(left, ~right, 1);
+	}
+	Word256 operator-() const
+	{
+		return addWithCarry(~*this, Word256 { 0 }, 1);
+	}
+	friend Word256 operator<<(const Word256& value, int shift)
+	{
+		Word256 result { 0 };
+		if (shift >= 256) return result;
+		int laneShift = shift / 64;
+		int bitShift = shift % 64;
+		for (int i = 3; i >= laneShift; i--)
+		{
+			result.lanes[i] = value.lanes[i - laneShift] << bitShift;
+			if (bitShift > 0 && i - laneShift > 0) result.lanes[i] |= value.lanes[i - laneShift - 1] >> (64 - bitShift);
+		}
+		return result;
+	}
+	friend Word256 operator>>(const Word256& value, int shift)
+	{
+		Word256 result { 0 };
+		if (shift >= 256) return result;
+		int laneShift = shift / 64;
+		int bitShift = shift % 64;
+		for (int i = 0; i + laneShift < 4; i++)
+		{
+			result.lanes[i] = value.lanes[i + laneShift] >> bitShift;
+			if (bitShift > 0 && i + laneShift < 3) result.lanes[i] |= value.lanes[i + laneShift + 1] << (64 - bitShift);
+		}
+		return result;
+	}
+	friend constexpr bool operator==(const Word256& left, const Word256& right)
+	{
+		return ((left.lanes[0] ^ right.lanes[0]) | (left.lanes[1] ^ right.lanes[1]) | (left.lanes[2] ^ right.lanes[2]) | (left.lanes[3] ^ right.lanes[3])) == 0;
+	}
+	friend constexpr bool operator!=(const Word256& left, const Word256& right)
+	{
+		return !(left == right);
+	}
+	friend constexpr bool operator<(const Word256& left, const Word256& right)
+	{
+		if (left.lanes[3] != right.lanes[3]) return left.lanes[3] < right.lanes[3];
+		if (left.lanes[2] != right.lanes[2]) return left.lanes[2] < right.lanes[2];
+		if (left.lanes[1] != right.lanes[1]) return left.lanes[1] < right.lanes[1];
+		return left.lanes[0] < right.lanes[0];
+	}
+	friend constexpr bool operator>(const Word256& left, const Word256& right)
+	{
+		return right < left;
+	}
+	Word256& operator&=(const Word256& other)
+	{
+		return *this = *this & other;
+	}
+	Word256& operator|=(const Word256& other)
+	{
+		return *this = *this | other;
+	}
+	Word256& operator^=(const Word256& other)
+	{
+		return *this = *this ^ other;
+	}
+	Word256& operator+=(const Word256& other)
+	{
+		return *this = *this + other;
+	}
+	Word256& operator-=(const Word256& other)
+	{
+		return *this = *this - other;
+	}
+	Word256& operator<<=(int shift)
+	{
+		return *this = *this << shift;
+	}
+	Word256& operator>>=(int shift)
+	{
+		return *this = *this >> shift;
+	}
+	uint64_t lanes[4];
+private:
+	static Word256 addWithCarry(const Word256& left, const Word256& right, uint64_t carry)
+	{
+		Word256 result;
+		for (int i = 0; i < 4; i++)
+		{
+			__uint128_t sum = (__uint128_t)left.lanes[i] + right.lanes[i] + carry;
+			result.lanes[i] = (uint64_t)sum;
+			carry = (uint64_t)(sum >> 64);
+		}
+		return result;
+	}
+};
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef WordSlice_h
 #define WordSlice_h
 
+#include "Word256.h"
+
 template <typename Word>
 class WordConfiguration
 {
@@ -17,6 +19,8 @@ public:
 	static constexpr uint64_t AllZeros = 0x0000000000000000;
 	static constexpr uint64_t AllOnes = 0xFFFFFFFFFFFFFFFF;
 	static constexpr uint64_t LastBit = 0x8000000000000000;
+	//every second bit starting from bit 1
+	static constexpr uint64_t OddBits = 0xAAAAAAAAAAAAAAAA;
 	//positions of the sign bits for each chunk
 	static constexpr uint64_t SignMask = 0x8080808080808080;
 	//constant for multiplying the chunk popcounts into prefix sums
@@ -143,6 +147,100 @@ public:
 	}
 };
 
+//two 64-bit words, operations are done on the halves with the 64-bit configuration
+template <>
+class WordConfiguration<__uint128_t>
+{
+	using Half = WordConfiguration<uint64_t>;
+public:
+	static constexpr int WordSize = 128;
+	static constexpr int ChunkBits = 8;
+	static constexpr __uint128_t AllZeros = 0;
+	static constexpr __uint128_t AllOnes = ~(__uint128_t)0;
+	static constexpr __uint128_t LastBit = (__uint128_t)1 << 127;
+	static constexpr __uint128_t OddBits = ((__uint128_t)Half::OddBits << 64) | Half::OddBits;
+	static constexpr __uint128_t SignMask = ((__uint128_t)Half::SignMask << 64) | Half::SignMask;
+	static constexpr __uint128_t PrefixSumMultiplierConstant = ((__uint128_t)Half::PrefixSumMultiplierConstant << 64) | Half::PrefixSumMultiplierConstant;
+	static constexpr __uint128_t LSBMask = ((__uint128_t)Half::LSBMask << 64) | Half::LSBMask;
+
+	static int popcount(__uint128_t x)
+	{
+		return Half::popcount((uint64_t)x) + Half::popcount((uint64_t)(x >> 64));
+	}
+
+	static __uint128_t ChunkPopcounts(__uint128_t value)
+	{
+		return ((__uint128_t)Half::ChunkPopcounts((uint64_t)(value >> 64)) << 64) | Half::ChunkPopcounts((uint64_t)value);
+	}
+
+	static int BitPosition(__uint128_t low, __uint128_t high, int rank)
+	{
+		assert(rank >= 0);
+		if (popcount(low) <= rank)
+		{
+			rank -= popcount(low);
+			return 128 + BitPosition(high, rank);
+		}
+		return BitPosition(low, rank);
+	}
+
+	static int BitPosition(__uint128_t number, int rank)
+	{
+		return Half::BitPosition((uint64_t)number, (uint64_t)(number >> 64), rank);
+	}
+};
+
+//four 64-bit lanes, see Word256.h
+template <>
+class WordConfiguration<Word256>
+{
+	using Lane = WordConfiguration<uint64_t>;
+public:
+	static constexpr int WordSize = 256;
+	static constexpr int ChunkBits = 8;
+	static constexpr Word256 AllZeros = Word256 { 0, 0, 0, 0 };
+	static constexpr Word256 AllOnes = Word256 { Lane::AllOnes, Lane::AllOnes, Lane::AllOnes, Lane::AllOnes };
+	static constexpr Word256 LastBit = Word256 { 0, 0, 0, Lane::LastBit };
+	static constexpr Word256 OddBits = Word256 { Lane::OddBits, Lane::OddBits, Lane::OddBits, Lane::OddBits };
+	static constexpr Word256 SignMask = Word256 { Lane::SignMask, Lane::SignMask, Lane::SignMask, Lane::SignMask };
+	static constexpr Word256 PrefixSumMultiplierConstant = Word256 { Lane::PrefixSumMultiplierConstant, Lane::PrefixSumMultiplierConstant, Lane::PrefixSumMultiplierConstant, Lane::PrefixSumMultiplierConstant };
+	static constexpr Word256 LSBMask = Word256 { Lane::LSBMask, Lane::LSBMask, Lane::LSBMask, Lane::LSBMask };
+
+	static int popcount(const Word256& x)
+	{
+		return Lane::popcount(x.lanes[0]) + Lane::popcount(x.lanes[1]) + Lane::popcount(x.lanes[2]) + Lane::popcount(x.lanes[3]);
+	}
+
+	static Word256 ChunkPopcounts(const Word256& value)
+	{
+		return Word256 { Lane::ChunkPopcounts(value.lanes[0]), Lane::ChunkPopcounts(value.lanes[1]), Lane::ChunkPopcounts(value.lanes[2]), Lane::ChunkPopcounts(value.lanes[3]) };
+	}
+
+	static int BitPosition(const Word256& low, const Word256& high, int rank)
+	{
+		assert(rank >= 0);
+		if (popcount(low) <= rank)
+		{
+			rank -= popcount(low);
+			return 256 + BitPosition(high, rank);
+		}
+		return BitPosition(low, rank);
+	}
+
+	static int BitPosition(const Word256& number, int rank)
+	{
+		assert(rank >= 0);
+		for (int i = 0; i < 4; i++)
+		{
+			int lanePopcount = Lane::popcount(number.lanes[i]);
+			if (rank < lanePopcount) return i * 64 + Lane::BitPosition(number.lanes[i], rank);
+			rank -= lanePopcount;
+		}
+		assert(false);
+		return 256;
+	}
+};
+
 //uncomment if there's an undefined reference with -O0. why?
 // constexpr uint64_t WordConfiguration<uint64_t>::AllZeros;
 // constexpr uint64_t WordConfiguration<uint64_t>::AllOnes;
@@ -378,7 +476,7 @@ private:
 	{
 		ScoreType scoreBeforeStart = getScoreBeforeStart();
 		//rightmost VP between any VN's, aka one cell to the left of a minimum
-		Word priorityCausedMinima = 0xAAAAAAAAAAAAAAAA & ~VP & ~VN;
+		Word priorityCausedMinima = WordConfiguration<Word>::OddBits & ~VP & ~VN;
 		priorityCausedMinima |= VN;
 		Word possibleLocalMinima = (VP & (priorityCausedMinima - VP));
 		//shift right by one to get the minimum
@@ -407,7 +505,7 @@ private:
 		possibleLocalMinima >>= 1;
 		//leftmost bit might be a minimum if there is no VP to its right
 		possibleLocalMinima |= WordConfiguration<Word>::LastBit & (VN | ~(VN - VP)) & ~VP;
-		ScoreType result = scoreBeforeStart + (VP & 1) - (VN & 1);
+		ScoreType result = scoreBeforeStart + (ScoreType)(VP & 1) - (ScoreType)(VN & 1);
 		//the score is inited to the first cell at the start
 		possibleLocalMinima &= ~((Word)1);
 		while (possibleLocalMinima != 0)
@@ -491,7 +589,6 @@ private:
 	static WordSlice mergeTwoSlices(WordSlice left, WordSlice right)
 	{
 		//O(log w), because prefix sums need log w chunks of log w bits
-		static_assert(std::is_same<Word, uint64_t>::value);
 		if (left.getScoreBeforeStart() > right.getScoreBeforeStart()) std::swap(left, right);
 		assert((left.VP & left.VN) == WordConfiguration<Word>::AllZeros);
 		assert((right.VP & right.VN) == WordConfiguration<Word>::AllZeros);
@@ -510,8 +607,8 @@ private:
 		assert((right.VP & right.VN) == WordConfiguration<Word>::AllZeros);
 		assert((leftSmaller & rightSmaller) == 0);
 		auto mask = (rightSmaller | ((leftSmaller | rightSmaller) - (rightSmaller << 1))) & ~leftSmaller;
-		uint64_t leftReduction = leftSmaller & (rightSmaller << 1);
-		uint64_t rightReduction = rightSmaller & (leftSmaller << 1);
+		Word leftReduction = leftSmaller & (rightSmaller << 1);
+		Word rightReduction = rightSmaller & (leftSmaller << 1);
 		if ((rightSmaller & 1) && left.getScoreBeforeStart() < right.getScoreBeforeStart())
 		{
 			rightReduction |= 1;
@@ -532,13 +629,17 @@ private:
 #ifdef NDEBUG
 	__attribute__((always_inline))
 #endif
-	static std::pair<uint64_t, uint64_t> differenceMasks(uint64_t leftVP, uint64_t leftVN, uint64_t rightVP, uint64_t rightVN, int scoreDifference)
+	static std::pair<Word, Word> differenceMasks(Word leftVP, Word leftVN, Word rightVP, Word rightVN, int scoreDifference)
 	{
 		auto result = differenceMasksBitTwiddle(leftVP, leftVN, rightVP, rightVN, scoreDifference);
 #ifdef EXTRACORRECTNESSASSERTIONS
-		auto debugCompare = differenceMasksWord(leftVP, leftVN, rightVP, rightVN, scoreDifference);
-		assert(result.first == debugCompare.first);
-		assert(result.second == debugCompare.second);
+		//the chunked prefix sum version only exists for 64-bit words
+		if constexpr (std::is_same<Word, uint64_t>::value)
+		{
+			auto debugCompare = differenceMasksWord(leftVP, leftVN, rightVP, rightVN, scoreDifference);
+			assert(result.first == debugCompare.first);
+			assert(result.second == debugCompare.second);
+		}
 #endif
 		return result;
 	}
@@ -1,7 +1,281 @@
 #include <algorithm>
+#include <cassert>
+#include <cstring>
 #include <fstream>
 #include "fastqloader.h"
 #include "CommonUtils.h"
+#include "InputChunkSource.h"
+
+//spill buffers are allocated in blocks of this size and shared by many records
+const size_t SpillBufferSize = 1024 * 1024;
+
+//splits the decompressed chunks into lines with memchr
+//lines are returned as pointers into the chunk and only lines crossing a chunk boundary are copied
+class LineSplitter
+{
+public:
+	LineSplitter(InputChunkSource& source) :
+	source(source),
+	chunk(std::make_shared<std::string>()),
+	pos(0),
+	carry(),
+	finished(false)
+	{
+	}
+	//lineChunk is the chunk the line points into, or null if the line is a temporary copy valid until the next call
+	//carriage returns at the end are removed
+	bool nextLine(std::string_view& line, std::shared_ptr<const std::string>& lineChunk)
+	{
+		carry.clear();
+		while (true)
+		{
+			if (pos < chunk->size())
+			{
+				const char* start = chunk->data() + pos;
+				const char* end = (const char*)memchr(start, '\n', chunk->size() - pos);
+				if (end != nullptr)
+				{
+					pos = end - chunk->data() + 1;
+					if (carry.size() == 0)
+					{
+						line = trimmed(start, end - start);
+						lineChunk = chunk;
+					}
+					else
+					{
+						carry.append(start, end - start);
+						line = trimmed(carry.data(), carry.size());
+						lineChunk = nullptr;
+					}
+					return true;
+				}
+				carry.append(start, chunk->size() - pos);
+			}
+			pos = 0;
+			//records still point into the old chunk so it is not reused
+			chunk = std::make_shared<std::string>();
+			if (finished || !source.next(*chunk))
+			{
+				finished = true;
+				//last line without a newline
+				if (carry.size() == 0) return false;
+				line = trimmed(carry.data(), carry.size());
+				lineChunk = nullptr;
+				return true;
+			}
+		}
+	}
+private:
+	std::string_view trimmed(const char* start, size_t size)
+	{
+		if (size > 0 && start[size-1] == '\r') size -= 1;
+		return std::string_view { start, size };
+	}
+	InputChunkSource& source;
+	std::shared_ptr<std::string> chunk;
+	size_t pos;
+	std::string carry;
+	bool finished;
+};
+
+//builds the fields of one record
+//if the whole record is within one chunk the fields point into it, otherwise they are copied to a shared spill buffer
+//fields must be added in order and a field can be extended only while it is the last one
+class RecordAssembler
+{
+public:
+	static const size_t NumFields = 3;
+	RecordAssembler() :
+	spill(),
+	staging()
+	{
+		start();
+	}
+	void start()
+	{
+		chunk = nullptr;
+		staged = false;
+		staging.clear();
+		for (size_t i = 0; i < NumFields; i++)
+		{
+			views[i] = std::string_view {};
+			fieldSet[i] = false;
+			starts[i] = 0;
+			lengths[i] = 0;
+		}
+	}
+	void append(size_t field, std::string_view line, const std::shared_ptr<const std::string>& lineChunk)
+	{
+		assert(field < NumFields);
+		if (!staged)
+		{
+			if (lineChunk != nullptr && !fieldSet[field] && (chunk == nullptr || chunk == lineChunk))
+			{
+				chunk = lineChunk;
+				views[field] = line;
+				fieldSet[field] = true;
+				return;
+			}
+			stage();
+		}
+		if (!fieldSet[field])
+		{
+			starts[field] = staging.size();
+			fieldSet[field] = true;
+		}
+		assert(starts[field] + lengths[field] == staging.size());
+		staging.append(line.data(), line.size());
+		lengths[field] += line.size();
+	}
+	void finish(FastQView& result)
+	{
+		if (!staged)
+		{
+			result.seq_id = views[0];
+			result.sequence = views[1];
+			result.quality = views[2];
+			result.buffer = chunk;
+			chunk = nullptr;
+			return;
+		}
+		//the spill buffer never reallocates so earlier records stay valid
+		if (spill == nullptr || spill->capacity() - spill->size() < staging.size())
+		{
+			spill = std::make_shared<std::string>();
+			spill->reserve(std::max(SpillBufferSize, staging.size()));
+		}
+		const char* base = spill->data() + spill->size();
+		spill->append(staging);
+		result.seq_id = std::string_view { base + starts[0], lengths[0] };
+		result.sequence = std::string_view { base + starts[1], lengths[1] };
+		result.quality = std::string_view { base + starts[2], lengths[2] };
+		result.buffer = spill;
+	}
+private:
+	void stage()
+	{
+		for (size_t i = 0; i < NumFields; i++)
+		{
+			if (!fieldSet[i]) continue;
+			starts[i] = staging.size();
+			lengths[i] = views[i].size();
+			staging.append(views[i].data(), views[i].size());
+		}
+		chunk = nullptr;
+		staged = true;
+	}
+	std::shared_ptr<std::string> spill;
+	std::string staging;
+	std::shared_ptr<const std::string> chunk;
+	bool staged;
+	std::string_view views[NumFields];
+	bool fieldSet[NumFields];
+	size_t starts[NumFields];
+	size_t lengths[NumFields];
+};
+
+void parseFastq(LineSplitter& lines, bool includeQuality, const std::function<void(FastQView&)>& f)
+{
+	RecordAssembler record;
+	FastQView read;
+	std::string_view line;
+	std::shared_ptr<const std::string> lineChunk;
+	while (lines.nextLine(line, lineChunk))
+	{
+		if (line.size() == 0 || line[0] != '@') continue;
+		record.start();
+		record.append(0, line.substr(1), lineChunk);
+		if (!lines.nextLine(line, lineChunk)) break;
+		record.append(1, line, lineChunk);
+		//separator
+		if (!lines.nextLine(line, lineChunk)) break;
+		if (!lines.nextLine(line, lineChunk)) break;
+		if (includeQuality) record.append(2, line, lineChunk);
+		record.finish(read);
+		f(read);
+	}
+}
+
+void parseFasta(LineSplitter& lines, const std::function<void(FastQView&)>& f)
+{
+	RecordAssembler record;
+	FastQView read;
+	bool hasRead = false;
+	std::string_view line;
+	std::shared_ptr<const std::string> lineChunk;
+	while (lines.nextLine(line, lineChunk))
+	{
+		if (line.size() == 0) continue;
+		if (line[0] == '>')
+		{
+			if (hasRead)
+			{
+				record.finish(read);
+				f(read);
+			}
+			record.start();
+			record.append(0, line.substr(1), lineChunk);
+			hasRead = true;
+			continue;
+		}
+		if (hasRead) record.append(1, line, lineChunk);
+	}
+	if (hasRead)
+	{
+		record.finish(read);
+		f(read);
+	}
+}
+
+bool endsWith(const std::string& str, const std::string& suffix)
+{
+	return str.size() > suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+bool isFastaFile(const std::string& filename)
+{
+	std::string uncompressedName = filename;
+	if (endsWith(uncompressedName, ".gz")) uncompressedName = uncompressedName.substr(0, uncompressedName.size()-3);
+	return endsWith(uncompressedName, ".fasta") || endsWith(uncompressedName, ".fa");
+}
+
+bool isFastqFile(const std::string& filename)
+{
+	std::string uncompressedName = filename;
+	if (endsWith(uncompressedName, ".gz")) uncompressedName = uncompressedName.substr(0, uncompressedName.size()-3);
+	return endsWith(uncompressedName, ".fastq") || endsWith(uncompressedName, ".fq");
+}
+
+void FastQView::streamFromFile(const std::string& filename, bool includeQuality, std::function<void(FastQView&)> f, size_t decompressionThreads)
+{
+	bool fastq = isFastqFile(filename);
+	bool fasta = isFastaFile(filename);
+	if (!fastq && !fasta) return;
+	//compression is detected from the file contents
+	auto source = InputChunkSource::Open(filename, decompressionThreads);
+	LineSplitter lines { *source };
+	if (fasta) parseFasta(lines, f); else parseFastq(lines, includeQuality, f);
+}
+
+void FastQ::streamFastqFromFile(const std::string& filename, bool includeQuality, std::function<void(FastQ&)> f, size_t decompressionThreads)
+{
+	bool fasta = isFastaFile(filename);
+	FastQ read;
+	FastQView::streamFromFile(filename, includeQuality, [&read, &f, fasta, includeQuality](FastQView& view)
+	{
+		read.seq_id.assign(view.seq_id.data(), view.seq_id.size());
+		read.sequence.assign(view.sequence.data(), view.sequence.size());
+		if (fasta && includeQuality)
+		{
+			read.quality.assign(read.sequence.size(), '!');
+		}
+		else
+		{
+			read.quality.assign(view.quality.data(), view.quality.size());
+		}
+		f(read);
+	}, decompressionThreads);
+}
 
 std::vector<FastQ> loadFastqFromFile(std::string filename, bool includeQuality)
 {